@@ -35,11 +35,34 @@
 
 /* ──────────── Геометрия страницы ──────────── */
 
-/** Размер физической страницы (байт). Все аллокации кратны этому значению. */
+/**
+ * Размер страницы по умолчанию (байт). Также единица размера slab
+ * (ALLOC_SLAB_PAGES) и карантинного бюджета.
+ */
 #ifndef ALLOC_PAGE_SIZE
 #define ALLOC_PAGE_SIZE 1024U
 #endif
 
+/**
+ * Размеры страниц по зонам в порядке HeapRegion_t (степени двойки),
+ * например -D'ALLOC_ZONE_PAGE_SIZES={256U, 4096U}'. Не заданные — ALLOC_PAGE_SIZE.
+ * Все аллокации зоны кратны её странице.
+ */
+#ifndef ALLOC_ZONE_PAGE_SIZES
+#define ALLOC_ZONE_PAGE_SIZES { ALLOC_PAGE_SIZE }
+#endif
+
+/**
+ * Политики зон в порядке HeapRegion_t — ALLOC_ZONE_POLICY(уровень, флаги):
+ * отладочная зона с полными проверками рядом с быстрой без них, например
+ * -D'ALLOC_ZONE_POLICIES={ALLOC_ZONE_POLICY(3, 0U), ALLOC_ZONE_POLICY(0,
+ * ALLOC_ZONE_NO_FILL | ALLOC_ZONE_NO_CLEAR)}' при ALLOC_QUARANTINE_CHECK_LEVEL 3.
+ * Макросы задают, что собрано, и потолок: политика может только отключать.
+ */
+#ifndef ALLOC_ZONE_POLICIES
+#define ALLOC_ZONE_POLICIES { { 0U, 0U } }
+#endif
+
 /** Размер хедера области (байт). */
 #ifndef ALLOC_HEADER_SIZE
 #define ALLOC_HEADER_SIZE 32U
@@ -57,16 +80,27 @@
 #define ALLOC_MAX_ZONES 2U
 #endif
 
-/** Максимальное число страниц на одну зону (10 МиБ / 1024). */
-#ifndef ALLOC_MAX_PAGES_PER_ZONE
-#define ALLOC_MAX_PAGES_PER_ZONE 10240U
-#endif
-
-/** Размер таблицы карантина (записей о последних освобождениях). */
+/**
+ * Размер таблицы карантина (записей о последних освобождениях).
+ * Добавление и вытеснение — O(1), поиск по адресу — O(log n).
+ */
 #ifndef ALLOC_QUARANTINE_CAPACITY
 #define ALLOC_QUARANTINE_CAPACITY 32U
 #endif
 
+/**
+ * Предел объёма карантина на зону (байт, округляется вниз до страницы зоны).
+ * При превышении вытесняются самые старые записи. 0 — без предела.
+ */
+#ifndef ALLOC_QUARANTINE_MAX_BYTES
+#define ALLOC_QUARANTINE_MAX_BYTES 0U
+#endif
+
+/** Ёмкость индекса свободных участков (узлов на зону). */
+#ifndef ALLOC_FREE_EXTENT_CAPACITY
+#define ALLOC_FREE_EXTENT_CAPACITY 128U
+#endif
+
 /* ──────────── Паттерны ──────────── */
 
 /** Магическое число хедера. */
@@ -79,6 +113,11 @@
 #define ALLOC_PATTERN_FOOTER_MAGIC 0x464F4F54U  /* "FOOT" */
 #endif
 
+/** Магическое число маркера начала выровненной области. */
+#ifndef ALLOC_PATTERN_LEAD_MAGIC
+#define ALLOC_PATTERN_LEAD_MAGIC 0x4C454144U  /* "LEAD" */
+#endif
+
 /** Байт-паттерн заполнения паддинга. */
 #ifndef ALLOC_PATTERN_PADDING
 #define ALLOC_PATTERN_PADDING 0xFEU
@@ -94,8 +133,36 @@
 #define ALLOC_PATTERN_CLEARED_PAGE 0x00U
 #endif
 
+/** Магическое число дескриптора slab. */
+#ifndef ALLOC_PATTERN_SLAB_MAGIC
+#define ALLOC_PATTERN_SLAB_MAGIC 0x534C4142U  /* "SLAB" */
+#endif
+
+/** Магия guard-а объекта slab (входит в контрольную сумму guard-а). */
+#ifndef ALLOC_PATTERN_SLAB_GUARD
+#define ALLOC_PATTERN_SLAB_GUARD 0x5AB0U
+#endif
+
+/**
+ * Векторная проверка паттернов (SSE2 / NEON), если доступна.
+ * Иначе — пословная проверка с выравниванием головы и хвоста.
+ */
+#ifndef ALLOC_PATTERN_SIMD
+#define ALLOC_PATTERN_SIMD 1
+#endif
+
 /* ──────────── Функциональность ──────────── */
 
+/** Политики поиска свободного участка. */
+#define ALLOC_FIT_FIRST 0   /**< First-fit по битовой карте */
+#define ALLOC_FIT_GOOD  1   /**< Сегрегированные списки: первый из достаточного класса */
+#define ALLOC_FIT_BEST  2   /**< Сегрегированные списки: наименьший подходящий */
+
+/** Политика выбора участка для аллокации. */
+#ifndef ALLOC_FIT_POLICY
+#define ALLOC_FIT_POLICY ALLOC_FIT_FIRST
+#endif
+
 /** Заполнять payload карантинным паттерном при free. */
 #ifndef ALLOC_FILL_ON_FREE
 #define ALLOC_FILL_ON_FREE 1
@@ -106,6 +173,23 @@
 #define ALLOC_ENABLE_CLEAR_ON_EVICT 1
 #endif
 
+/**
+ * Карта заведомо нулевых свободных страниц (третья битовая карта в
+ * конце зоны): calloc обнуляет только страницы, не очищенные раньше.
+ */
+#ifndef ALLOC_ENABLE_ZERO_TRACKING
+#define ALLOC_ENABLE_ZERO_TRACKING 0
+#endif
+
+/**
+ * Ленивая очистка (при ALLOC_ENABLE_ZERO_TRACKING): вытесненные страницы
+ * не обнуляются, это сделает calloc, которому они достанутся. Только в
+ * зонах с заливкой при free — прежние данные там уже затёрты паттерном.
+ */
+#ifndef ALLOC_LAZY_CLEAR_ON_EVICT
+#define ALLOC_LAZY_CLEAR_ON_EVICT 0
+#endif
+
 /**
  * Уровень проверки карантина при каждой alloc/free.
  *   0 — отключено
@@ -117,11 +201,72 @@
 #define ALLOC_QUARANTINE_CHECK_LEVEL 1
 #endif
 
+/**
+ * Если свободного участка нет, вытеснять карантин с самых старых записей
+ * и повторять поиск вместо возврата nullptr.
+ */
+#ifndef ALLOC_QUARANTINE_EVICT_ON_PRESSURE
+#define ALLOC_QUARANTINE_EVICT_ON_PRESSURE 0
+#endif
+
 /** Проверять хедеры и футеры ВСЕХ аллоцированных областей при alloc/free. */
 #ifndef ALLOC_CHECK_ALL_ALLOCATED
 #define ALLOC_CHECK_ALL_ALLOCATED 0
 #endif
 
+/**
+ * Инкрементальные проверки: вместо полного обхода при каждой alloc/free
+ * проверяется ограниченная порция карантина и областей с вращающимся
+ * курсором. Полный цикл — за capacity/ALLOC_CHECK_QUARANTINE_BUDGET
+ * и pages/ALLOC_CHECK_PAGE_BUDGET операций (или вызовов heapIdleCheck).
+ */
+#ifndef ALLOC_CHECK_INCREMENTAL
+#define ALLOC_CHECK_INCREMENTAL 0
+#endif
+
+/** Записей карантина на одну операцию (инкрементальный режим). */
+#ifndef ALLOC_CHECK_QUARANTINE_BUDGET
+#define ALLOC_CHECK_QUARANTINE_BUDGET 4U
+#endif
+
+/** Шагов обхода областей на одну операцию (область или страница). */
+#ifndef ALLOC_CHECK_PAGE_BUDGET
+#define ALLOC_CHECK_PAGE_BUDGET 16U
+#endif
+
+/** Множитель бюджета для вызова из idle-задачи. */
+#ifndef ALLOC_CHECK_IDLE_FACTOR
+#define ALLOC_CHECK_IDLE_FACTOR 8U
+#endif
+
+/**
+ * Быстрое освобождение страничных областей: проверяется только хедер
+ * (контрольная сумма, зона, битовая карта). Футер проверяет
+ * инкрементальный обход карантина, полные проверки на free не
+ * выполняются. Требует ALLOC_CHECK_INCREMENTAL.
+ */
+#ifndef ALLOC_FAST_FREE
+#define ALLOC_FAST_FREE 0
+#endif
+
+/**
+ * Передавать крупные заливки (карантинный паттерн, очистка при вытеснении)
+ * порту FillEngine (DMA/MDMA). Страницы остаются занятыми до завершения.
+ */
+#ifndef ALLOC_ENABLE_ASYNC_FILL
+#define ALLOC_ENABLE_ASYNC_FILL 0
+#endif
+
+/** Минимальный размер заливки для FillEngine (байт). */
+#ifndef ALLOC_ASYNC_FILL_THRESHOLD
+#define ALLOC_ASYNC_FILL_THRESHOLD 16384U
+#endif
+
+/** Число одновременно незавершённых заливок на зону. */
+#ifndef ALLOC_ASYNC_FILL_SLOTS
+#define ALLOC_ASYNC_FILL_SLOTS 4U
+#endif
+
 /** Защита карантинных страниц через MPU. */
 #ifndef ALLOC_ENABLE_MPU_PROTECTION
 #define ALLOC_ENABLE_MPU_PROTECTION 0
@@ -136,3 +281,230 @@
 #ifndef ALLOC_MPU_REGION_COUNT
 #define ALLOC_MPU_REGION_COUNT 2
 #endif
+
+/* ──────────── Зоны ──────────── */
+
+/**
+ * Индекс thread-local storage FreeRTOS для зоны по умолчанию задачи
+ * (heapZoneSetTask). Зона задачи важнее глобальной heapZoneSet.
+ * -1 — отключено (на хосте — thread_local).
+ */
+#ifndef ALLOC_ZONE_TLS_INDEX
+#define ALLOC_ZONE_TLS_INDEX -1
+#endif
+
+/* ──────────── Slab (мелкие объекты) ──────────── */
+
+/** Обслуживать мелкие запросы из slab-ов вместо целых страниц. */
+#ifndef ALLOC_ENABLE_SLAB
+#define ALLOC_ENABLE_SLAB 1
+#endif
+
+/** Размер наименьшего класса slab (байт, степень двойки ≥ 8). */
+#ifndef ALLOC_SLAB_MIN_CLASS_SIZE
+#define ALLOC_SLAB_MIN_CLASS_SIZE 16U
+#endif
+
+/**
+ * Число классов slab (каждый следующий вдвое больше).
+ * По умолчанию: 16, 32, 64, 128, 256 байт.
+ */
+#ifndef ALLOC_SLAB_CLASS_COUNT
+#define ALLOC_SLAB_CLASS_COUNT 5U
+#endif
+
+/** Число страниц в одном slab. */
+#ifndef ALLOC_SLAB_PAGES
+#define ALLOC_SLAB_PAGES 1U
+#endif
+
+/* ──────────── Магазины (кэши без блокировки) ──────────── */
+
+/**
+ * Кэшировать освобождённые объекты slab в магазинах ядра/задачи.
+ * Попадание в магазин не приостанавливает планировщик; пополнение и
+ * слив выполняются пачками под блокировкой зоны.
+ */
+#ifndef ALLOC_ENABLE_MAGAZINES
+#define ALLOC_ENABLE_MAGAZINES 0
+#endif
+
+/** Число ядер (магазинов уровня ядра). SMP: = configNUMBER_OF_CORES. */
+#ifndef ALLOC_MAGAZINE_CORES
+#define ALLOC_MAGAZINE_CORES 1U
+#endif
+
+/** Ёмкость одного магазина (объектов на зону и класс). */
+#ifndef ALLOC_MAGAZINE_SIZE
+#define ALLOC_MAGAZINE_SIZE 16U
+#endif
+
+/** Размер пачки при пополнении/сливе магазина. */
+#ifndef ALLOC_MAGAZINE_BATCH
+#define ALLOC_MAGAZINE_BATCH 8U
+#endif
+
+/**
+ * Индекс thread-local storage FreeRTOS для магазинов уровня задачи
+ * (opt-in через heapMagazineAttachTask). -1 — отключено.
+ */
+#ifndef ALLOC_MAGAZINE_TLS_INDEX
+#define ALLOC_MAGAZINE_TLS_INDEX -1
+#endif
+
+/* ──────────── Отложенное освобождение ──────────── */
+
+/**
+ * vPortFree только ставит указатель в lock-free очередь; проверки и
+ * карантин выполняет служебная задача пачками. Разрешает free из ISR.
+ */
+#ifndef ALLOC_ENABLE_DEFERRED_FREE
+#define ALLOC_ENABLE_DEFERRED_FREE 0
+#endif
+
+/** Ёмкость очереди отложенных free (степень двойки). */
+#ifndef ALLOC_DEFERRED_FREE_CAPACITY
+#define ALLOC_DEFERRED_FREE_CAPACITY 64U
+#endif
+
+/** Указателей за один проход служебной задачи. */
+#ifndef ALLOC_DEFERRED_FREE_BATCH
+#define ALLOC_DEFERRED_FREE_BATCH 16U
+#endif
+
+/** Приоритет служебной задачи. */
+#ifndef ALLOC_DEFERRED_FREE_PRIORITY
+#define ALLOC_DEFERRED_FREE_PRIORITY 1U
+#endif
+
+/** Стек служебной задачи (слов). */
+#ifndef ALLOC_DEFERRED_FREE_STACK
+#define ALLOC_DEFERRED_FREE_STACK 256U
+#endif
+
+/* ──────────── Учёт по задачам ──────────── */
+
+/**
+ * Владелец (TaskHandle_t) в хедере страничной области и счётчики байт/областей
+ * по задачам (heapTaskGetStats, heapTaskWalkBlocks). Объекты slab не
+ * учитываются по задачам: их страницы числятся служебными.
+ */
+#ifndef ALLOC_ENABLE_TASK_STATS
+#define ALLOC_ENABLE_TASK_STATS 0
+#endif
+
+/**
+ * Слотов счётчиков задач на зону (степень двойки). Слот закрепляется
+ * за задачей навсегда; задачи сверх ёмкости учитываются вместе.
+ */
+#ifndef ALLOC_TASK_STATS_SLOTS
+#define ALLOC_TASK_STATS_SLOTS 16U
+#endif
+
+/** Адрес вызова pvPortMalloc и др. в футере области (дополнительный лок зоны на вызов). */
+#ifndef ALLOC_TRACK_CALLER_PC
+#define ALLOC_TRACK_CALLER_PC 0
+#endif
+
+/* ──────────── Замер задержек ──────────── */
+
+/**
+ * Замер задержек alloc/free, поиска участка, проверок и вытеснения:
+ * лог-гистограммы и максимумы по зонам (getHeapLatencyStats).
+ * Такты DWT->CYCCNT на таргете, наносекунды steady_clock на хосте.
+ * 0 — замеры не компилируются.
+ */
+#ifndef ALLOC_ENABLE_LATENCY_STATS
+#define ALLOC_ENABLE_LATENCY_STATS 0
+#endif
+
+/** Корзин гистограммы: корзина b — [2^b, 2^(b+1)) тиков, последняя — всё выше. */
+#ifndef ALLOC_LATENCY_BUCKETS
+#define ALLOC_LATENCY_BUCKETS 24U
+#endif
+
+/* ──────────── Трассировка ──────────── */
+
+/**
+ * Двоичная трасса alloc/free/realloc: записи HeapTraceRecord_t (32 байта)
+ * в lock-free кольцо, которое забирает heapTraceRead (RTT/ITM/UART DMA).
+ * Трасса воспроизводится на хосте (bench/TraceReplay.cpp).
+ * 0 — трассировка не компилируется.
+ */
+#ifndef ALLOC_ENABLE_TRACE
+#define ALLOC_ENABLE_TRACE 0
+#endif
+
+/** Записей в кольце трассы (степень двойки). При переполнении записи теряются. */
+#ifndef ALLOC_TRACE_CAPACITY
+#define ALLOC_TRACE_CAPACITY 256U
+#endif
+
+/* ──────────── Перемещаемые области ──────────── */
+
+/**
+ * Области по хендлам (heapHandleAlloc / Lock / Unlock): незакреплённые
+ * страничные области уплотнитель сдвигает к началу зоны, закрывая
+ * дыры между ними. 0 — хендлы и уплотнитель не компилируются.
+ */
+#ifndef ALLOC_ENABLE_HANDLES
+#define ALLOC_ENABLE_HANDLES 0
+#endif
+
+/** Хендлов на зону. */
+#ifndef ALLOC_HANDLE_CAPACITY
+#define ALLOC_HANDLE_CAPACITY 32U
+#endif
+
+/**
+ * Бюджет одного шага уплотнения (на зону): страниц скопировано плюс
+ * просмотрено участков. Ограничивает время шага под замком зоны.
+ */
+#ifndef ALLOC_COMPACT_STEP_PAGES
+#define ALLOC_COMPACT_STEP_PAGES 16U
+#endif
+
+/** Период служебной задачи уплотнения (мс); 0 — задача не создаётся, шаги вызывает приложение. */
+#ifndef ALLOC_COMPACT_PERIOD_MS
+#define ALLOC_COMPACT_PERIOD_MS 0U
+#endif
+
+/** Приоритет задачи уплотнения. */
+#ifndef ALLOC_COMPACT_PRIORITY
+#define ALLOC_COMPACT_PRIORITY 0U
+#endif
+
+/** Стек задачи уплотнения (слов). */
+#ifndef ALLOC_COMPACT_STACK
+#define ALLOC_COMPACT_STACK 192U
+#endif
+
+/**
+ * Миграция областей по хендлам между FAST (зона 0) и SLOW (зона 1)
+ * по частоте heapHandleLock. Требует ALLOC_ENABLE_HANDLES.
+ */
+#ifndef ALLOC_ENABLE_MIGRATION
+#define ALLOC_ENABLE_MIGRATION 0
+#endif
+
+/** heat, с которого область SLOW переносится в FAST (heat — lock-и, половина затухает за шаг). */
+#ifndef ALLOC_MIGRATE_HOT_LOCKS
+#define ALLOC_MIGRATE_HOT_LOCKS 8U
+#endif
+
+/** heat, до которого область FAST уступает место горячей. */
+#ifndef ALLOC_MIGRATE_COLD_LOCKS
+#define ALLOC_MIGRATE_COLD_LOCKS 1U
+#endif
+
+/** Байт payload, копируемых за шаг миграции (минимум — одна область). */
+#ifndef ALLOC_MIGRATE_STEP_BYTES
+#define ALLOC_MIGRATE_STEP_BYTES 16384U
+#endif
+
+/* ──────────── Арены ──────────── */
+
+/** Выравнивание объектов heapArenaAlloc (степень двойки). */
+#ifndef ALLOC_ARENA_ALIGNMENT
+#define ALLOC_ARENA_ALIGNMENT 8U
+#endif
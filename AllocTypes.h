@@ -17,19 +17,21 @@ extern "C" {
 /**
  * @brief Хедер аллоцированной области (32 байта).
  *
- * Располагается в начале первой страницы выделенной области.
+ * Располагается в начале первой страницы выделенной области; у выровненных
+ * областей — со смещением headOffset, а в начале страницы лежит
+ * AllocLeadMarker. Пользовательские данные всегда сразу за хедером.
  * Контрольная сумма покрывает все поля кроме самой себя.
  */
 typedef struct {
     uint32_t magic;           /**< ALLOC_PATTERN_HEADER_MAGIC */
     uint32_t requestedSize;   /**< Запрошенный пользователем размер (байт) */
-    uint16_t startPage;       /**< Индекс первой страницы в зоне */
-    uint16_t pageCount;       /**< Число выделенных страниц */
+    uint32_t startPage;       /**< Индекс первой страницы в зоне */
+    uint32_t pageCount;       /**< Число выделенных страниц */
     uint8_t  zoneIndex;       /**< Индекс зоны */
-    uint8_t  reserved[3];     /**< Резерв (выравнивание) */
+    uint8_t  flags;           /**< ALLOC_BLOCK_FLAG_* */
+    uint16_t headOffset;      /**< Смещение хедера от начала первой страницы */
     uint32_t sequenceNum;     /**< Порядковый номер аллокации */
-    uint32_t reserved2;       /**< Задел: TaskHandle_t */
-    uint32_t reserved3;       /**< Задел: доп. данные */
+    uint32_t ownerTask;       /**< Задача-владелец (ALLOC_ENABLE_TASK_STATS) */
     uint32_t checksum;        /**< XOR слов [0..6] */
 } AllocBlockHeader;
 
@@ -41,16 +43,35 @@ typedef struct {
 typedef struct {
     uint32_t magic;           /**< ALLOC_PATTERN_FOOTER_MAGIC */
     uint32_t requestedSize;   /**< Копия requestedSize */
-    uint16_t startPage;       /**< Копия startPage */
-    uint16_t pageCount;       /**< Копия pageCount */
+    uint32_t startPage;       /**< Копия startPage */
+    uint32_t pageCount;       /**< Копия pageCount */
     uint8_t  zoneIndex;       /**< Копия zoneIndex */
-    uint8_t  reserved[3];     /**< Резерв */
+    uint8_t  flags;           /**< Копия flags */
+    uint16_t headOffset;      /**< Копия headOffset */
     uint32_t sequenceNum;     /**< Копия sequenceNum */
-    uint32_t reserved2;       /**< Задел: TaskHandle_t */
-    uint32_t reserved3;       /**< Задел */
+    uint32_t callerPc;        /**< Адрес вызова аллокации (ALLOC_TRACK_CALLER_PC) */
     uint32_t checksum;        /**< XOR слов [0..6] */
 } AllocBlockFooter;
 
+/** Младшие биты flags: log2 запрошенного выравнивания (0 — обычная область). */
+#define ALLOC_BLOCK_FLAG_ALIGN_MASK 0x1FU
+/** Область выдана по хендлу: уплотнитель может её перемещать. */
+#define ALLOC_BLOCK_FLAG_MOVABLE    0x20U
+
+/**
+ * @brief Маркер начала выровненной области (8 байт).
+ *
+ * Пишется в начало первой страницы, если хедер смещён (headOffset > 0).
+ * Остаток до хедера заполняется паттерном паддинга.
+ */
+typedef struct {
+    uint32_t magic;           /**< ALLOC_PATTERN_LEAD_MAGIC */
+    uint16_t headOffset;      /**< Смещение хедера от начала страницы */
+    uint16_t check;           /**< ~headOffset */
+} AllocLeadMarker;
+
+ALLOC_STATIC_ASSERT(sizeof(AllocLeadMarker) == 8U, "AllocLeadMarker must be 8 bytes");
+
 ALLOC_STATIC_ASSERT(sizeof(AllocBlockHeader) == ALLOC_HEADER_SIZE,
                      "AllocBlockHeader size must equal ALLOC_HEADER_SIZE");
 ALLOC_STATIC_ASSERT(sizeof(AllocBlockFooter) == ALLOC_FOOTER_SIZE,
@@ -60,16 +81,181 @@ ALLOC_STATIC_ASSERT(sizeof(AllocBlockFooter) == ALLOC_FOOTER_SIZE,
  * @brief Запись в таблице карантина.
  */
 typedef struct {
-    uint16_t startPage;       /**< Первая страница карантинной области */
-    uint16_t pageCount;       /**< Число страниц */
+    uint32_t startPage;       /**< Первая страница карантинной области */
+    uint32_t pageCount;       /**< Число страниц */
     uint32_t requestedSize;   /**< Размер пользовательских данных */
     uint32_t freeSequence;    /**< Порядковый номер при освобождении (FIFO) */
+    uint16_t headOffset;      /**< Смещение хедера от начала первой страницы */
     int8_t   mpuRegion;       /**< Регион MPU (-1 = не защищено) */
     uint8_t  zoneIndex;       /**< Индекс зоны */
     uint8_t  active;          /**< 1 = запись используется */
-    uint8_t  reserved;        /**< Выравнивание */
+    uint8_t  fillPending;     /**< 1 = payload ещё заливается FillEngine */
 } AllocQuarantineEntry;
 
+/** Состояния объекта slab. */
+#define ALLOC_SLAB_STATE_FREE   0x0FU
+#define ALLOC_SLAB_STATE_USED   0xA1U
+#define ALLOC_SLAB_STATE_CACHED 0x5CU   /**< Освобождён в магазин, в slab не возвращён */
+
+/**
+ * @brief Guard объекта slab (8 байт).
+ *
+ * Располагается непосредственно перед пользовательскими данными объекта.
+ * Облегчённая замена пары хедер/футер для мелких объектов.
+ */
+typedef struct {
+    uint16_t slabOffset;      /**< Смещение guard-а от дескриптора slab (байт) */
+    uint16_t requestedSize;   /**< Запрошенный пользователем размер (байт) */
+    uint8_t  classIndex;      /**< Индекс класса размера */
+    uint8_t  state;           /**< ALLOC_SLAB_STATE_* */
+    uint16_t check;           /**< XOR полуслов [0..2] и ALLOC_PATTERN_SLAB_GUARD */
+} AllocSlabGuard;
+
+ALLOC_STATIC_ASSERT(sizeof(AllocSlabGuard) == 8U, "AllocSlabGuard must be 8 bytes");
+
+/**
+ * Политика зоны (ALLOC_ZONE_POLICIES): в пределах собранного макросами
+ * AllocConf.h ослабляет проверки и заливки отдельной зоны. Нулевая
+ * политика — как у макросов.
+ */
+typedef struct {
+    uint8_t checkLevel;   /**< Уровень проверки карантина + 1 (≤ ALLOC_QUARANTINE_CHECK_LEVEL); 0 — по макросу */
+    uint8_t disable;      /**< ALLOC_ZONE_NO_* */
+} AllocZonePolicy;
+
+#define ALLOC_ZONE_NO_FILL       0x01U  /**< Без карантинного паттерна (проверка карантина — не выше 1) */
+#define ALLOC_ZONE_NO_CLEAR      0x02U  /**< Без очистки страниц при вытеснении */
+#define ALLOC_ZONE_NO_MPU        0x04U  /**< Без MPU-защиты карантина */
+#define ALLOC_ZONE_NO_CHECK_ALL  0x08U  /**< Без обхода живых областей при alloc/free */
+
+/** Элемент ALLOC_ZONE_POLICIES: уровень проверки и флаги ALLOC_ZONE_NO_*. */
+#define ALLOC_ZONE_POLICY(level, flags) { (uint8_t)((level) + 1U), (uint8_t)(flags) }
+
+/** Выравнивание, гарантированное pvPortMalloc (slab-объекты и страничные области). */
+#define ALLOC_MALLOC_ALIGNMENT 8U
+
+/** Владелец вне задач: до запуска планировщика и служебные (slab) страницы. */
+#define HEAP_TASK_OWNER_NONE  0x00000000U
+/** Сводный владелец задач, не поместившихся в ALLOC_TASK_STATS_SLOTS. */
+#define HEAP_TASK_OWNER_OTHER 0xFFFFFFFEU
+/** Фильтр обхода: все владельцы. */
+#define HEAP_TASK_OWNER_ANY   0xFFFFFFFFU
+
+/** @brief Счётчики живых страничных областей одной задачи. */
+typedef struct {
+    uint32_t ownerTask;       /**< TaskHandle_t или HEAP_TASK_OWNER_* */
+    uint32_t blocks;          /**< Число областей */
+    size_t   bytes;           /**< Занято страниц (байт) */
+} HeapTaskStats_t;
+
+/** @brief Живая страничная область (для heapTaskWalkBlocks). */
+typedef struct {
+    void*    ptr;             /**< Пользовательский указатель */
+    size_t   requestedSize;   /**< Запрошенный размер */
+    size_t   bytes;           /**< Занято страниц (байт) */
+    uint32_t ownerTask;       /**< Задача-владелец */
+    uint32_t callerPc;        /**< Адрес вызова (0 — не записан) */
+    uint32_t sequenceNum;     /**< Порядковый номер аллокации */
+    uint8_t  zoneIndex;       /**< Индекс зоны */
+} HeapBlockInfo_t;
+
+/** Обработчик области при обходе; вызывается под локом зоны — не должен аллоцировать. */
+typedef void (*HeapBlockVisitor_t)(const HeapBlockInfo_t* block, void* context);
+
+/**
+ * Хендл перемещаемой области (ALLOC_ENABLE_HANDLES): слот + 1 (биты 0..15),
+ * поколение слота (16..31) — устаревший хендл не совпадёт. Не зависит от
+ * зоны: при миграции хендл сохраняется.
+ */
+typedef uint32_t HeapHandle_t;
+
+/** Нет области (неудачное выделение). */
+#define HEAP_HANDLE_INVALID 0U
+
+/**
+ * Арена: одна страничная область, внутри — выделение сдвигом указателя
+ * без хедеров на объект. Принадлежит одной задаче (лок не берётся).
+ * Поля только для чтения; base == NULL — арена не создана.
+ */
+typedef struct {
+    uint8_t * base;       /**< Payload страничной области */
+    size_t    capacity;   /**< Байт в области */
+    size_t    used;       /**< Занято с начала (с выравниванием) */
+    size_t    peak;       /**< Максимум used с создания */
+} HeapArena_t;
+
+/** Операции, задержка которых замеряется (ALLOC_ENABLE_LATENCY_STATS). */
+typedef enum {
+    HEAP_LATENCY_ALLOCATE = 0,  /**< Выделение в зоне (с ожиданием лока зоны) */
+    HEAP_LATENCY_DEALLOCATE,    /**< Освобождение (с ожиданием лока зоны) */
+    HEAP_LATENCY_FIND_RUN,      /**< Поиск свободного участка */
+    HEAP_LATENCY_CHECKS,        /**< Проверки целостности перед операцией */
+    HEAP_LATENCY_EVICT,         /**< Вытеснение записи карантина */
+    HEAP_LATENCY_OP_COUNT
+} HeapLatencyOp_t;
+
+/**
+ * @brief Гистограмма задержек одной операции.
+ *
+ * Корзина b — замеры [2^b, 2^(b+1)) тиков (в корзине 0 — и нулевые),
+ * последняя корзина — все более длинные.
+ */
+typedef struct {
+    uint32_t count;                             /**< Число замеров */
+    uint32_t maxTicks;                          /**< Наибольший замер */
+    uint64_t totalTicks;                        /**< Сумма замеров */
+    uint32_t buckets[ALLOC_LATENCY_BUCKETS];
+} HeapLatencyHistogram_t;
+
+/** @brief Задержки операций одной зоны. */
+typedef struct {
+    uint32_t               ticksPerSecond;      /**< Частота счётчика тиков */
+    HeapLatencyHistogram_t ops[HEAP_LATENCY_OP_COUNT];
+} HeapLatencyStats_t;
+
+/** Вид записи трассы (ALLOC_ENABLE_TRACE). */
+typedef enum {
+    HEAP_TRACE_ZONE    = 0,  /**< Геометрия зоны: address — адрес начала, size — байт,
+                                  startPage — размер страницы, pageCount — страниц */
+    HEAP_TRACE_ALLOC   = 1,  /**< Выделение (в т.ч. итог realloc) */
+    HEAP_TRACE_FAIL    = 2,  /**< Неудачное выделение */
+    HEAP_TRACE_FREE    = 3,  /**< Освобождение (до возврата памяти) */
+    HEAP_TRACE_REALLOC = 4,  /**< Запрос realloc: address — исходная область, size — новый размер */
+    HEAP_TRACE_ALLOC_BATCH = 5,  /**< Начало пакета: size — размер элемента, pageCount — элементов
+                                      (далее столько ALLOC/FAIL с HEAP_TRACE_FLAG_BATCH) */
+    HEAP_TRACE_FREE_BATCH  = 6   /**< Начало пакета: pageCount — записей FREE с HEAP_TRACE_FLAG_BATCH */
+} HeapTraceOp_t;
+
+#define HEAP_TRACE_FLAG_ZEROED      0x01U  /**< calloc */
+#define HEAP_TRACE_FLAG_REALLOC     0x02U  /**< Итог realloc (ALLOC/FAIL после HEAP_TRACE_REALLOC) */
+#define HEAP_TRACE_FLAG_BATCH       0x04U  /**< Элемент пакетной операции */
+#define HEAP_TRACE_ALIGN_SHIFT      3U     /**< Биты 3..7 flags — log2 выравнивания (0 — обычная) */
+
+/** Зона не определена (неудачное выделение). */
+#define HEAP_TRACE_NO_ZONE          0xFFU
+
+/**
+ * @brief Запись трассы: фиксированные 32 байта, little-endian.
+ *
+ * Адрес — смещение payload от начала зоны, поэтому трасса одинакова
+ * для 32- и 64-битной сборки. pageCount == 0 — объект slab.
+ */
+typedef struct {
+    uint8_t  op;              /**< HeapTraceOp_t */
+    uint8_t  zoneIndex;       /**< Зона области (HEAP_TRACE_NO_ZONE — нет) */
+    uint8_t  route;           /**< Запрошенная HeapZone_t */
+    uint8_t  flags;           /**< HEAP_TRACE_FLAG_*, log2 выравнивания */
+    uint32_t sequenceNum;     /**< sequenceNum хедера (0 — объект slab) */
+    uint32_t address;         /**< Смещение payload от начала зоны */
+    uint32_t size;            /**< Запрошенный размер */
+    uint32_t startPage;
+    uint32_t pageCount;
+    uint32_t ownerTask;       /**< Задача (как HeapTaskStats_t::ownerTask) */
+    uint32_t timestamp;       /**< Тики LatencyClock */
+} HeapTraceRecord_t;
+
+ALLOC_STATIC_ASSERT(sizeof(HeapTraceRecord_t) == 32U, "HeapTraceRecord_t must be 32 bytes");
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -4,6 +4,9 @@
  */
 #include "AllocatorCustomCpp.hpp"
 #include "FreeRTOSHeapBridge.h"
+#include "AllocatorExt.h"
+#include "LatencyClock.hpp"
+#include "BlockGuard.hpp"
 
 #include <cstring>
 #include <algorithm>
@@ -11,8 +14,12 @@
 
 #ifdef HOST_BUILD
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
 #else
 #include "task.h"
+#include "semphr.h"
 #endif
 
 /* ─────────────────── Глобальный экземпляр ─────────────────── */
@@ -22,12 +29,56 @@ namespace {
 
 #ifdef HOST_BUILD
     std::mutex g_allocMutex;
+    std::mutex g_zoneMutex[ALLOC_MAX_ZONES];
+
+#if ALLOC_ENABLE_MAGAZINES
+    /* Слоты магазинов на хосте: «ядро» = хеш потока, занятость — флагом */
+    std::atomic_flag g_magazineBusy[ALLOC_MAGAZINE_CORES] = {};
+#endif
+#if ALLOC_MAGAZINE_TLS_INDEX >= 0
+    thread_local AllocCustom::MagazineCache* t_taskMagazine = nullptr;
+#endif
+#if ALLOC_ZONE_TLS_INDEX >= 0
+    thread_local uintptr_t t_taskZone = 0U;
+#endif
+#else
+#if ALLOC_ENABLE_DEFERRED_FREE
+    TaskHandle_t g_deferredFreeTask = nullptr;
+#endif
+#if ALLOC_ENABLE_HANDLES
+    TaskHandle_t g_compactTask = nullptr;
+#endif
+#if configSUPPORT_STATIC_ALLOCATION
+    /* Мьютексы зон статические: динамические ушли бы в эту же кучу */
+    StaticSemaphore_t g_zoneMutexStorage[ALLOC_MAX_ZONES];
+    SemaphoreHandle_t g_zoneMutex[ALLOC_MAX_ZONES];
+#endif
 #endif
 } // namespace
 
 static_assert(std::is_trivially_constructible<AllocCustom::AllocatorCustomCpp>::value,
               "AllocatorCustomCpp must be trivially constructible for BSS placement");
 
+namespace {
+    /** Размеры страниц зон; 0 — ALLOC_PAGE_SIZE. */
+    constexpr uint32_t kZonePageSizes[ALLOC_MAX_ZONES] = ALLOC_ZONE_PAGE_SIZES;
+
+    /** Политики зон; не заданные — нулевые (как у макросов). */
+    constexpr AllocZonePolicy kZonePolicies[ALLOC_MAX_ZONES] = ALLOC_ZONE_POLICIES;
+
+    constexpr bool validPageSizes() {
+        for (uint32_t ps : kZonePageSizes) {
+            if (ps == 0U) continue;
+            if ((ps & (ps - 1U)) != 0U) return false;
+            if (ps < ALLOC_HEADER_SIZE + ALLOC_FOOTER_SIZE + 1U) return false;
+            if (!AllocCustom::SlabAllocator::validGeometry(ps)) return false;
+        }
+        return true;
+    }
+    static_assert(validPageSizes(),
+                  "ALLOC_ZONE_PAGE_SIZES: степени двойки ≥ header + footer + 1, вмещающие slab");
+} // namespace
+
 /* ═══════════════════ AllocatorCustomCpp ═══════════════════ */
 
 namespace AllocCustom {
@@ -50,48 +101,197 @@ void AllocatorCustomCpp::unlock() {
 #endif
 }
 
-void AllocatorCustomCpp::assertNotISR() const {
+/*
+ * Лок зоны на таргете — мьютекс с наследованием приоритета. До запуска
+ * планировщика конкурентов нет, лок не берётся. При приостановленном
+ * планировщике (vTaskSuspendAll, idle-задача в vPortFree) ждать нельзя:
+ * владелец мьютекса вытеснен и не продолжит до xTaskResumeAll, а на SMP
+ * второе ядро работает дальше. Поэтому мьютекс берётся без ожидания,
+ * занятая зона — отказ: free уходит в очередь отложенных, выделение —
+ * в другую зону. Без configSUPPORT_STATIC_ALLOCATION — откат на
+ * приостановку планировщика.
+ */
+bool AllocatorCustomCpp::acquireZone(uint8_t idx) {
+#ifdef HOST_BUILD
+    g_zoneMutex[idx].lock();
+    return true;
+#elif configSUPPORT_STATIC_ALLOCATION
+    const BaseType_t state = xTaskGetSchedulerState();
+    if (state == taskSCHEDULER_NOT_STARTED) return true;
+    const TickType_t wait = (state == taskSCHEDULER_SUSPENDED) ? 0U : portMAX_DELAY;
+    return xSemaphoreTake(g_zoneMutex[idx], wait) == pdTRUE;
+#else
+    (void)idx;
+    vTaskSuspendAll();
+    return true;
+#endif
+}
+
+void AllocatorCustomCpp::lockZone(uint8_t idx) {
+    const bool taken = acquireZone(idx);
+    ALLOC_ASSERT(taken && "Зона занята, а планировщик приостановлен");
+    (void)taken;
+}
+
+void AllocatorCustomCpp::unlockZone(uint8_t idx) {
+#ifdef HOST_BUILD
+    g_zoneMutex[idx].unlock();
+#elif configSUPPORT_STATIC_ALLOCATION
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return;
+    (void)xSemaphoreGive(g_zoneMutex[idx]);
+#else
+    (void)idx;
+    (void)xTaskResumeAll();
+#endif
+}
+
+bool AllocatorCustomCpp::tryLockZone(uint8_t idx) {
+#ifdef HOST_BUILD
+    return g_zoneMutex[idx].try_lock();
+#elif configSUPPORT_STATIC_ALLOCATION
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return true;
+    return xSemaphoreTake(g_zoneMutex[idx], 0U) == pdTRUE;
+#else
+    (void)idx;
+    vTaskSuspendAll();
+    return true;
+#endif
+}
+
+bool AllocatorCustomCpp::lockZoneForFree(uint8_t idx, void* ptr) {
+    if (acquireZone(idx)) return true;
+#if ALLOC_ENABLE_DEFERRED_FREE
+    if (deferFree(ptr)) return false;
+#else
+    (void)ptr;
+#endif
+    /* Трогать зону без лока нельзя — блок остаётся занятым */
+    ALLOC_ASSERT(false && "Зона занята, а планировщик приостановлен");
+    return false;
+}
+
+void AllocatorCustomCpp::lockAllZones() {
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        lockZone(i);
+    }
+}
+
+void AllocatorCustomCpp::unlockAllZones() {
+    for (uint8_t i = activeZones_; i > 0U; --i) {
+        unlockZone(static_cast<uint8_t>(i - 1U));
+    }
+}
+
+bool AllocatorCustomCpp::inISR() {
 #ifndef HOST_BUILD
     uint32_t ipsr;
     __asm volatile("mrs %0, ipsr" : "=r"(ipsr));
-    ALLOC_ASSERT(ipsr == 0U && "Аллокатор нельзя вызывать из контекста прерывания");
+    return ipsr != 0U;
+#else
+    return false;
 #endif
 }
 
+void AllocatorCustomCpp::assertNotISR() const {
+    ALLOC_ASSERT(!inISR() && "Аллокатор нельзя вызывать из контекста прерывания");
+}
+
 /* ───────── Инициализация ───────── */
 
 void AllocatorCustomCpp::defineHeapRegions(const HeapRegion_t* regions) {
     if (regions == nullptr) return;
 
     activeZones_ = 0U;
-    currentZone_ = HEAP_ZONE_ANY;
+    __atomic_store_n(&currentZone_, HEAP_ZONE_ANY, __ATOMIC_RELAXED);
     initialized_ = false;
 
+#if ALLOC_ENABLE_LATENCY_STATS || ALLOC_ENABLE_TRACE
+    LatencyClock::init();
+#endif
+#if ALLOC_ENABLE_TRACE
+    trace_.init();
+#endif
+
     const HeapRegion_t* cur = regions;
     while (activeZones_ < ALLOC_MAX_ZONES &&
            cur->pucStartAddress != nullptr &&
            cur->xSizeInBytes != 0U) {
+        const uint32_t pageBytes = (kZonePageSizes[activeZones_] != 0U)
+                                 ? kZonePageSizes[activeZones_] : ALLOC_PAGE_SIZE;
         zones_[activeZones_].init(
             static_cast<uint8_t*>(cur->pucStartAddress),
             cur->xSizeInBytes,
-            activeZones_);
+            activeZones_,
+            pageBytes,
+            kZonePolicies[activeZones_]);
+        slabs_[activeZones_].init(&zones_[activeZones_]);
+#if !defined(HOST_BUILD) && configSUPPORT_STATIC_ALLOCATION
+        if (g_zoneMutex[activeZones_] == nullptr) {
+            g_zoneMutex[activeZones_] = xSemaphoreCreateMutexStatic(&g_zoneMutexStorage[activeZones_]);
+        }
+#endif
         ++activeZones_;
         ++cur;
     }
 
     ALLOC_ASSERT(activeZones_ > 0U);
+    buildZoneRanges();
+#if ALLOC_ENABLE_MAGAZINES
+    for (auto& cache : magazines_) {
+        cache.init();
+    }
+#endif
+#if ALLOC_ENABLE_DEFERRED_FREE
+    deferred_.init();
+#endif
+#if ALLOC_ENABLE_HANDLES
+    handles_.init();
+#endif
+#if ALLOC_ENABLE_TRACE
+    /* Геометрия зон — в начало трассы, по ней хост воссоздаёт кучу */
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        HeapTraceRecord_t zone;
+        std::memset(&zone, 0, sizeof(zone));
+        zone.op        = HEAP_TRACE_ZONE;
+        zone.zoneIndex = i;
+        zone.address   = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(zones_[i].baseAddress));
+        zone.size      = static_cast<uint32_t>(zones_[i].regionSize);
+        zone.startPage = zones_[i].pageSize;
+        zone.pageCount = zones_[i].totalPages;
+        zone.timestamp = LatencyClock::now();
+        (void)trace_.push(zone);
+    }
+#endif
     initialized_ = true;
+
+#if ALLOC_ENABLE_DEFERRED_FREE
+    startDeferredFreeTask();
+#endif
+#if ALLOC_ENABLE_HANDLES
+    startCompactTask();
+#endif
 }
 
 void AllocatorCustomCpp::resetState() {
+    const uint8_t zones = activeZones_;
+    lockAllZones();
     lock();
     for (uint8_t i = 0; i < activeZones_; ++i) {
         std::memset(&zones_[i], 0, sizeof(PageAllocator));
+        std::memset(&slabs_[i], 0, sizeof(SlabAllocator));
     }
+#if ALLOC_ENABLE_MAGAZINES
+    std::memset(magazines_, 0, sizeof(magazines_));
+    retiredCachedAllocs_ = 0U;
+    retiredCachedFrees_  = 0U;
+#endif
     activeZones_ = 0U;
-    currentZone_ = HEAP_ZONE_ANY;
+    __atomic_store_n(&currentZone_, HEAP_ZONE_ANY, __ATOMIC_RELAXED);
     initialized_ = false;
     unlock();
+    for (uint8_t i = zones; i > 0U; --i) {
+        unlockZone(static_cast<uint8_t>(i - 1U));
+    }
 }
 
 /* ───────── Маршрутизация зон ───────── */
@@ -120,10 +320,97 @@ AllocatorCustomCpp::resolveRoute(HeapZone_t zone) const {
     return r;
 }
 
-void* AllocatorCustomCpp::allocateWithRoute(const ZoneRoute& route, size_t size) {
+/*
+ * Зона задачи хранится в TLS как (zone + 1): 0 — задача зону не задавала.
+ */
+namespace {
+#if ALLOC_ZONE_TLS_INDEX >= 0
+    uintptr_t loadTaskZone() {
+#ifdef HOST_BUILD
+        return t_taskZone;
+#else
+        if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return 0U;
+        return reinterpret_cast<uintptr_t>(
+            pvTaskGetThreadLocalStoragePointer(nullptr, ALLOC_ZONE_TLS_INDEX));
+#endif
+    }
+
+    void storeTaskZone(uintptr_t value) {
+#ifdef HOST_BUILD
+        t_taskZone = value;
+#else
+        if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return;
+        vTaskSetThreadLocalStoragePointer(nullptr, ALLOC_ZONE_TLS_INDEX,
+                                          reinterpret_cast<void*>(value));
+#endif
+    }
+#endif
+} // namespace
+
+namespace {
+#if ALLOC_ENABLE_TASK_STATS || ALLOC_ENABLE_TRACE
+    /** Тег текущей задачи для хедера; NONE — до старта планировщика. */
+    uint32_t currentOwnerTag() {
+#ifdef HOST_BUILD
+        return static_cast<uint32_t>(
+            (std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0x7FFFFFFFU) | 1U);
+#else
+        if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return HEAP_TASK_OWNER_NONE;
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle()));
+#endif
+    }
+#endif
+} // namespace
+
+HeapZone_t AllocatorCustomCpp::effectiveZone() {
+#if ALLOC_ZONE_TLS_INDEX >= 0
+    const uintptr_t taskZone = loadTaskZone();
+    if (taskZone != 0U) {
+        return static_cast<HeapZone_t>(taskZone - 1U);
+    }
+#endif
+    /* Одно выровненное слово — чтение без лока координатора */
+    return __atomic_load_n(&currentZone_, __ATOMIC_RELAXED);
+}
+
+void* AllocatorCustomCpp::allocateInZone(uint8_t idx, size_t size, bool zeroed, size_t alignment) {
+    void* p;
+#if ALLOC_ENABLE_TASK_STATS
+    const uint32_t owner = currentOwnerTag();
+#endif
+    ALLOC_LATENCY_BEGIN(t0);
+    if (!acquireZone(idx)) return nullptr;
+#if ALLOC_ENABLE_TASK_STATS
+    zones_[idx].allocOwner = owner;
+#endif
+    /* Мелкие запросы — из slab-ов, остальные (и выровненные) — целыми страницами */
+    if (alignment != 0U) {
+        p = zones_[idx].allocateAligned(size, alignment);
+    } else if (SlabAllocator::servesSize(size)) {
+        p = slabs_[idx].allocate(size);
+    } else {
+        p = zeroed ? zones_[idx].calloc(1U, size) : zones_[idx].allocate(size);
+        zeroed = false;
+    }
+    ALLOC_LATENCY_END(zones_[idx].latency.ops[HEAP_LATENCY_ALLOCATE], t0);
+    unlockZone(idx);
+
+    /* Обнуление объекта slab — уже вне лока зоны */
+    if (p != nullptr && zeroed) {
+        std::memset(p, 0, size);
+    }
+    return p;
+}
+
+/*
+ * Зоны перебираются по одной: в каждый момент удерживается не более
+ * одного лока зоны, поэтому откат между зонами не может зациклиться.
+ */
+void* AllocatorCustomCpp::allocateWithRoute(const ZoneRoute& route, size_t size, bool zeroed,
+                                            size_t alignment) {
     /* Попытка в primary */
     if (route.primary < activeZones_ && zones_[route.primary].isInitialized()) {
-        void* p = zones_[route.primary].allocate(size);
+        void* p = allocateInZone(route.primary, size, zeroed, alignment);
         if (p != nullptr) return p;
     }
 
@@ -132,7 +419,7 @@ void* AllocatorCustomCpp::allocateWithRoute(const ZoneRoute& route, size_t size)
         route.secondary < activeZones_ &&
         route.secondary != route.primary &&
         zones_[route.secondary].isInitialized()) {
-        void* p = zones_[route.secondary].allocate(size);
+        void* p = allocateInZone(route.secondary, size, zeroed, alignment);
         if (p != nullptr) return p;
     }
 
@@ -143,7 +430,7 @@ void* AllocatorCustomCpp::allocateWithRoute(const ZoneRoute& route, size_t size)
             if (i == route.secondary) continue;
             if (!zones_[i].isInitialized()) continue;
 
-            void* p = zones_[i].allocate(size);
+            void* p = allocateInZone(i, size, zeroed, alignment);
             if (p != nullptr) return p;
         }
     }
@@ -151,151 +438,1334 @@ void* AllocatorCustomCpp::allocateWithRoute(const ZoneRoute& route, size_t size)
     return nullptr;
 }
 
+void AllocatorCustomCpp::buildZoneRanges() {
+    /* Вставками: зон — единицы, порядок задания регионов произволен */
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        const PageAllocator& z = zones_[i];
+        ZoneRange r;
+        r.lo   = reinterpret_cast<uintptr_t>(z.baseAddress) + ALLOC_HEADER_SIZE;
+        r.hi   = reinterpret_cast<uintptr_t>(z.baseAddress) + (static_cast<size_t>(z.totalPages) << z.pageShift);
+        r.zone = i;
+        uint8_t j = i;
+        while (j > 0U && zoneRanges_[j - 1U].lo > r.lo) {
+            zoneRanges_[j] = zoneRanges_[j - 1U];
+            --j;
+        }
+        zoneRanges_[j] = r;
+    }
+    for (uint8_t i = 1; i < activeZones_; ++i) {
+        ALLOC_ASSERT(zoneRanges_[i - 1U].hi <= zoneRanges_[i].lo && "Зоны кучи пересекаются");
+    }
+}
+
+uint8_t AllocatorCustomCpp::findZone(const void* ptr) const {
+    /* Последний диапазон с lo ≤ p — геометрия неизменна, лок не нужен */
+    const uintptr_t p = reinterpret_cast<uintptr_t>(ptr);
+    uint8_t first = 0U;
+    uint8_t count = activeZones_;
+    while (count > 0U) {
+        const uint8_t half = static_cast<uint8_t>(count / 2U);
+        if (zoneRanges_[first + half].lo <= p) {
+            first  = static_cast<uint8_t>(first + half + 1U);
+            count  = static_cast<uint8_t>(count - half - 1U);
+        } else {
+            count = half;
+        }
+    }
+    if (first == 0U) return activeZones_;
+    const ZoneRange& r = zoneRanges_[first - 1U];
+    return (p < r.hi) ? r.zone : activeZones_;
+}
+
 /* ───────── Аллокация ───────── */
 
 void* AllocatorCustomCpp::allocate(size_t size) {
+    return allocate(size, effectiveZone());
+}
+
+void* AllocatorCustomCpp::allocate(size_t size, HeapZone_t zone) {
+    void* result = allocateUntraced(size, zone, 0U);
+    traceEvent((result != nullptr) ? HEAP_TRACE_ALLOC : HEAP_TRACE_FAIL, 0U, zone, result, size, 0U);
+    return result;
+}
+
+void* AllocatorCustomCpp::allocateAligned(size_t size, size_t alignment) {
+    return allocateAligned(size, alignment, effectiveZone());
+}
+
+void* AllocatorCustomCpp::allocateAligned(size_t size, size_t alignment, HeapZone_t zone) {
+    if (alignment == 0U || (alignment & (alignment - 1U)) != 0U) return nullptr;
+    /* Такое выравнивание есть у любой области — обычный путь */
+    if (alignment <= ALLOC_MALLOC_ALIGNMENT) alignment = 0U;
+    void* result = allocateUntraced(size, zone, alignment);
+    traceEvent((result != nullptr) ? HEAP_TRACE_ALLOC : HEAP_TRACE_FAIL, 0U, zone, result, size, alignment);
+    return result;
+}
+
+void* AllocatorCustomCpp::allocateUntraced(size_t size, HeapZone_t zone, size_t alignment) {
     assertNotISR();
-    lock();
-    const ZoneRoute route = resolveRoute(currentZone_);
-    void* result = allocateWithRoute(route, size);
-    unlock();
+    const ZoneRoute route = resolveRoute(zone);
+
+#if ALLOC_ENABLE_MAGAZINES
+    if (alignment == 0U && SlabAllocator::servesSize(size) && route.primary < activeZones_) {
+        void* p = allocateCached(route.primary, size);
+        if (p != nullptr) return p;
+    }
+#endif
+
+    void* result = allocateWithRoute(route, size, false, alignment);
+#if ALLOC_ENABLE_DEFERRED_FREE
+    /* Нехватка памяти — сначала разобрать отложенные free */
+    if (result == nullptr && drainDeferredFrees(ALLOC_DEFERRED_FREE_CAPACITY) > 0U) {
+        result = allocateWithRoute(route, size, false, alignment);
+    }
+#endif
     return result;
 }
 
 void AllocatorCustomCpp::deallocate(void* ptr) {
     if (ptr == nullptr) return;
+    traceEvent(HEAP_TRACE_FREE, 0U, HEAP_ZONE_ANY, ptr, 0U, 0U);
+    deallocateUntraced(ptr);
+}
+
+void AllocatorCustomCpp::deallocateUntraced(void* ptr) {
+#if ALLOC_ENABLE_DEFERRED_FREE
+    if (deferFree(ptr)) return;
+#endif
+    deallocateNow(ptr);
+}
+
+void AllocatorCustomCpp::deallocateNow(void* ptr) {
     assertNotISR();
-    lock();
 
-    for (uint8_t i = 0; i < activeZones_; ++i) {
-        if (zones_[i].isInitialized() && zones_[i].ownsPointer(ptr)) {
-            zones_[i].deallocate(ptr);
-            unlock();
-            return;
-        }
+    /* Геометрия зон неизменна после defineHeapRegions — поиск без блокировки */
+    const uint8_t zone = findZone(ptr);
+    ALLOC_ASSERT(zone < activeZones_ && "Указатель не принадлежит известным зонам кучи");
+    if (zone >= activeZones_) return;
+
+#if ALLOC_ENABLE_MAGAZINES
+    /* Страница живого объекта не может перестать быть slab-овой */
+    if (slabs_[zone].ownsObject(ptr) && deallocateCached(zone, ptr)) return;
+#endif
+
+    ALLOC_LATENCY_BEGIN(t0);
+    if (!lockZoneForFree(zone, ptr)) return;
+    if (slabs_[zone].ownsObject(ptr)) {
+        slabs_[zone].deallocate(ptr);
+    } else {
+        zones_[zone].deallocate(ptr);
     }
+    ALLOC_LATENCY_END(zones_[zone].latency.ops[HEAP_LATENCY_DEALLOCATE], t0);
+    unlockZone(zone);
+}
 
-    ALLOC_ASSERT(!"Указатель не принадлежит известным зонам кучи");
-    unlock();
+void AllocatorCustomCpp::deallocateSized(void* ptr, size_t size, size_t alignment, HeapZone_t zone) {
+    if (ptr == nullptr) return;
+    traceEvent(HEAP_TRACE_FREE, 0U, HEAP_ZONE_ANY, ptr, 0U, 0U);
+#if ALLOC_ENABLE_DEFERRED_FREE
+    if (deferFree(ptr)) return;
+#endif
+    assertNotISR();
+
+    /* Строгая зона известна заранее; PREFER/ANY могли откатиться — ищем */
+    const ZoneRoute route = resolveRoute(zone);
+    uint8_t idx = route.primary;
+    if (route.trySecondary || idx >= activeZones_ || !zones_[idx].ownsPointer(ptr)) {
+        idx = findZone(ptr);
+    }
+    ALLOC_ASSERT(idx < activeZones_ && "Указатель не принадлежит известным зонам кучи");
+    if (idx >= activeZones_) return;
+
+    /* Тот же выбор, что при выделении: slab — только обычные мелкие */
+    const bool slab = alignment <= ALLOC_MALLOC_ALIGNMENT && SlabAllocator::servesSize(size);
+
+#if ALLOC_ENABLE_MAGAZINES
+    if (slab && deallocateCached(idx, ptr)) return;
+#endif
+
+    ALLOC_LATENCY_BEGIN(t0);
+    if (!lockZoneForFree(idx, ptr)) return;
+    ALLOC_ASSERT(slab == slabs_[idx].ownsObject(ptr) && "Размер не совпадает с выделенным");
+    if (slab) {
+        slabs_[idx].deallocate(ptr);
+    } else {
+        zones_[idx].deallocate(ptr);
+    }
+    ALLOC_LATENCY_END(zones_[idx].latency.ops[HEAP_LATENCY_DEALLOCATE], t0);
+    unlockZone(idx);
 }
 
 void* AllocatorCustomCpp::calloc(size_t num, size_t size) {
+    return calloc(num, size, effectiveZone());
+}
+
+void* AllocatorCustomCpp::calloc(size_t num, size_t size, HeapZone_t zone) {
+    if (num > 0U && size > SIZE_MAX / num) return nullptr;
     assertNotISR();
-    lock();
-    const ZoneRoute route = resolveRoute(currentZone_);
+    const ZoneRoute route = resolveRoute(zone);
+
+#if ALLOC_ENABLE_MAGAZINES
+    if (SlabAllocator::servesSize(num * size) && route.primary < activeZones_) {
+        void* p = allocateCached(route.primary, num * size);
+        if (p != nullptr) {
+            std::memset(p, 0, num * size);
+            traceEvent(HEAP_TRACE_ALLOC, HEAP_TRACE_FLAG_ZEROED, zone, p, num * size, 0U);
+            return p;
+        }
+    }
+#endif
 
-    void* result = nullptr;
     /* calloc через route с fallback */
-    if (route.primary < activeZones_ && zones_[route.primary].isInitialized()) {
-        result = zones_[route.primary].calloc(num, size);
+    void* result = allocateWithRoute(route, num * size, true, 0U);
+#if ALLOC_ENABLE_DEFERRED_FREE
+    /* Нехватка памяти — сначала разобрать отложенные free */
+    if (result == nullptr && drainDeferredFrees(ALLOC_DEFERRED_FREE_CAPACITY) > 0U) {
+        result = allocateWithRoute(route, num * size, true, 0U);
     }
-    if (result == nullptr && route.trySecondary &&
-        route.secondary < activeZones_ &&
-        route.secondary != route.primary &&
-        zones_[route.secondary].isInitialized()) {
-        result = zones_[route.secondary].calloc(num, size);
+#endif
+    traceEvent((result != nullptr) ? HEAP_TRACE_ALLOC : HEAP_TRACE_FAIL, HEAP_TRACE_FLAG_ZEROED,
+               zone, result, num * size, 0U);
+    return result;
+}
+
+/* ───────── Отложенное освобождение ───────── */
+
+#if ALLOC_ENABLE_DEFERRED_FREE
+
+namespace {
+#ifndef HOST_BUILD
+    void deferredFreeTask(void* /*arg*/) {
+        for (;;) {
+            (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            while (g_allocator.drainDeferredFrees(ALLOC_DEFERRED_FREE_BATCH) > 0U) {
+            }
+        }
     }
+#endif
+} // namespace
 
-    unlock();
-    return result;
+void AllocatorCustomCpp::startDeferredFreeTask() {
+#ifndef HOST_BUILD
+    if (g_deferredFreeTask != nullptr) return;
+    /* Стек и TCB задачи — из этой же кучи, она уже инициализирована */
+    (void)xTaskCreate(deferredFreeTask, "heapFree", ALLOC_DEFERRED_FREE_STACK,
+                      nullptr, ALLOC_DEFERRED_FREE_PRIORITY, &g_deferredFreeTask);
+    ALLOC_ASSERT(g_deferredFreeTask != nullptr);
+#endif
 }
 
-/* ───────── Статистика ───────── */
+bool AllocatorCustomCpp::deferFree(void* ptr) {
+    const bool isr = inISR();
+#ifndef HOST_BUILD
+    /* До запуска планировщика разбирать очередь некому */
+    if (!isr && xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return false;
+#endif
 
-size_t AllocatorCustomCpp::getFreeHeapSize() {
-    lock();
-    size_t total = 0U;
-    for (uint8_t i = 0; i < activeZones_; ++i) {
-        total += zones_[i].freeBytes();
+    if (!deferred_.push(ptr)) {
+        /* Очередь полна: из задачи — освободить сразу, из ISR — некуда */
+        ALLOC_ASSERT(!isr && "Очередь отложенных free переполнена в ISR");
+        (void)isr;
+        return false;
     }
-    unlock();
-    return total;
+
+#ifndef HOST_BUILD
+    if (g_deferredFreeTask != nullptr) {
+        if (isr) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(g_deferredFreeTask, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            (void)xTaskNotifyGive(g_deferredFreeTask);
+        }
+    }
+#endif
+    return true;
 }
 
-size_t AllocatorCustomCpp::getMinimumEverFreeBytes() {
-    lock();
-    size_t total = 0U;
-    for (uint8_t i = 0; i < activeZones_; ++i) {
-        total += zones_[i].minEverFreeBytes();
+#endif /* ALLOC_ENABLE_DEFERRED_FREE */
+
+/* ───────── Перемещаемые области ───────── */
+
+#if ALLOC_ENABLE_HANDLES
+
+namespace {
+#ifndef HOST_BUILD
+    void compactTask(void* /*arg*/) {
+        for (;;) {
+            (void)g_allocator.migrateStep();
+            (void)g_allocator.compactStep();
+            vTaskDelay(pdMS_TO_TICKS(ALLOC_COMPACT_PERIOD_MS));
+        }
     }
-    unlock();
-    return total;
+#endif
+} // namespace
+
+void AllocatorCustomCpp::startCompactTask() {
+#if !defined(HOST_BUILD) && ALLOC_COMPACT_PERIOD_MS > 0
+    if (g_compactTask != nullptr) return;
+    (void)xTaskCreate(compactTask, "heapCompact", ALLOC_COMPACT_STACK,
+                      nullptr, ALLOC_COMPACT_PRIORITY, &g_compactTask);
+    ALLOC_ASSERT(g_compactTask != nullptr);
+#endif
 }
 
-void AllocatorCustomCpp::getHeapStats(HeapStats_t* stats) {
-    if (stats == nullptr) return;
-    std::memset(stats, 0, sizeof(HeapStats_t));
+#endif /* ALLOC_ENABLE_HANDLES */
 
-    lock();
-    for (uint8_t i = 0; i < activeZones_; ++i) {
-        stats->xAvailableHeapSpaceInBytes        += zones_[i].freeBytes();
-        stats->xMinimumEverFreeBytesRemaining    += zones_[i].minEverFreeBytes();
-        stats->xNumberOfSuccessfulAllocations    += zones_[i].successfulAllocs;
-        stats->xNumberOfSuccessfulFrees          += zones_[i].successfulFrees;
+HeapHandle_t AllocatorCustomCpp::allocateHandle(size_t size, HeapZone_t zone) {
+#if ALLOC_ENABLE_HANDLES
+    assertNotISR();
+    if (size == 0U) return HEAP_HANDLE_INVALID;
+    const ZoneRoute route = resolveRoute(zone);
+
+    /* Порядок зон — как в allocateWithRoute */
+    HeapHandle_t h = allocateHandleInZone(route.primary, size);
+    if (h != HEAP_HANDLE_INVALID || !route.trySecondary) return h;
+
+    if (route.secondary != route.primary) {
+        h = allocateHandleInZone(route.secondary, size);
     }
-    unlock();
+    for (uint8_t i = 0; i < activeZones_ && h == HEAP_HANDLE_INVALID; ++i) {
+        if (i == route.primary || i == route.secondary) continue;
+        h = allocateHandleInZone(i, size);
+    }
+    return h;
+#else
+    (void)size;
+    (void)zone;
+    return HEAP_HANDLE_INVALID;
+#endif
 }
 
-size_t AllocatorCustomCpp::getTotalHeapSize() {
+#if ALLOC_ENABLE_HANDLES
+HeapHandle_t AllocatorCustomCpp::allocateHandleInZone(uint8_t idx, size_t size) {
+    if (idx >= activeZones_ || !zones_[idx].isInitialized()) return HEAP_HANDLE_INVALID;
+#if ALLOC_ENABLE_TASK_STATS
+    const uint32_t owner = currentOwnerTag();
+#endif
+    lockZone(idx);
     lock();
-    size_t total = 0U;
-    for (uint8_t i = 0; i < activeZones_; ++i) {
-        total += zones_[i].totalBytes();
-    }
+    const HeapHandle_t h = handles_.reserve(idx);
     unlock();
-    return total;
+    if (h == HEAP_HANDLE_INVALID) {
+        unlockZone(idx);
+        return h;
+    }
+
+#if ALLOC_ENABLE_TASK_STATS
+    zones_[idx].allocOwner = owner;
+#endif
+    const bool placed = zones_[idx].allocateHandle(size, h);
+    if (!placed) {
+        lock();
+        handles_.release(h);
+        unlock();
+    }
+    unlockZone(idx);
+    return placed ? h : HEAP_HANDLE_INVALID;
 }
 
-size_t AllocatorCustomCpp::getUsedHeapSize() {
-    return getTotalHeapSize() - getFreeHeapSize();
+uint8_t AllocatorCustomCpp::lockHandleZone(HeapHandle_t handle) {
+    /*
+     * Зона хендла меняется только при миграции — под локами обеих зон.
+     * Прочитанная зона проверяется повторно под её локом.
+     */
+    for (;;) {
+        lock();
+        const HandleDirectory::Entry* e = handles_.find(handle);
+        const uint8_t idx = (e != nullptr) ? e->zone : activeZones_;
+        unlock();
+        if (idx >= activeZones_) return activeZones_;
+
+        lockZone(idx);
+        lock();
+        e = handles_.find(handle);
+        const bool same = (e != nullptr && e->zone == idx);
+        unlock();
+        if (same) return idx;
+        unlockZone(idx);
+    }
 }
+#endif
 
-/* ───────── Зоны ───────── */
+void* AllocatorCustomCpp::lockHandle(HeapHandle_t handle) {
+#if ALLOC_ENABLE_HANDLES
+    const uint8_t idx = lockHandleZone(handle);
+    if (idx >= activeZones_) return nullptr;
+    void* p = zones_[idx].lockHandle(handle);
+    unlockZone(idx);
+    return p;
+#else
+    (void)handle;
+    return nullptr;
+#endif
+}
 
-void       AllocatorCustomCpp::setZone(HeapZone_t zone) { lock(); currentZone_ = zone; unlock(); }
-HeapZone_t AllocatorCustomCpp::getZone()          const { return currentZone_; }
-uint8_t    AllocatorCustomCpp::getZoneCount()      const { return activeZones_; }
-bool       AllocatorCustomCpp::isInitialized()     const { return initialized_; }
+void AllocatorCustomCpp::unlockHandle(HeapHandle_t handle) {
+#if ALLOC_ENABLE_HANDLES
+    const uint8_t idx = lockHandleZone(handle);
+    ALLOC_ASSERT(idx < activeZones_ && "Недействительный хендл");
+    if (idx >= activeZones_) return;
+    const bool ok = zones_[idx].unlockHandle(handle);
+    unlockZone(idx);
+    ALLOC_ASSERT(ok && "unlock без lock");
+    (void)ok;
+#else
+    (void)handle;
+#endif
+}
 
-size_t AllocatorCustomCpp::getZoneFreeBytes(uint8_t idx) {
+void AllocatorCustomCpp::freeHandle(HeapHandle_t handle) {
+#if ALLOC_ENABLE_HANDLES
+    if (handle == HEAP_HANDLE_INVALID) return;
+    assertNotISR();
+    const uint8_t idx = lockHandleZone(handle);
+    ALLOC_ASSERT(idx < activeZones_ && "Недействительный хендл");
+    if (idx >= activeZones_) return;
+    zones_[idx].freeHandle(handle);
     lock();
-    size_t r = (idx < activeZones_) ? zones_[idx].freeBytes() : 0U;
+    handles_.release(handle);
     unlock();
-    return r;
+    unlockZone(idx);
+#else
+    (void)handle;
+#endif
 }
 
-size_t AllocatorCustomCpp::getZoneTotalBytes(uint8_t idx) {
+size_t AllocatorCustomCpp::compactStep() {
+    size_t moved = 0U;
+#if ALLOC_ENABLE_HANDLES
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        lockZone(i);
+        moved += zones_[i].compactStep(ALLOC_COMPACT_STEP_PAGES);
+        unlockZone(i);
+    }
+#endif
+    return moved;
+}
+
+size_t AllocatorCustomCpp::migrateStep() {
+    size_t migrated = 0U;
+#if ALLOC_ENABLE_MIGRATION
+    if (activeZones_ < 2U) return 0U;
+
+    /* FAST = зона 0, SLOW = зона 1; локи — по возрастанию индекса */
+    PageAllocator& fast = zones_[0];
+    PageAllocator& slow = zones_[1];
+    lockZone(0U);
+    lockZone(1U);
+
+    /* Хотя бы одна область за шаг, даже больше бюджета */
+    size_t budget = ALLOC_MIGRATE_STEP_BYTES;
+    bool   done   = false;
+    while (!done) {
+        HandleTable::Slot* hot = slow.handles.hottest(ALLOC_MIGRATE_HOT_LOCKS);
+        if (hot == nullptr) break;
+        const HeapHandle_t hotHandle = slow.handles.handleOf(hot);
+        const size_t hotSize = handleBytes(slow, hot);
+        if (migrated > 0U && hotSize > budget) break;
+
+        /* Нет места в FAST — вытеснять самые холодные, пока не поместится */
+        while (!slow.migrateHandle(hotHandle, fast)) {
+            HandleTable::Slot* cold = fast.handles.coldest(ALLOC_MIGRATE_COLD_LOCKS);
+            if (cold == nullptr) {
+                done = true;
+                break;
+            }
+            const HeapHandle_t coldHandle = fast.handles.handleOf(cold);
+            const size_t coldSize = handleBytes(fast, cold);
+            if ((migrated > 0U && coldSize + hotSize > budget) ||
+                !fast.migrateHandle(coldHandle, slow)) {
+                done = true;
+                break;
+            }
+            setHandleZone(coldHandle, 1U);
+            ++migrated;
+            budget = (coldSize < budget) ? budget - coldSize : 0U;
+        }
+        if (done) break;
+
+        setHandleZone(hotHandle, 0U);
+        ++migrated;
+        budget = (hotSize < budget) ? budget - hotSize : 0U;
+    }
+
+    fast.handles.decay();
+    slow.handles.decay();
+    unlockZone(1U);
+    unlockZone(0U);
+#endif
+    return migrated;
+}
+
+#if ALLOC_ENABLE_MIGRATION
+size_t AllocatorCustomCpp::handleBytes(const PageAllocator& zone, const HandleTable::Slot* slot) {
+    return zone.blockSize(BlockGuard::userDataFromHeader(zone.pageAddress(slot->startPage)));
+}
+
+void AllocatorCustomCpp::setHandleZone(HeapHandle_t handle, uint8_t zone) {
     lock();
-    size_t r = (idx < activeZones_) ? zones_[idx].totalBytes() : 0U;
+    HandleDirectory::Entry* e = handles_.find(handle);
+    ALLOC_ASSERT(e != nullptr);
+    if (e != nullptr) e->zone = zone;
     unlock();
-    return r;
 }
+#endif
 
-size_t AllocatorCustomCpp::getZoneMinFreeBytes(uint8_t idx) {
+size_t AllocatorCustomCpp::drainDeferredFrees(size_t max) {
+#if ALLOC_ENABLE_DEFERRED_FREE
+    assertNotISR();
+    size_t total = 0U;
+    while (total < max) {
+        void* batch[ALLOC_DEFERRED_FREE_BATCH];
+        const size_t want = std::min<size_t>(max - total, ALLOC_DEFERRED_FREE_BATCH);
+
+        /* Потребитель очереди один: выборку сериализует лок координатора */
+        lock();
+        const size_t n = deferred_.pop(batch, want);
+        unlock();
+        if (n == 0U) break;
+
+        /* Проверки и карантин — пачкой, по одному локу на зону; в трассу free попал при постановке */
+        deallocateBatchUntraced(batch, n);
+        total += n;
+    }
+    return total;
+#else
+    (void)max;
+    return 0U;
+#endif
+}
+
+/* ───────── Арены ───────── */
+
+bool AllocatorCustomCpp::createArena(HeapArena_t* arena, size_t capacity, HeapZone_t zone) {
+    ALLOC_ASSERT(arena != nullptr);
+    arena->base     = nullptr;
+    arena->capacity = 0U;
+    arena->used     = 0U;
+    arena->peak     = 0U;
+    if (capacity == 0U) return false;
+
+    /* Выровненный путь — всегда страницы: slab-объект или магазин арене не нужен */
+    void* p = allocateAligned(capacity, ALLOC_ARENA_ALIGNMENT, zone);
+    if (p == nullptr) return false;
+    arena->base     = static_cast<uint8_t*>(p);
+    arena->capacity = capacity;
+    return true;
+}
+
+void* AllocatorCustomCpp::arenaAllocate(HeapArena_t* arena, size_t size, size_t alignment) {
+    ALLOC_ASSERT(arena != nullptr);
+    if (arena->base == nullptr || size == 0U) return nullptr;
+    if (alignment == 0U || (alignment & (alignment - 1U)) != 0U) return nullptr;
+
+    const uintptr_t base  = reinterpret_cast<uintptr_t>(arena->base);
+    const uintptr_t start = (base + arena->used + alignment - 1U) & ~(static_cast<uintptr_t>(alignment) - 1U);
+    const size_t offset = start - base;
+    if (offset > arena->capacity || size > arena->capacity - offset) return nullptr;
+
+    arena->used = offset + size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return arena->base + offset;
+}
+
+void AllocatorCustomCpp::resetArena(HeapArena_t* arena) {
+    ALLOC_ASSERT(arena != nullptr);
+    if (arena->base == nullptr) return;
+#if ALLOC_FILL_ON_FREE
+    /* Обращение по устаревшему указателю читает паттерн, а не старые данные */
+    const uint8_t zone = findZone(arena->base);
+    if (zone < activeZones_ && zones_[zone].fillOnFree) {
+        std::memset(arena->base, ALLOC_PATTERN_QUARANTINE_FILL, arena->used);
+    }
+#endif
+    arena->used = 0U;
+}
+
+void AllocatorCustomCpp::destroyArena(HeapArena_t* arena) {
+    ALLOC_ASSERT(arena != nullptr);
+    if (arena->base == nullptr) return;
+    deallocate(arena->base);
+    arena->base     = nullptr;
+    arena->capacity = 0U;
+    arena->used     = 0U;
+}
+
+/* ───────── Пакетные операции ───────── */
+
+size_t AllocatorCustomCpp::allocateBatchInZone(uint8_t idx, size_t size, size_t count, void** out) {
+    if (idx >= activeZones_ || !zones_[idx].isInitialized()) return 0U;
+
+    size_t n = 0U;
+#if ALLOC_ENABLE_TASK_STATS
+    const uint32_t owner = currentOwnerTag();
+#endif
+    lockZone(idx);
+    if (SlabAllocator::servesSize(size)) {
+        /* Объекты одного класса и так ложатся в соседние слоты slab-ов */
+        while (n < count) {
+            void* p = slabs_[idx].allocate(size);
+            if (p == nullptr) break;
+            out[n++] = p;
+        }
+    } else {
+#if ALLOC_ENABLE_TASK_STATS
+        zones_[idx].allocOwner = owner;
+#endif
+        n = zones_[idx].allocateBatch(size, count, out);
+    }
+    unlockZone(idx);
+    return n;
+}
+
+size_t AllocatorCustomCpp::allocateBatch(size_t size, size_t count, void** out) {
+    if (out == nullptr || count == 0U) return 0U;
+    assertNotISR();
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = nullptr;
+    }
+    if (size == 0U) return 0U;
+
+    /* Маршрут как у allocate: остаток пакета — в следующие зоны */
+    const HeapZone_t zone  = effectiveZone();
+    const ZoneRoute  route = resolveRoute(zone);
+    size_t n = allocateBatchInZone(route.primary, size, count, out);
+
+    if (route.trySecondary && n < count && route.secondary != route.primary) {
+        n += allocateBatchInZone(route.secondary, size, count - n, out + n);
+    }
+    if (route.trySecondary) {
+        for (uint8_t i = 0; i < activeZones_ && n < count; ++i) {
+            if (i == route.primary || i == route.secondary) continue;
+            n += allocateBatchInZone(i, size, count - n, out + n);
+        }
+    }
+
+#if ALLOC_ENABLE_TRACE
+    /* Пакет воспроизводится целиком: размещение отличается от одиночных alloc */
+    traceBatch(HEAP_TRACE_ALLOC_BATCH, zone, size, count);
+    for (size_t i = 0; i < n; ++i) {
+        traceEvent(HEAP_TRACE_ALLOC, HEAP_TRACE_FLAG_BATCH, zone, out[i], size, 0U);
+    }
+    for (size_t i = n; i < count; ++i) {
+        traceEvent(HEAP_TRACE_FAIL, HEAP_TRACE_FLAG_BATCH, zone, nullptr, size, 0U);
+    }
+#endif
+    return n;
+}
+
+void AllocatorCustomCpp::deallocateBatch(void* const* ptrs, size_t n) {
+    if (ptrs == nullptr || n == 0U) return;
+    assertNotISR();
+
+#if ALLOC_ENABLE_TRACE
+    size_t traced = 0U;
+    for (size_t i = 0; i < n; ++i) {
+        traced += (ptrs[i] != nullptr) ? 1U : 0U;
+    }
+    traceBatch(HEAP_TRACE_FREE_BATCH, HEAP_ZONE_ANY, 0U, traced);
+    for (size_t i = 0; i < n; ++i) {
+        if (ptrs[i] != nullptr) {
+            traceEvent(HEAP_TRACE_FREE, HEAP_TRACE_FLAG_BATCH, HEAP_ZONE_ANY, ptrs[i], 0U, 0U);
+        }
+    }
+#endif
+    deallocateBatchUntraced(ptrs, n);
+}
+
+void AllocatorCustomCpp::deallocateBatchUntraced(void* const* ptrs, size_t n) {
+    /* Один проход на зону: лок и проверки целостности — по разу */
+    size_t freed = 0U;
+    for (uint8_t z = 0; z < activeZones_; ++z) {
+        bool locked = false;
+        for (size_t i = 0; i < n; ++i) {
+            void* p = ptrs[i];
+            if (p == nullptr || !zones_[z].ownsPointer(p)) continue;
+
+            if (!locked) {
+                lockZone(z);
+                const bool checked = zones_[z].operationChecks();
+                ALLOC_ASSERT(checked);
+                (void)checked;
+                locked = true;
+            }
+            if (slabs_[z].ownsObject(p)) {
+                slabs_[z].deallocate(p);
+            } else {
+                zones_[z].deallocateUnchecked(p);
+            }
+            ++freed;
+        }
+        if (locked) {
+            unlockZone(z);
+        }
+    }
+
+    /* Каждый ненулевой указатель должен найтись в одной из зон */
+    size_t expected = 0U;
+    for (size_t i = 0; i < n; ++i) {
+        expected += (ptrs[i] != nullptr) ? 1U : 0U;
+    }
+    ALLOC_ASSERT(freed == expected && "Указатель не принадлежит известным зонам кучи");
+    (void)expected;
+}
+
+/* ───────── Изменение размера ───────── */
+
+void* AllocatorCustomCpp::reallocate(void* ptr, size_t size) {
+    if (ptr == nullptr) return allocate(size);
+    if (size == 0U) {
+        deallocate(ptr);
+        return nullptr;
+    }
+    assertNotISR();
+
+    const uint8_t zone = findZone(ptr);
+    ALLOC_ASSERT(zone < activeZones_ && "Указатель не принадлежит известным зонам кучи");
+    if (zone >= activeZones_) return nullptr;
+
+    /* В трассе: запрос (исходная область), затем итог с HEAP_TRACE_FLAG_REALLOC */
+    traceEvent(HEAP_TRACE_REALLOC, 0U, HEAP_ZONE_ANY, ptr, size, 0U);
+
+    /* На месте: объект slab — в пределах класса, область — по соседним страницам */
+    size_t oldSize;
+    size_t alignment = 0U;
+    bool   resized;
+    lockZone(zone);
+    if (slabs_[zone].ownsObject(ptr)) {
+        oldSize = SlabAllocator::objectSize(ptr);
+        resized = SlabAllocator::resizeObject(ptr, size);
+    } else {
+        oldSize   = zones_[zone].blockSize(ptr);
+        alignment = zones_[zone].blockAlignment(ptr);
+        /* Мелкий остаток выгоднее перенести в slab, чем держать страницу */
+        resized = (alignment != 0U || !SlabAllocator::servesSize(size)) &&
+                  zones_[zone].resize(ptr, size);
+    }
+    unlockZone(zone);
+    if (resized) {
+        traceEvent(HEAP_TRACE_ALLOC, HEAP_TRACE_FLAG_REALLOC, HEAP_ZONE_ANY, ptr, size, alignment);
+        return ptr;
+    }
+
+    /* Перенос — с тем же выравниванием */
+    const HeapZone_t route = effectiveZone();
+    void* moved = allocateUntraced(size, route, alignment);
+    if (moved == nullptr) {
+        traceEvent(HEAP_TRACE_FAIL, HEAP_TRACE_FLAG_REALLOC, route, nullptr, size, alignment);
+        return nullptr;
+    }
+    std::memcpy(moved, ptr, std::min(oldSize, size));
+    deallocateUntraced(ptr);
+    traceEvent(HEAP_TRACE_ALLOC, HEAP_TRACE_FLAG_REALLOC, route, moved, size, alignment);
+    return moved;
+}
+
+/* ───────── Трассировка ───────── */
+
+void AllocatorCustomCpp::traceEvent(uint8_t op, uint8_t flags, HeapZone_t route,
+                                    const void* ptr, size_t size, size_t alignment) {
+#if ALLOC_ENABLE_TRACE
+    HeapTraceRecord_t r;
+    std::memset(&r, 0, sizeof(r));
+    r.op        = op;
+    r.zoneIndex = HEAP_TRACE_NO_ZONE;
+    r.route     = static_cast<uint8_t>(route);
+    r.flags     = static_cast<uint8_t>(flags |
+                  ((alignment != 0U) ? (__builtin_ctzl(alignment) << HEAP_TRACE_ALIGN_SHIFT) : 0U));
+    r.size      = static_cast<uint32_t>(size);
+    r.ownerTask = currentOwnerTag();
+    r.timestamp = LatencyClock::now();
+
+    /*
+     * Область живая и принадлежит вызывающему — её guard/хедер читаются
+     * без лока; страница живого объекта не перестаёт быть slab-овой.
+     */
+    const uint8_t zone = (ptr != nullptr) ? findZone(ptr) : activeZones_;
+    if (zone < activeZones_) {
+        const PageAllocator& z = zones_[zone];
+        r.zoneIndex = zone;
+        r.address   = static_cast<uint32_t>(static_cast<const uint8_t*>(ptr) - z.baseAddress);
+        if (slabs_[zone].ownsObject(ptr)) {
+            r.startPage = static_cast<uint32_t>(z.pageIndex(ptr));
+            if (op == HEAP_TRACE_FREE) {
+                r.size = static_cast<uint32_t>(SlabAllocator::objectSize(ptr));
+            }
+        } else {
+            const AllocBlockHeader* header = BlockGuard::headerFromUserData(ptr);
+            r.sequenceNum = header->sequenceNum;
+            r.startPage   = header->startPage;
+            r.pageCount   = header->pageCount;
+            if (op == HEAP_TRACE_FREE) {
+                r.size = header->requestedSize;
+            }
+        }
+    }
+    (void)trace_.push(r);
+#else
+    (void)op;
+    (void)flags;
+    (void)route;
+    (void)ptr;
+    (void)size;
+    (void)alignment;
+#endif
+}
+
+void AllocatorCustomCpp::traceBatch(uint8_t op, HeapZone_t route, size_t size, size_t count) {
+#if ALLOC_ENABLE_TRACE
+    HeapTraceRecord_t r;
+    std::memset(&r, 0, sizeof(r));
+    r.op        = op;
+    r.zoneIndex = HEAP_TRACE_NO_ZONE;
+    r.route     = static_cast<uint8_t>(route);
+    r.size      = static_cast<uint32_t>(size);
+    r.pageCount = static_cast<uint32_t>(count);
+    r.ownerTask = currentOwnerTag();
+    r.timestamp = LatencyClock::now();
+    (void)trace_.push(r);
+#else
+    (void)op;
+    (void)route;
+    (void)size;
+    (void)count;
+#endif
+}
+
+size_t AllocatorCustomCpp::readTrace(HeapTraceRecord_t* out, size_t max) {
+#if ALLOC_ENABLE_TRACE
+    if (out == nullptr) return 0U;
+    return trace_.pop(out, max);
+#else
+    (void)out;
+    (void)max;
+    return 0U;
+#endif
+}
+
+uint32_t AllocatorCustomCpp::traceDropped() const {
+#if ALLOC_ENABLE_TRACE
+    return trace_.droppedCount();
+#else
+    return 0U;
+#endif
+}
+
+/* ───────── Магазины ───────── */
+
+#if ALLOC_ENABLE_MAGAZINES
+
+MagazineCache* AllocatorCustomCpp::taskMagazine() const {
+#if ALLOC_MAGAZINE_TLS_INDEX >= 0
+#ifdef HOST_BUILD
+    return t_taskMagazine;
+#else
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) return nullptr;
+    return static_cast<MagazineCache*>(
+        pvTaskGetThreadLocalStoragePointer(nullptr, ALLOC_MAGAZINE_TLS_INDEX));
+#endif
+#else
+    return nullptr;
+#endif
+}
+
+MagazineCache* AllocatorCustomCpp::acquireMagazine(uint32_t* token) {
+    /* Магазин задачи принадлежит только ей — синхронизация не нужна */
+    MagazineCache* own = taskMagazine();
+    if (own != nullptr) {
+        *token = 0U;
+        return own;
+    }
+
+#ifdef HOST_BUILD
+    const auto slot = static_cast<uint32_t>(
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) % ALLOC_MAGAZINE_CORES);
+    if (g_magazineBusy[slot].test_and_set(std::memory_order_acquire)) {
+        return nullptr;   /* Слот занят другим потоком — идём медленным путём */
+    }
+    *token = slot;
+    return &magazines_[slot];
+#else
+    /* Маска прерываний локальна для ядра и исключает вытеснение/миграцию */
+    *token = static_cast<uint32_t>(portSET_INTERRUPT_MASK_FROM_ISR());
+#if ALLOC_MAGAZINE_CORES > 1
+    return &magazines_[portGET_CORE_ID()];
+#else
+    return &magazines_[0];
+#endif
+#endif
+}
+
+void AllocatorCustomCpp::releaseMagazine(MagazineCache* cache, uint32_t token) {
+    if (cache < &magazines_[0] || cache >= &magazines_[ALLOC_MAGAZINE_CORES]) {
+        return;   /* Магазин задачи */
+    }
+#ifdef HOST_BUILD
+    g_magazineBusy[token].clear(std::memory_order_release);
+#else
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(static_cast<UBaseType_t>(token));
+#endif
+}
+
+void* AllocatorCustomCpp::allocateCached(uint8_t zone, size_t size) {
+    const uint8_t cls = SlabAllocator::classFor(size);
+
+    uint32_t token = 0U;
+    MagazineCache* cache = acquireMagazine(&token);
+    if (cache == nullptr) return nullptr;
+    void* obj = cache->pop(zone, cls);
+    releaseMagazine(cache, token);
+
+    if (obj != nullptr) {
+        SlabAllocator::reuseObject(obj, size, zones_[zone].checkLevel);
+        return obj;
+    }
+
+    /* Промах: пачка объектов из slab за одну блокировку */
+    void* batch[ALLOC_MAGAZINE_BATCH];
+    uint16_t n = 0U;
+    if (!acquireZone(zone)) return nullptr;
+    if (zones_[zone].isInitialized()) {
+        while (n < ALLOC_MAGAZINE_BATCH) {
+            void* p = slabs_[zone].allocate(SlabAllocator::classSize(cls));
+            if (p == nullptr) break;
+            batch[n++] = p;
+        }
+        if (n > 1U) {
+            slabs_[zone].cachedOut += n - 1U;
+        }
+    }
+    unlockZone(zone);
+    if (n == 0U) return nullptr;
+
+    /* Пачка — в состоянии магазина; payload свободных слотов уже залит */
+    for (uint16_t i = 0; i < n; ++i) {
+        (void)SlabAllocator::recycleObject(batch[i], false);
+    }
+
+    uint16_t stored = 1U;
+    cache = acquireMagazine(&token);
+    if (cache != nullptr) {
+        while (stored < n && cache->push(zone, cls, batch[stored])) {
+            ++stored;
+        }
+        releaseMagazine(cache, token);
+    }
+    if (stored < n) {
+        drainToSlab(zone, &batch[stored], static_cast<uint16_t>(n - stored));
+    }
+
+    SlabAllocator::reuseObject(batch[0], size, zones_[zone].checkLevel);
+    return batch[0];
+}
+
+bool AllocatorCustomCpp::deallocateCached(uint8_t zone, void* ptr) {
+    uint32_t token = 0U;
+    MagazineCache* cache = acquireMagazine(&token);
+    if (cache == nullptr) return false;
+
+    const uint8_t cls = SlabAllocator::recycleObject(ptr, zones_[zone].fillOnFree);
+
+    void* batch[ALLOC_MAGAZINE_BATCH];
+    uint16_t n = 0U;
+    if (!cache->push(zone, cls, ptr)) {
+        /* Магазин полон — освобождаем место пачкой */
+        n = cache->take(zone, cls, batch, ALLOC_MAGAZINE_BATCH);
+        const bool pushed = cache->push(zone, cls, ptr);
+        ALLOC_ASSERT(pushed);
+        (void)pushed;
+    }
+    ++cache->cachedFrees;
+    releaseMagazine(cache, token);
+
+    if (n > 0U) {
+        drainToSlab(zone, batch, n);
+    }
+    return true;
+}
+
+void AllocatorCustomCpp::drainToSlab(uint8_t zone, void* const* items, uint16_t count) {
+    lockZone(zone);
+    for (uint16_t i = 0; i < count; ++i) {
+        slabs_[zone].returnCached(items[i]);
+    }
+    slabs_[zone].cachedBack += count;
+    unlockZone(zone);
+}
+
+void AllocatorCustomCpp::flushCache(MagazineCache* cache) {
+    for (uint8_t z = 0; z < activeZones_; ++z) {
+        for (uint8_t c = 0; c < MagazineCache::kClassCount; ++c) {
+            void* batch[ALLOC_MAGAZINE_BATCH];
+            uint16_t n;
+            do {
+                uint32_t token = 0U;
+#ifdef HOST_BUILD
+                /* На хосте — ждём освобождения слота */
+                const auto slot = static_cast<uint32_t>(cache - magazines_);
+                const bool isCore = slot < ALLOC_MAGAZINE_CORES;
+                while (isCore && g_magazineBusy[slot].test_and_set(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                token = slot;
+#else
+                const bool isCore = cache >= &magazines_[0] && cache < &magazines_[ALLOC_MAGAZINE_CORES];
+                if (isCore) {
+                    token = static_cast<uint32_t>(portSET_INTERRUPT_MASK_FROM_ISR());
+                }
+#endif
+                n = cache->take(z, c, batch, ALLOC_MAGAZINE_BATCH);
+                if (isCore) {
+                    releaseMagazine(cache, token);
+                }
+                if (n > 0U) {
+                    drainToSlab(z, batch, n);
+                }
+            } while (n > 0U);
+        }
+    }
+}
+
+#endif /* ALLOC_ENABLE_MAGAZINES */
+
+void AllocatorCustomCpp::flushMagazines() {
+#if ALLOC_ENABLE_MAGAZINES
+    assertNotISR();
+#ifdef HOST_BUILD
+    for (auto& cache : magazines_) {
+        flushCache(&cache);
+    }
+#else
+#if ALLOC_MAGAZINE_CORES > 1
+    /* Номер ядра читается под маской, слив — уже без неё */
+    const UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    MagazineCache* cache = &magazines_[portGET_CORE_ID()];
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    flushCache(cache);
+#else
+    flushCache(&magazines_[0]);
+#endif
+#endif
+#endif
+}
+
+bool AllocatorCustomCpp::attachTaskMagazine() {
+#if ALLOC_ENABLE_MAGAZINES && ALLOC_MAGAZINE_TLS_INDEX >= 0
+    if (taskMagazine() != nullptr) return true;
+
+    /* Магазин задачи — обычная страничная область */
+    auto* cache = static_cast<MagazineCache*>(allocate(sizeof(MagazineCache)));
+    if (cache == nullptr) return false;
+    cache->init();
+#ifdef HOST_BUILD
+    t_taskMagazine = cache;
+#else
+    vTaskSetThreadLocalStoragePointer(nullptr, ALLOC_MAGAZINE_TLS_INDEX, cache);
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocatorCustomCpp::flushTaskMagazine(void* task) {
+#if ALLOC_ENABLE_MAGAZINES && ALLOC_MAGAZINE_TLS_INDEX >= 0
+    assertNotISR();
+#ifdef HOST_BUILD
+    (void)task;
+    MagazineCache* cache = t_taskMagazine;
+    t_taskMagazine = nullptr;
+#else
+    auto* handle = static_cast<TaskHandle_t>(task);
+    auto* cache = static_cast<MagazineCache*>(
+        pvTaskGetThreadLocalStoragePointer(handle, ALLOC_MAGAZINE_TLS_INDEX));
+    vTaskSetThreadLocalStoragePointer(handle, ALLOC_MAGAZINE_TLS_INDEX, nullptr);
+#endif
+    if (cache == nullptr) return;
+
+    flushCache(cache);
     lock();
-    size_t r = (idx < activeZones_) ? zones_[idx].minEverFreeBytes() : 0U;
+    retiredCachedAllocs_ += cache->cachedAllocs;
+    retiredCachedFrees_  += cache->cachedFrees;
     unlock();
-    return r;
+    deallocate(cache);
+#else
+    (void)task;
+#endif
 }
 
-size_t AllocatorCustomCpp::getZoneUsedBytes(uint8_t idx) {
+/* ───────── Статистика ───────── */
+
+size_t AllocatorCustomCpp::getFreeHeapSize() {
+    lockAllZones();
+    size_t total = 0U;
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        total += zones_[i].freeBytes();
+    }
+    unlockAllZones();
+    return total;
+}
+
+size_t AllocatorCustomCpp::getMinimumEverFreeBytes() {
+    lockAllZones();
+    size_t total = 0U;
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        total += zones_[i].minEverFreeBytes();
+    }
+    unlockAllZones();
+    return total;
+}
+
+void AllocatorCustomCpp::getHeapStats(HeapStats_t* stats) {
+    if (stats == nullptr) return;
+    std::memset(stats, 0, sizeof(HeapStats_t));
+
+    lockAllZones();
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        stats->xAvailableHeapSpaceInBytes        += zones_[i].freeBytes();
+        stats->xMinimumEverFreeBytesRemaining    += zones_[i].minEverFreeBytes();
+
+        /* Свободные участки — по всем зонам: наибольший, наименьший, число */
+        const size_t largest  = zones_[i].largestFreeBytes();
+        const size_t smallest = zones_[i].smallestFreeBytes();
+        if (largest > stats->xSizeOfLargestFreeBlockInBytes) {
+            stats->xSizeOfLargestFreeBlockInBytes = largest;
+        }
+        if (smallest != 0U && (stats->xSizeOfSmallestFreeBlockInBytes == 0U ||
+                               smallest < stats->xSizeOfSmallestFreeBlockInBytes)) {
+            stats->xSizeOfSmallestFreeBlockInBytes = smallest;
+        }
+        stats->xNumberOfFreeBlocks               += zones_[i].freeBlockCount();
+        stats->xNumberOfSuccessfulAllocations    += zones_[i].successfulAllocs;
+        stats->xNumberOfSuccessfulFrees          += zones_[i].successfulFrees;
+
+        /* Объекты slab — пользовательские аллокации, сами slab-ы — нет */
+        stats->xNumberOfSuccessfulAllocations    += slabs_[i].successfulAllocs;
+        stats->xNumberOfSuccessfulAllocations    -= slabs_[i].slabsCreated;
+        stats->xNumberOfSuccessfulFrees          += slabs_[i].successfulFrees;
+        stats->xNumberOfSuccessfulFrees          -= slabs_[i].slabsReleased;
+
+        /* Объекты, которые ушли в магазины пачками, ещё не выданы */
+        stats->xNumberOfSuccessfulAllocations    -= slabs_[i].cachedOut;
+        stats->xNumberOfSuccessfulFrees          -= slabs_[i].cachedBack;
+    }
+#if ALLOC_ENABLE_MAGAZINES
+    for (const auto& cache : magazines_) {
+        stats->xNumberOfSuccessfulAllocations    += cache.cachedAllocs;
+        stats->xNumberOfSuccessfulFrees          += cache.cachedFrees;
+    }
     lock();
-    size_t r = (idx < activeZones_) ? zones_[idx].usedBytes() : 0U;
+    stats->xNumberOfSuccessfulAllocations    += retiredCachedAllocs_;
+    stats->xNumberOfSuccessfulFrees          += retiredCachedFrees_;
     unlock();
+#endif
+    unlockAllZones();
+}
+
+bool AllocatorCustomCpp::getHeapLatencyStats(uint8_t idx, HeapLatencyStats_t* stats) {
+    if (stats == nullptr) return false;
+    std::memset(stats, 0, sizeof(HeapLatencyStats_t));
+#if ALLOC_ENABLE_LATENCY_STATS
+    if (idx >= activeZones_) return false;
+    lockZone(idx);
+    *stats = zones_[idx].latency;
+    unlockZone(idx);
+    stats->ticksPerSecond = LatencyClock::ticksPerSecond();
+    return true;
+#else
+    (void)idx;
+    return false;
+#endif
+}
+
+void AllocatorCustomCpp::resetHeapLatencyStats() {
+#if ALLOC_ENABLE_LATENCY_STATS
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        lockZone(i);
+        std::memset(&zones_[i].latency, 0, sizeof(HeapLatencyStats_t));
+        unlockZone(i);
+    }
+#endif
+}
+
+size_t AllocatorCustomCpp::getTaskHeapStats(HeapTaskStats_t* out, size_t maxCount) {
+    if (out == nullptr || maxCount == 0U) return 0U;
+    size_t n = 0U;
+#if ALLOC_ENABLE_TASK_STATS
+    HeapTaskStats_t zoneStats[ALLOC_TASK_STATS_SLOTS + 2U];
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        lockZone(i);
+        const size_t count = zones_[i].taskStats(zoneStats, ALLOC_TASK_STATS_SLOTS + 2U);
+        unlockZone(i);
+
+        /* Слияние по владельцу: задачи одни и те же во всех зонах */
+        for (size_t k = 0; k < count; ++k) {
+            size_t j = 0U;
+            while (j < n && out[j].ownerTask != zoneStats[k].ownerTask) ++j;
+            if (j == n) {
+                if (n == maxCount) continue;
+                out[n] = zoneStats[k];
+                ++n;
+            } else {
+                out[j].blocks += zoneStats[k].blocks;
+                out[j].bytes  += zoneStats[k].bytes;
+            }
+        }
+    }
+#endif
+    return n;
+}
+
+size_t AllocatorCustomCpp::walkTaskBlocks(uint32_t owner, HeapBlockVisitor_t visitor, void* context) {
+    size_t visited = 0U;
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        /* visitor вызывается под замком зоны — из него нельзя обращаться к куче */
+        lockZone(i);
+        visited += zones_[i].walkAllocated(owner, visitor, context);
+        unlockZone(i);
+    }
+    return visited;
+}
+
+void AllocatorCustomCpp::tagCaller(void* ptr, uintptr_t callerPc) {
+#if ALLOC_ENABLE_TASK_STATS && ALLOC_TRACK_CALLER_PC
+    if (ptr == nullptr) return;
+    const uint8_t idx = findZone(ptr);
+    if (idx >= activeZones_) return;
+    lockZone(idx);
+    /* Объекты slab без собственного хедера — адрес не сохраняется */
+    if (!slabs_[idx].ownsObject(ptr)) {
+        zones_[idx].setCallerPc(ptr, static_cast<uint32_t>(callerPc));
+    }
+    unlockZone(idx);
+#else
+    (void)ptr;
+    (void)callerPc;
+#endif
+}
+
+size_t AllocatorCustomCpp::getTotalHeapSize() {
+    /* Размер зоны неизменен после инициализации */
+    size_t total = 0U;
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        total += zones_[i].totalBytes();
+    }
+    return total;
+}
+
+size_t AllocatorCustomCpp::getUsedHeapSize() {
+    return getTotalHeapSize() - getFreeHeapSize();
+}
+
+/* ───────── Зоны ───────── */
+
+/*
+ * Счётчики зоны — выровненные слова, читаются атомарно без блокировки.
+ */
+
+void       AllocatorCustomCpp::setZone(HeapZone_t zone) { __atomic_store_n(&currentZone_, zone, __ATOMIC_RELAXED); }
+HeapZone_t AllocatorCustomCpp::getZone()          const { return __atomic_load_n(&currentZone_, __ATOMIC_RELAXED); }
+HeapZone_t AllocatorCustomCpp::getTaskZone()            { return effectiveZone(); }
+
+void AllocatorCustomCpp::setTaskZone(HeapZone_t zone) {
+#if ALLOC_ZONE_TLS_INDEX >= 0
+    storeTaskZone(static_cast<uintptr_t>(zone) + 1U);
+#else
+    (void)zone;
+#endif
+}
+
+void AllocatorCustomCpp::clearTaskZone() {
+#if ALLOC_ZONE_TLS_INDEX >= 0
+    storeTaskZone(0U);
+#endif
+}
+uint8_t    AllocatorCustomCpp::getZoneCount()      const { return activeZones_; }
+bool       AllocatorCustomCpp::isInitialized()     const { return initialized_; }
+
+size_t AllocatorCustomCpp::getZoneFreeBytes(uint8_t idx) {
+    return (idx < activeZones_) ? zones_[idx].freeBytes() : 0U;
+}
+
+size_t AllocatorCustomCpp::getZoneTotalBytes(uint8_t idx) {
+    return (idx < activeZones_) ? zones_[idx].totalBytes() : 0U;
+}
+
+size_t AllocatorCustomCpp::getZoneMinFreeBytes(uint8_t idx) {
+    return (idx < activeZones_) ? zones_[idx].minEverFreeBytes() : 0U;
+}
+
+size_t AllocatorCustomCpp::getZoneUsedBytes(uint8_t idx) {
+    return (idx < activeZones_) ? zones_[idx].usedBytes() : 0U;
+}
+
+size_t AllocatorCustomCpp::getZoneLargestFreeBytes(uint8_t idx) {
+    if (idx >= activeZones_) return 0U;
+    lockZone(idx);
+    const size_t r = zones_[idx].largestFreeBytes();
+    unlockZone(idx);
     return r;
 }
 
+size_t AllocatorCustomCpp::getZoneSmallestFreeBytes(uint8_t idx) {
+    if (idx >= activeZones_) return 0U;
+    lockZone(idx);
+    const size_t r = zones_[idx].smallestFreeBytes();
+    unlockZone(idx);
+    return r;
+}
+
+size_t AllocatorCustomCpp::getZoneFreeBlockCount(uint8_t idx) {
+    return (idx < activeZones_) ? zones_[idx].freeBlockCount() : 0U;
+}
+
+size_t AllocatorCustomCpp::getZoneQuarantineBytes(uint8_t idx) {
+    if (idx >= activeZones_) return 0U;
+    lockZone(idx);
+    const size_t r = zones_[idx].quarantineBytes();
+    unlockZone(idx);
+    return r;
+}
+
+uint32_t AllocatorCustomCpp::getZoneFragmentation(uint8_t idx) {
+    if (idx >= activeZones_) return 0U;
+    lockZone(idx);
+    const size_t freeBytes = zones_[idx].freeBytes();
+    const size_t largest   = zones_[idx].largestFreeBytes();
+    unlockZone(idx);
+    if (freeBytes == 0U) return 0U;
+    /* uint64_t — без переполнения на 32-битной size_t */
+    const uint64_t scattered = static_cast<uint64_t>(freeBytes - largest) * 1000U;
+    return static_cast<uint32_t>(scattered / freeBytes);
+}
+
 /* ───────── Диагностика ───────── */
 
 bool AllocatorCustomCpp::validateHeap() {
-    lock();
     bool ok = true;
     for (uint8_t i = 0; i < activeZones_; ++i) {
         if (!zones_[i].isInitialized()) continue;
+        lockZone(i);
         ok = ok && zones_[i].verifyQuarantine();
         ok = ok && zones_[i].verifyAllocated();
+        ok = ok && slabs_[i].verify();
+        unlockZone(i);
+    }
+    return ok;
+}
+
+bool AllocatorCustomCpp::idleCheck() {
+    bool ok = true;
+    for (uint8_t i = 0; i < activeZones_; ++i) {
+        /* Idle-задача не должна блокироваться: занятая зона пропускается */
+        if (!zones_[i].isInitialized() || !tryLockZone(i)) continue;
+        zones_[i].pollFills();
+        ok = ok && zones_[i].runIncrementalChecks(
+                       ALLOC_CHECK_QUARANTINE_BUDGET * ALLOC_CHECK_IDLE_FACTOR,
+                       ALLOC_CHECK_PAGE_BUDGET * ALLOC_CHECK_IDLE_FACTOR);
+        unlockZone(i);
     }
-    unlock();
     return ok;
 }
 
@@ -317,6 +1787,38 @@ void* FreeRTOSHeapInternalCalloc(size_t num, size_t size) {
     return g_allocator.calloc(num, size);
 }
 
+void* FreeRTOSHeapInternalAllocateZone(size_t size, HeapZone_t zone) {
+    return g_allocator.allocate(size, zone);
+}
+
+void* FreeRTOSHeapInternalCallocZone(size_t num, size_t size, HeapZone_t zone) {
+    return g_allocator.calloc(num, size, zone);
+}
+
+void* FreeRTOSHeapInternalAllocateAligned(size_t size, size_t alignment) {
+    return g_allocator.allocateAligned(size, alignment);
+}
+
+void* FreeRTOSHeapInternalAllocateZoneAligned(size_t size, size_t alignment, HeapZone_t zone) {
+    return g_allocator.allocateAligned(size, alignment, zone);
+}
+
+void FreeRTOSHeapInternalDeallocateSized(void* ptr, size_t size, size_t alignment, HeapZone_t zone) {
+    g_allocator.deallocateSized(ptr, size, alignment, zone);
+}
+
+void* FreeRTOSHeapInternalReallocate(void* ptr, size_t size) {
+    return g_allocator.reallocate(ptr, size);
+}
+
+size_t FreeRTOSHeapInternalAllocateBatch(size_t size, size_t count, void** out) {
+    return g_allocator.allocateBatch(size, count, out);
+}
+
+void FreeRTOSHeapInternalDeallocateBatch(void* const* ptrs, size_t n) {
+    g_allocator.deallocateBatch(ptrs, n);
+}
+
 size_t FreeRTOSHeapInternalGetFreeHeapSize(void) {
     return g_allocator.getFreeHeapSize();
 }
@@ -333,6 +1835,100 @@ void FreeRTOSHeapInternalResetState(void) {
     g_allocator.resetState();
 }
 
+BaseType_t xPortGetHeapLatencyStats(UBaseType_t uxZone, HeapLatencyStats_t* pxStats) {
+    return g_allocator.getHeapLatencyStats(static_cast<uint8_t>(uxZone), pxStats) ? pdTRUE : pdFALSE;
+}
+
+void vPortResetHeapLatencyStats(void) {
+    g_allocator.resetHeapLatencyStats();
+}
+
+UBaseType_t heapTaskGetStats(HeapTaskStats_t* pxStats, UBaseType_t uxMax) {
+    return static_cast<UBaseType_t>(g_allocator.getTaskHeapStats(pxStats, uxMax));
+}
+
+size_t heapTaskWalkBlocks(uint32_t ulOwner, HeapBlockVisitor_t pxVisitor, void* pvContext) {
+    return g_allocator.walkTaskBlocks(ulOwner, pxVisitor, pvContext);
+}
+
+size_t heapTraceRead(HeapTraceRecord_t* pxOut, size_t xMax) {
+    return g_allocator.readTrace(pxOut, xMax);
+}
+
+uint32_t heapTraceGetDropped(void) {
+    return g_allocator.traceDropped();
+}
+
+void FreeRTOSHeapInternalTagCaller(void* ptr, uintptr_t pc) {
+    g_allocator.tagCaller(ptr, pc);
+}
+
+BaseType_t heapIdleCheck(void) {
+    const bool ok = g_allocator.idleCheck();
+    ALLOC_ASSERT(ok && "Обнаружена порча кучи");
+    return ok ? pdTRUE : pdFALSE;
+}
+
+size_t heapDeferredFreeDrain(void) {
+    return g_allocator.drainDeferredFrees(SIZE_MAX);
+}
+
+HeapHandle_t heapHandleAlloc(size_t xWantedSize, HeapZone_t zone) {
+    return g_allocator.allocateHandle(xWantedSize, zone);
+}
+
+void* heapHandleLock(HeapHandle_t xHandle) {
+    return g_allocator.lockHandle(xHandle);
+}
+
+void heapHandleUnlock(HeapHandle_t xHandle) {
+    g_allocator.unlockHandle(xHandle);
+}
+
+void heapHandleFree(HeapHandle_t xHandle) {
+    g_allocator.freeHandle(xHandle);
+}
+
+size_t heapCompactStep(void) {
+    return g_allocator.compactStep();
+}
+
+size_t heapMigrateStep(void) {
+    return g_allocator.migrateStep();
+}
+
+BaseType_t heapArenaCreate(HeapArena_t* pxArena, size_t xCapacity, HeapZone_t zone) {
+    return g_allocator.createArena(pxArena, xCapacity, zone) ? pdTRUE : pdFALSE;
+}
+
+void* heapArenaAlloc(HeapArena_t* pxArena, size_t xSize) {
+    return AllocCustom::AllocatorCustomCpp::arenaAllocate(pxArena, xSize, ALLOC_ARENA_ALIGNMENT);
+}
+
+void* heapArenaAllocAligned(HeapArena_t* pxArena, size_t xSize, size_t xAlignment) {
+    return AllocCustom::AllocatorCustomCpp::arenaAllocate(pxArena, xSize, xAlignment);
+}
+
+void heapArenaReset(HeapArena_t* pxArena) {
+    g_allocator.resetArena(pxArena);
+}
+
+void heapArenaDestroy(HeapArena_t* pxArena) {
+    g_allocator.destroyArena(pxArena);
+}
+
+void heapMagazineFlush(void) {
+    g_allocator.flushMagazines();
+}
+
+BaseType_t heapMagazineAttachTask(void) {
+    return g_allocator.attachTaskMagazine() ? pdTRUE : pdFALSE;
+}
+
+void heapMagazineDetachTask(void* xTask) {
+    g_allocator.flushTaskMagazine(xTask);
+}
+
 void vPortDefineHeapRegionsCpp(const HeapRegion_t* pxHeapRegions) {
     g_allocator.defineHeapRegions(pxHeapRegions);
 }
@@ -345,6 +1941,18 @@ HeapZone_t heapZoneGet(void) {
     return g_allocator.getZone();
 }
 
+void heapZoneSetTask(HeapZone_t zone) {
+    g_allocator.setTaskZone(zone);
+}
+
+void heapZoneClearTask(void) {
+    g_allocator.clearTaskZone();
+}
+
+HeapZone_t heapZoneGetTask(void) {
+    return g_allocator.getTaskZone();
+}
+
 UBaseType_t heapZoneGetCount(void) {
     return static_cast<UBaseType_t>(g_allocator.getZoneCount());
 }
@@ -365,4 +1973,24 @@ size_t heapZoneGetUsedBytes(UBaseType_t index) {
     return g_allocator.getZoneUsedBytes(static_cast<uint8_t>(index));
 }
 
+size_t heapZoneGetLargestFreeBlock(UBaseType_t index) {
+    return g_allocator.getZoneLargestFreeBytes(static_cast<uint8_t>(index));
+}
+
+size_t heapZoneGetSmallestFreeBlock(UBaseType_t index) {
+    return g_allocator.getZoneSmallestFreeBytes(static_cast<uint8_t>(index));
+}
+
+size_t heapZoneGetFreeBlockCount(UBaseType_t index) {
+    return g_allocator.getZoneFreeBlockCount(static_cast<uint8_t>(index));
+}
+
+size_t heapZoneGetQuarantineBytes(UBaseType_t index) {
+    return g_allocator.getZoneQuarantineBytes(static_cast<uint8_t>(index));
+}
+
+UBaseType_t heapZoneGetFragmentation(UBaseType_t index) {
+    return static_cast<UBaseType_t>(g_allocator.getZoneFragmentation(static_cast<uint8_t>(index)));
+}
+
 } // extern "C"
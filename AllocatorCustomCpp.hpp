@@ -3,7 +3,12 @@
  * @brief Мультизонный страничный аллокатор — публичный C++ API.
  *
  * Координирует несколько PageAllocator-ов (по одному на зону).
- * Все публичные методы потокобезопасны.
+ * Все публичные методы потокобезопасны: у каждой зоны свой лок
+ * (зона и её slab-ы), общий лок координатора — только для выбора
+ * маршрута и глобального состояния.
+ *
+ * При ALLOC_ENABLE_MAGAZINES мелкие alloc/free обслуживаются из
+ * магазинов ядра (или задачи) без приостановки планировщика.
  */
 #pragma once
 
@@ -11,6 +16,10 @@
 #include <cstdint>
 #include "AllocConf.h"
 #include "PageAllocator.hpp"
+#include "SlabAllocator.hpp"
+#include "Magazine.hpp"
+#include "DeferredFree.hpp"
+#include "HeapTrace.hpp"
 
 /*
  * FreeRTOS-заголовок нужен для HeapStats_t, HeapRegion_t, UBaseType_t.
@@ -41,11 +50,86 @@ public:
     void  deallocate(void* ptr);
     void* calloc(size_t num, size_t size);
 
+    /** Выделить в указанной зоне (маршрут с откатом — как у heapZoneSet). */
+    void* allocate(size_t size, HeapZone_t zone);
+    void* calloc(size_t num, size_t size, HeapZone_t zone);
+
+    /**
+     * Выделить область с данными, выровненными на alignment (степень
+     * двойки); освобождается обычным deallocate. alignment ≤
+     * ALLOC_MALLOC_ALIGNMENT — как allocate (тот же выбор slab/страниц,
+     * что у deallocateSized), иначе область страничная.
+     */
+    void* allocateAligned(size_t size, size_t alignment);
+    void* allocateAligned(size_t size, size_t alignment, HeapZone_t zone);
+
+    /**
+     * Освободить область, выделенную allocate(size, zone) или
+     * allocateAligned(size, alignment, zone) с теми же параметрами
+     * (alignment ≤ ALLOC_MALLOC_ALIGNMENT — обычный allocate). Для зон
+     * FAST/SLOW поиск зоны не нужен, slab или страницы — по size.
+     */
+    void  deallocateSized(void* ptr, size_t size, size_t alignment, HeapZone_t zone);
+
+    /**
+     * Изменить размер области. Сначала — на месте (страницы за областью
+     * или класс slab), иначе — новая область, копирование и освобождение.
+     * ptr == nullptr — как allocate, size == 0 — как deallocate.
+     * Выровненная область при переносе сохраняет выравнивание.
+     * При неудаче исходная область не изменяется, возвращается nullptr.
+     */
+    void* reallocate(void* ptr, size_t size);
+
+    /**
+     * Выделить до count областей по size байт с одним локом и одной
+     * проверкой целостности на зону; области по возможности смежны.
+     * @return Число выделенных (out[0..n)), остальные out[] = nullptr.
+     */
+    size_t allocateBatch(size_t size, size_t count, void** out);
+
+    /** Освободить n областей (nullptr пропускаются), лок — раз на зону. */
+    void   deallocateBatch(void* const* ptrs, size_t n);
+
     /* ── Статистика (потокобезопасно) ── */
 
     size_t getFreeHeapSize();
     size_t getMinimumEverFreeBytes();
     void   getHeapStats(HeapStats_t* stats);
+
+    /**
+     * Задержки операций зоны idx (ALLOC_ENABLE_LATENCY_STATS).
+     * @return false — замеры отключены или нет такой зоны (stats обнулена).
+     */
+    bool   getHeapLatencyStats(uint8_t idx, HeapLatencyStats_t* stats);
+    void   resetHeapLatencyStats();
+
+    /**
+     * Байты и области по задачам-владельцам, суммарно по зонам
+     * (ALLOC_ENABLE_TASK_STATS). Объекты slab не учитываются.
+     * @return Число записанных элементов (≤ maxCount).
+     */
+    size_t getTaskHeapStats(HeapTaskStats_t* out, size_t maxCount);
+
+    /**
+     * Обойти живые страничные области владельца owner (HEAP_TASK_OWNER_ANY —
+     * все). visitor вызывается под замком зоны и не должен трогать кучу.
+     * @return Число посещённых областей.
+     */
+    size_t walkTaskBlocks(uint32_t owner, HeapBlockVisitor_t visitor, void* context);
+
+    /** Записать адрес вызова в футер области (ALLOC_TRACK_CALLER_PC). */
+    void   tagCaller(void* ptr, uintptr_t callerPc);
+
+    /**
+     * Забрать до max записей трассы (ALLOC_ENABLE_TRACE). Потребитель —
+     * один; вызывать можно без ожидания, записи не блокируют аллокатор.
+     * @return Число записей в out.
+     */
+    size_t   readTrace(HeapTraceRecord_t* out, size_t max);
+
+    /** Записей трассы, потерянных из-за переполнения кольца. */
+    uint32_t traceDropped() const;
+
     size_t getTotalHeapSize();
     size_t getUsedHeapSize();
 
@@ -53,24 +137,154 @@ public:
 
     void       setZone(HeapZone_t zone);
     HeapZone_t getZone() const;
+
+    /**
+     * Зона по умолчанию текущей задачи — важнее глобальной setZone.
+     * Хранится в TLS FreeRTOS (ALLOC_ZONE_TLS_INDEX), на хосте — thread_local.
+     */
+    void       setTaskZone(HeapZone_t zone);
+    void       clearTaskZone();
+
+    /** Действующая зона текущей задачи: собственная или глобальная. */
+    HeapZone_t getTaskZone();
     uint8_t    getZoneCount() const;
 
     size_t getZoneFreeBytes(uint8_t index);
     size_t getZoneTotalBytes(uint8_t index);
     size_t getZoneMinFreeBytes(uint8_t index);
     size_t getZoneUsedBytes(uint8_t index);
+    size_t getZoneLargestFreeBytes(uint8_t index);
+    size_t getZoneSmallestFreeBytes(uint8_t index);
+    size_t getZoneFreeBlockCount(uint8_t index);
+    size_t getZoneQuarantineBytes(uint8_t index);
+
+    /**
+     * Индекс фрагментации зоны в промилле: 1000 · (1 − наибольший
+     * свободный участок / свободно). 0 — свободная память одним куском.
+     */
+    uint32_t getZoneFragmentation(uint8_t index);
+
+    /* ── Отложенное освобождение ── */
+
+    /**
+     * Обработать до max отложенных free (ALLOC_ENABLE_DEFERRED_FREE).
+     * Вызывается служебной задачей; на хосте — вручную.
+     * @return Число обработанных указателей.
+     */
+    size_t drainDeferredFrees(size_t max);
+
+    /* ── Перемещаемые области (ALLOC_ENABLE_HANDLES) ── */
+
+    /**
+     * Выделить страничную область по хендлу в зоне zone (маршрут — как
+     * у allocate, slab не используется). Адрес — только через lockHandle.
+     */
+    HeapHandle_t allocateHandle(size_t size, HeapZone_t zone);
+
+    /** Закрепить область (уплотнитель её не двигает) и вернуть адрес. */
+    void* lockHandle(HeapHandle_t handle);
+
+    /** Снять закрепление; после него адрес из lockHandle недействителен. */
+    void  unlockHandle(HeapHandle_t handle);
+
+    /** Освободить область хендла (незакреплённую). */
+    void  freeHandle(HeapHandle_t handle);
+
+    /**
+     * Шаг уплотнения всех зон: по ALLOC_COMPACT_STEP_PAGES на зону,
+     * под локом одной зоны за раз.
+     * @return Перемещено страниц.
+     */
+    size_t compactStep();
+
+    /**
+     * Шаг миграции (ALLOC_ENABLE_MIGRATION): горячие области SLOW (heat ≥
+     * ALLOC_MIGRATE_HOT_LOCKS) переносятся в FAST; при нехватке места
+     * в FAST туда уступают место холодные (heat ≤ ALLOC_MIGRATE_COLD_LOCKS).
+     * Не больше ALLOC_MIGRATE_STEP_BYTES за шаг, затем heat всех
+     * областей уменьшается вдвое.
+     * @return Перенесено областей.
+     */
+    size_t migrateStep();
+
+    /* ── Арены ── */
+
+    /**
+     * Создать арену: страничная область на capacity байт в зоне zone
+     * (не slab, даже для малых capacity).
+     * @return false — нет памяти (arena обнулена).
+     */
+    bool  createArena(HeapArena_t* arena, size_t capacity, HeapZone_t zone);
+
+    /**
+     * Выделить size байт сдвигом arena->used (alignment — степень двойки).
+     * Кучу не трогает: арена — одной задачи.
+     */
+    static void* arenaAllocate(HeapArena_t* arena, size_t size, size_t alignment);
+
+    /** Сбросить все объекты арены, область остаётся. */
+    void  resetArena(HeapArena_t* arena);
+
+    /** Освободить область арены (одна запись карантина). */
+    void  destroyArena(HeapArena_t* arena);
+
+    /* ── Магазины ── */
+
+    /**
+     * Слить магазины в slab-ы. На таргете — магазин текущего ядра
+     * (магазины других ядер доступны только с них самих), на хосте — все.
+     */
+    void flushMagazines();
+
+    /** Создать магазин текущей задачи (ALLOC_MAGAZINE_TLS_INDEX ≥ 0). */
+    bool attachTaskMagazine();
+
+    /**
+     * Слить и удалить магазин задачи (TaskHandle_t; nullptr — текущая).
+     * Вызывать перед удалением задачи. На хосте — только текущий поток.
+     */
+    void flushTaskMagazine(void* task);
 
     /* ── Диагностика ── */
 
-    /** Валидация всех зон (карантин + аллоцированные области). */
+    /**
+     * Порция инкрементальной проверки для idle-задачи (бюджет ×
+     * ALLOC_CHECK_IDLE_FACTOR). Зоны, занятые другими задачами, пропускаются.
+     */
+    bool idleCheck();
+
+    /** Валидация всех зон (карантин + аллоцированные области + slab-ы). */
     bool validateHeap();
 
     bool isInitialized() const;
 
 private:
     PageAllocator zones_[ALLOC_MAX_ZONES];
+    SlabAllocator slabs_[ALLOC_MAX_ZONES];
+#if ALLOC_ENABLE_DEFERRED_FREE
+    DeferredFreeQueue deferred_;
+#endif
+#if ALLOC_ENABLE_TRACE
+    TraceRing     trace_;
+#endif
+#if ALLOC_ENABLE_HANDLES
+    HandleDirectory handles_;
+#endif
+#if ALLOC_ENABLE_MAGAZINES
+    MagazineCache magazines_[ALLOC_MAGAZINE_CORES];
+    size_t        retiredCachedAllocs_;   /**< Счётчики удалённых магазинов задач */
+    size_t        retiredCachedFrees_;
+#endif
+    /** Адресный диапазон зоны: [lo, hi) допустимых указателей на payload. */
+    struct ZoneRange {
+        uintptr_t lo;
+        uintptr_t hi;
+        uint8_t   zone;
+    };
+
+    ZoneRange     zoneRanges_[ALLOC_MAX_ZONES];   /**< По возрастанию lo, activeZones_ штук */
     uint8_t       activeZones_;
-    HeapZone_t    currentZone_;
+    HeapZone_t    currentZone_;                   /**< Только __atomic_load_n/__atomic_store_n */
     bool          initialized_;
 
     struct ZoneRoute {
@@ -80,11 +294,81 @@ private:
     };
 
     ZoneRoute resolveRoute(HeapZone_t zone) const;
-    void*     allocateWithRoute(const ZoneRoute& route, size_t size);
+    HeapZone_t effectiveZone();
+    void*     allocateWithRoute(const ZoneRoute& route, size_t size, bool zeroed, size_t alignment);
+    void*     allocateInZone(uint8_t idx, size_t size, bool zeroed, size_t alignment);
+    size_t    allocateBatchInZone(uint8_t idx, size_t size, size_t count, void** out);
+
+    /** Зона-владелец указателя (двоичный поиск по zoneRanges_); activeZones_, если не найдена. */
+    uint8_t   findZone(const void* ptr) const;
+
+    /** Построить zoneRanges_ по инициализированным зонам. */
+    void      buildZoneRanges();
+
+    /** Освобождение без отложенной очереди. */
+    void      deallocateNow(void* ptr);
+
+    /** allocate / allocateAligned / deallocate без записи в трассу (для reallocate). */
+    void*     allocateUntraced(size_t size, HeapZone_t zone, size_t alignment);
+    void      deallocateUntraced(void* ptr);
+
+    /** deallocateBatch без записи в трассу (разбор отложенных free). */
+    void      deallocateBatchUntraced(void* const* ptrs, size_t n);
+
+    /**
+     * Записать событие в трассу (ALLOC_ENABLE_TRACE): зона, страницы и
+     * sequenceNum берутся из живой области ptr (nullptr — неудача).
+     */
+    void      traceEvent(uint8_t op, uint8_t flags, HeapZone_t route,
+                         const void* ptr, size_t size, size_t alignment);
+
+    /** Записать заголовок пакета (HEAP_TRACE_ALLOC_BATCH / HEAP_TRACE_FREE_BATCH). */
+    void      traceBatch(uint8_t op, HeapZone_t route, size_t size, size_t count);
+
+#if ALLOC_ENABLE_DEFERRED_FREE
+    /** Поставить free в очередь и разбудить служебную задачу. */
+    bool      deferFree(void* ptr);
+    void      startDeferredFreeTask();
+#endif
+
+#if ALLOC_ENABLE_HANDLES
+    HeapHandle_t allocateHandleInZone(uint8_t idx, size_t size);
+
+    /** Взять лок зоны, где сейчас живёт хендл; activeZones_ — хендл недействителен. */
+    uint8_t   lockHandleZone(HeapHandle_t handle);
+    void      startCompactTask();
+#endif
+#if ALLOC_ENABLE_MIGRATION
+    void      setHandleZone(HeapHandle_t handle, uint8_t zone);
+    static size_t handleBytes(const PageAllocator& zone, const HandleTable::Slot* slot);
+#endif
+
+#if ALLOC_ENABLE_MAGAZINES
+    /* ── Магазины ── */
+    MagazineCache* acquireMagazine(uint32_t* token);
+    void           releaseMagazine(MagazineCache* cache, uint32_t token);
+    MagazineCache* taskMagazine() const;
+    void*          allocateCached(uint8_t zone, size_t size);
+    bool           deallocateCached(uint8_t zone, void* ptr);
+    void           drainToSlab(uint8_t zone, void* const* items, uint16_t count);
+    void           flushCache(MagazineCache* cache);
+#endif
 
+    /*
+     * Порядок блокировок: локи зон — по возрастанию индекса,
+     * лок координатора — всегда внутренний (после локов зон).
+     */
     void lock();
     void unlock();
+    bool acquireZone(uint8_t idx);     /**< false — планировщик приостановлен, зона занята */
+    void lockZone(uint8_t idx);
+    bool tryLockZone(uint8_t idx);
+    void unlockZone(uint8_t idx);
+    bool lockZoneForFree(uint8_t idx, void* ptr); /**< false — free отложен или невозможен */
+    void lockAllZones();
+    void unlockAllZones();
     void assertNotISR() const;
+    static bool inISR();
 };
 
 } // namespace AllocCustom
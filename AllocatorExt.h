@@ -0,0 +1,192 @@
+/**
+ * @file AllocatorExt.h
+ * @brief Расширенный C-интерфейс аллокатора (сверх API heap_x FreeRTOS).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "AllocTypes.h"
+#include "AllocatorZones.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ── Выровненное выделение ── */
+
+/**
+ * Выделить xWantedSize байт с адресом, кратным xAlignment (степень двойки):
+ * DMA-дескрипторы, строки кэша, MPU-регионы. Освобождать через vPortFree.
+ */
+void *     pvPortMallocAligned(size_t xWantedSize, size_t xAlignment);
+
+/** То же в зоне zone (маршрут — как у pvPortMallocZone). */
+void *     pvPortMallocZoneAligned(size_t xWantedSize, size_t xAlignment, HeapZone_t zone);
+
+/**
+ * Освобождение с известным размером: pv выделен pvPortMallocZone(xWantedSize,
+ * zone) (xAlignment ≤ ALLOC_MALLOC_ALIGNMENT) или pvPortMallocZoneAligned с
+ * теми же аргументами. Для HEAP_ZONE_FAST/SLOW зона и путь slab/страницы
+ * определяются без поиска по хедеру.
+ */
+void       vPortFreeSized(void * pv, size_t xWantedSize, size_t xAlignment, HeapZone_t zone);
+
+/* ── Изменение размера ── */
+
+/**
+ * Изменить размер области (по возможности — на месте).
+ * pv == NULL — как pvPortMalloc, xWantedSize == 0 — как vPortFree.
+ * При неудаче исходная область сохраняется, возвращается NULL.
+ */
+void *     pvPortRealloc(void * pv, size_t xWantedSize);
+
+/* ── Пакетные операции ── */
+
+/**
+ * Выделить до xCount областей по xWantedSize байт за один лок.
+ * @return Число выделенных (ppvOut[0..n)), остальные ppvOut[] = NULL.
+ */
+size_t     xPortMallocBatch(size_t xWantedSize, size_t xCount, void ** ppvOut);
+
+/** Освободить xCount областей (NULL пропускаются). */
+void       vPortFreeBatch(void * const * ppv, size_t xCount);
+
+/* ── Отложенное освобождение (ALLOC_ENABLE_DEFERRED_FREE) ── */
+
+/**
+ * Обработать все отложенные free в контексте вызывающей задачи.
+ * Обычно их разбирает служебная задача «heapFree».
+ * @return Число обработанных указателей.
+ */
+size_t     heapDeferredFreeDrain(void);
+
+/* ── Перемещаемые области (ALLOC_ENABLE_HANDLES) ── */
+
+/**
+ * Выделить страничную область, которую уплотнитель может перемещать.
+ * Адрес получают только через heapHandleLock и держат до heapHandleUnlock;
+ * освобождать — heapHandleFree (не vPortFree).
+ * @return Хендл или HEAP_HANDLE_INVALID.
+ */
+HeapHandle_t heapHandleAlloc(size_t xWantedSize, HeapZone_t zone);
+
+/** Закрепить область и вернуть её адрес (NULL — хендл недействителен). Вложенные lock допустимы. */
+void *     heapHandleLock(HeapHandle_t xHandle);
+
+/** Снять закрепление: адрес из heapHandleLock больше использовать нельзя. */
+void       heapHandleUnlock(HeapHandle_t xHandle);
+
+/** Освободить незакреплённую область хендла. */
+void       heapHandleFree(HeapHandle_t xHandle);
+
+/**
+ * Шаг уплотнения всех зон (≤ ALLOC_COMPACT_STEP_PAGES страниц на зону).
+ * Вызывает задача «heapCompact» (ALLOC_COMPACT_PERIOD_MS > 0) или приложение
+ * из низкоприоритетной задачи.
+ * @return Перемещено страниц.
+ */
+size_t     heapCompactStep(void);
+
+/**
+ * Шаг миграции (ALLOC_ENABLE_MIGRATION): частые heapHandleLock делают
+ * область горячей — горячие переносятся из SLOW в FAST, холодные
+ * уступают им место. Задача «heapCompact» вызывает его перед
+ * heapCompactStep.
+ * @return Перенесено областей.
+ */
+size_t     heapMigrateStep(void);
+
+/* ── Арены ── */
+
+/**
+ * Создать арену на xCapacity байт: одна страничная область в зоне zone
+ * (маршрут с откатом — как у pvPortMallocZone).
+ * @return pdFALSE — нет памяти (pxArena->base == NULL).
+ */
+BaseType_t heapArenaCreate(HeapArena_t * pxArena, size_t xCapacity, HeapZone_t zone);
+
+/** Выделить xSize байт (выравнивание ALLOC_ARENA_ALIGNMENT); NULL — арена заполнена. */
+void *     heapArenaAlloc(HeapArena_t * pxArena, size_t xSize);
+
+/** Выделить xSize байт с адресом, кратным xAlignment (степень двойки). */
+void *     heapArenaAllocAligned(HeapArena_t * pxArena, size_t xSize, size_t xAlignment);
+
+/**
+ * Освободить все объекты арены, сохранив область. При ALLOC_FILL_ON_FREE
+ * занятая часть заливается карантинным паттерном.
+ */
+void       heapArenaReset(HeapArena_t * pxArena);
+
+/**
+ * Вернуть область арены в кучу — одна запись карантина на все объекты,
+ * проверка хедера/футера — как у vPortFree.
+ */
+void       heapArenaDestroy(HeapArena_t * pxArena);
+
+/* ── Диагностика ── */
+
+/**
+ * Гистограммы задержек зоны uxZone (ALLOC_ENABLE_LATENCY_STATS):
+ * alloc/free, поиск участка, проверки, вытеснение карантина.
+ * Тики — такты DWT->CYCCNT (частота — pxStats->ticksPerSecond).
+ * @return pdFALSE — замеры отключены или нет такой зоны.
+ */
+BaseType_t xPortGetHeapLatencyStats(UBaseType_t uxZone, HeapLatencyStats_t * pxStats);
+
+/** Обнулить гистограммы задержек всех зон. */
+void       vPortResetHeapLatencyStats(void);
+
+/**
+ * Занятые страницы по задачам (ALLOC_ENABLE_TASK_STATS), суммарно по зонам.
+ * Владелец — TaskHandle_t выделявшей задачи; HEAP_TASK_OWNER_NONE — до
+ * старта планировщика и страницы slab-ов, HEAP_TASK_OWNER_OTHER — задачи
+ * сверх ALLOC_TASK_STATS_SLOTS. Объекты slab в счётчики не попадают.
+ * @return Число записанных элементов (≤ uxMax).
+ */
+UBaseType_t heapTaskGetStats(HeapTaskStats_t * pxStats, UBaseType_t uxMax);
+
+/**
+ * Обойти живые страничные области задачи ulOwner (HEAP_TASK_OWNER_ANY — все).
+ * pxVisitor вызывается под замком зоны: обращаться к куче из него нельзя.
+ * Дамп по задачам — heapTaskGetStats, затем обход для каждого владельца.
+ * @return Число посещённых областей.
+ */
+size_t     heapTaskWalkBlocks(uint32_t ulOwner, HeapBlockVisitor_t pxVisitor, void * pvContext);
+
+/* ── Трасса (ALLOC_ENABLE_TRACE) ── */
+
+/**
+ * Забрать до xMax записей трассы. Один потребитель — задача, которая
+ * пишет их как есть в SEGGER RTT / ITM / UART DMA; на хосте трасса
+ * воспроизводится bench/TraceReplay.cpp. Не блокируется.
+ * @return Число записей в pxOut.
+ */
+size_t     heapTraceRead(HeapTraceRecord_t * pxOut, size_t xMax);
+
+/** Записей, потерянных из-за переполнения кольца (ALLOC_TRACE_CAPACITY). */
+uint32_t   heapTraceGetDropped(void);
+
+/**
+ * Порция инкрементальной проверки целостности. Вызывать из
+ * vApplicationIdleHook: не блокируется, занятые зоны пропускает.
+ * @return pdFALSE при обнаружении порчи.
+ */
+BaseType_t heapIdleCheck(void);
+
+/* ── Магазины (ALLOC_ENABLE_MAGAZINES) ── */
+
+/** Вернуть объекты из магазина текущего ядра в slab-ы. */
+void       heapMagazineFlush(void);
+
+/** Создать магазин текущей задачи (ALLOC_MAGAZINE_TLS_INDEX ≥ 0). */
+BaseType_t heapMagazineAttachTask(void);
+
+/** Слить и удалить магазин задачи (NULL — текущая). До vTaskDelete. */
+void       heapMagazineDetachTask(void* xTask);
+
+#ifdef __cplusplus
+}
+#endif
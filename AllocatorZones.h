@@ -26,13 +26,39 @@ typedef enum {
     HEAP_ZONE_SLOW_PREFER = 4   /**< Медленная с откатом. */
 } HeapZone_t;
 
+/** Глобальная зона по умолчанию (для задач без собственной). */
 void        heapZoneSet(HeapZone_t zone);
 HeapZone_t  heapZoneGet(void);
+
+/**
+ * Зона по умолчанию текущей задачи (ALLOC_ZONE_TLS_INDEX ≥ 0).
+ * heapZoneGetTask возвращает действующую зону: задачи или глобальную.
+ */
+void        heapZoneSetTask(HeapZone_t zone);
+void        heapZoneClearTask(void);
+HeapZone_t  heapZoneGetTask(void);
+
+/** Выделить память в указанной зоне, не меняя зону по умолчанию. */
+void *      pvPortMallocZone(size_t xWantedSize, HeapZone_t zone);
+void *      pvPortCallocZone(size_t xNum, size_t xSize, HeapZone_t zone);
+
 UBaseType_t heapZoneGetCount(void);
 size_t      heapZoneGetFreeBytes(UBaseType_t index);
 size_t      heapZoneGetTotalBytes(UBaseType_t index);
 size_t      heapZoneGetMinimumFreeBytes(UBaseType_t index);
 size_t      heapZoneGetUsedBytes(UBaseType_t index);
+size_t      heapZoneGetLargestFreeBlock(UBaseType_t index);
+size_t      heapZoneGetSmallestFreeBlock(UBaseType_t index);
+size_t      heapZoneGetFreeBlockCount(UBaseType_t index);
+
+/**
+ * Байт в карантине (и ожидающих очистки) — вернутся в свободные сами,
+ * в heapZoneGetFreeBytes не входят.
+ */
+size_t      heapZoneGetQuarantineBytes(UBaseType_t index);
+
+/** Фрагментация свободной памяти зоны, промилле (0 — одним куском). */
+UBaseType_t heapZoneGetFragmentation(UBaseType_t index);
 
 #ifdef __cplusplus
 }
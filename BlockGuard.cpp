@@ -5,8 +5,93 @@
 #include "BlockGuard.hpp"
 #include <cstring>
 
+#if ALLOC_PATTERN_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#define ALLOC_PATTERN_SSE2 1
+#elif ALLOC_PATTERN_SIMD && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ALLOC_PATTERN_NEON 1
+#endif
+
 namespace AllocCustom {
 
+/* ───────── Проверка паттерна ───────── */
+
+namespace {
+
+/* Машинное слово, которому разрешено алиасить любые данные */
+typedef uintptr_t __attribute__((__may_alias__)) PatternWord;
+
+constexpr size_t kWordSize = sizeof(PatternWord);
+
+/** Байт паттерна, размноженный на всё слово. */
+constexpr PatternWord broadcast(uint8_t byte) {
+    return static_cast<PatternWord>(~static_cast<PatternWord>(0) / 0xFFU) * byte;
+}
+
+/**
+ * Все size байт равны byte. Голова и хвост — побайтно до границы слова,
+ * середина — словами (или векторами) с накоплением отличий, чтобы ветвление
+ * было одно на блок, а не на байт.
+ */
+bool matchesPattern(const void* start, size_t size, uint8_t byte) {
+    const auto* p   = static_cast<const uint8_t*>(start);
+    const auto* end = p + size;
+
+    /* Голова до выравнивания */
+    while (p < end && (reinterpret_cast<uintptr_t>(p) % kWordSize) != 0U) {
+        if (*p++ != byte) return false;
+    }
+
+#if defined(ALLOC_PATTERN_SSE2)
+    {
+        const __m128i pat = _mm_set1_epi8(static_cast<char>(byte));
+        while (p + 64U <= end) {
+            const auto* v = reinterpret_cast<const __m128i*>(p);
+            const __m128i eq = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(v + 0), pat),
+                              _mm_cmpeq_epi8(_mm_loadu_si128(v + 1), pat)),
+                _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(v + 2), pat),
+                              _mm_cmpeq_epi8(_mm_loadu_si128(v + 3), pat)));
+            if (_mm_movemask_epi8(eq) != 0xFFFF) return false;
+            p += 64U;
+        }
+    }
+#elif defined(ALLOC_PATTERN_NEON)
+    {
+        const uint8x16_t pat = vdupq_n_u8(byte);
+        while (p + 64U <= end) {
+            const uint8x16_t diff = vorrq_u8(
+                vorrq_u8(veorq_u8(vld1q_u8(p +  0), pat), veorq_u8(vld1q_u8(p + 16), pat)),
+                vorrq_u8(veorq_u8(vld1q_u8(p + 32), pat), veorq_u8(vld1q_u8(p + 48), pat)));
+            const uint64x2_t d64 = vreinterpretq_u64_u8(diff);
+            if ((vgetq_lane_u64(d64, 0) | vgetq_lane_u64(d64, 1)) != 0U) return false;
+            p += 64U;
+        }
+    }
+#endif
+
+    /* Середина — по 4 слова за итерацию */
+    const PatternWord pat = broadcast(byte);
+    while (p + 4U * kWordSize <= end) {
+        const auto* w = reinterpret_cast<const PatternWord*>(p);
+        if (((w[0] ^ pat) | (w[1] ^ pat) | (w[2] ^ pat) | (w[3] ^ pat)) != 0U) return false;
+        p += 4U * kWordSize;
+    }
+    while (p + kWordSize <= end) {
+        if (*reinterpret_cast<const PatternWord*>(p) != pat) return false;
+        p += kWordSize;
+    }
+
+    /* Хвост */
+    while (p < end) {
+        if (*p++ != byte) return false;
+    }
+    return true;
+}
+
+} // namespace
+
 /* ───────── Контрольная сумма ───────── */
 
 uint32_t BlockGuard::computeChecksum(const void* block, size_t blockSize) {
@@ -14,47 +99,67 @@ uint32_t BlockGuard::computeChecksum(const void* block, size_t blockSize) {
     const size_t wordCount = blockSize / sizeof(uint32_t);
     ALLOC_ASSERT(wordCount >= 2U);
 
-    uint32_t result = 0U;
-    for (size_t i = 0U; i + 1U < wordCount; ++i) {
-        result ^= w[i];
+    /* Два независимых аккумулятора — без цепочки зависимостей по XOR */
+    uint32_t even = 0U;
+    uint32_t odd  = 0U;
+    size_t i = 0U;
+    for (; i + 2U < wordCount; i += 2U) {
+        even ^= w[i];
+        odd  ^= w[i + 1U];
     }
-    return result;
+    if (i + 1U < wordCount) {
+        even ^= w[i];
+    }
+    return even ^ odd;
 }
 
 /* ───────── Запись ───────── */
 
 void BlockGuard::writeHeader(void* dest, uint32_t requestedSize,
-                              uint16_t startPage, uint16_t pageCount,
-                              uint8_t zoneIndex, uint32_t sequenceNum) {
+                              uint32_t startPage, uint32_t pageCount,
+                              uint8_t zoneIndex, uint32_t sequenceNum,
+                              uint16_t headOffset, uint8_t flags,
+                              uint32_t ownerTask) {
     auto* h = static_cast<AllocBlockHeader*>(dest);
     h->magic         = ALLOC_PATTERN_HEADER_MAGIC;
     h->requestedSize = requestedSize;
     h->startPage     = startPage;
     h->pageCount     = pageCount;
     h->zoneIndex     = zoneIndex;
-    std::memset(h->reserved, 0, sizeof(h->reserved));
+    h->flags         = flags;
+    h->headOffset    = headOffset;
     h->sequenceNum   = sequenceNum;
-    h->reserved2     = 0U;
-    h->reserved3     = 0U;
+    h->ownerTask     = ownerTask;
     h->checksum      = computeChecksum(h, sizeof(AllocBlockHeader));
 }
 
 void BlockGuard::writeFooter(void* dest, uint32_t requestedSize,
-                              uint16_t startPage, uint16_t pageCount,
-                              uint8_t zoneIndex, uint32_t sequenceNum) {
+                              uint32_t startPage, uint32_t pageCount,
+                              uint8_t zoneIndex, uint32_t sequenceNum,
+                              uint16_t headOffset, uint8_t flags,
+                              uint32_t callerPc) {
     auto* f = static_cast<AllocBlockFooter*>(dest);
     f->magic         = ALLOC_PATTERN_FOOTER_MAGIC;
     f->requestedSize = requestedSize;
     f->startPage     = startPage;
     f->pageCount     = pageCount;
     f->zoneIndex     = zoneIndex;
-    std::memset(f->reserved, 0, sizeof(f->reserved));
+    f->flags         = flags;
+    f->headOffset    = headOffset;
     f->sequenceNum   = sequenceNum;
-    f->reserved2     = 0U;
-    f->reserved3     = 0U;
+    f->callerPc      = callerPc;
     f->checksum      = computeChecksum(f, sizeof(AllocBlockFooter));
 }
 
+void BlockGuard::writeLead(void* pageStart, uint16_t headOffset) {
+    ALLOC_ASSERT(headOffset >= sizeof(AllocLeadMarker));
+    auto* m = static_cast<AllocLeadMarker*>(pageStart);
+    m->magic      = ALLOC_PATTERN_LEAD_MAGIC;
+    m->headOffset = headOffset;
+    m->check      = static_cast<uint16_t>(~headOffset);
+    fillPadding(m + 1, headOffset - sizeof(AllocLeadMarker));
+}
+
 /* ───────── Валидация ───────── */
 
 bool BlockGuard::validateHeader(const void* headerPtr) {
@@ -76,9 +181,21 @@ bool BlockGuard::validatePair(const AllocBlockHeader* header,
     if (header->pageCount     != footer->pageCount)     return false;
     if (header->zoneIndex     != footer->zoneIndex)     return false;
     if (header->sequenceNum   != footer->sequenceNum)   return false;
+    if (header->flags         != footer->flags)         return false;
+    if (header->headOffset    != footer->headOffset)    return false;
     return true;
 }
 
+bool BlockGuard::validateLead(const void* pageStart, uint16_t headOffset) {
+    if (headOffset == 0U) return true;
+    if (headOffset < sizeof(AllocLeadMarker)) return false;
+
+    const auto* m = static_cast<const AllocLeadMarker*>(pageStart);
+    if (m->magic != ALLOC_PATTERN_LEAD_MAGIC) return false;
+    if (m->headOffset != headOffset || m->check != static_cast<uint16_t>(~headOffset)) return false;
+    return validatePadding(m + 1, headOffset - sizeof(AllocLeadMarker));
+}
+
 /* ───────── Паттерны ───────── */
 
 void BlockGuard::fillPadding(void* paddingStart, size_t size) {
@@ -94,19 +211,11 @@ void BlockGuard::fillClearedPages(void* start, size_t size) {
 }
 
 bool BlockGuard::validatePadding(const void* paddingStart, size_t size) {
-    const auto* p = static_cast<const uint8_t*>(paddingStart);
-    for (size_t i = 0; i < size; ++i) {
-        if (p[i] != ALLOC_PATTERN_PADDING) return false;
-    }
-    return true;
+    return matchesPattern(paddingStart, size, ALLOC_PATTERN_PADDING);
 }
 
 bool BlockGuard::validateQuarantinePayload(const void* start, size_t size) {
-    const auto* p = static_cast<const uint8_t*>(start);
-    for (size_t i = 0; i < size; ++i) {
-        if (p[i] != ALLOC_PATTERN_QUARANTINE_FILL) return false;
-    }
-    return true;
+    return matchesPattern(start, size, ALLOC_PATTERN_QUARANTINE_FILL);
 }
 
 /* ───────── Навигация ───────── */
@@ -129,6 +238,15 @@ const AllocBlockHeader* BlockGuard::headerFromUserData(const void* userData) {
         static_cast<const uint8_t*>(userData) - ALLOC_HEADER_SIZE);
 }
 
+const AllocBlockHeader* BlockGuard::headerAtPage(const void* pageStart) {
+    const auto* m = static_cast<const AllocLeadMarker*>(pageStart);
+    if (m->magic == ALLOC_PATTERN_LEAD_MAGIC && m->check == static_cast<uint16_t>(~m->headOffset)) {
+        return reinterpret_cast<const AllocBlockHeader*>(
+            static_cast<const uint8_t*>(pageStart) + m->headOffset);
+    }
+    return static_cast<const AllocBlockHeader*>(pageStart);
+}
+
 AllocBlockFooter* BlockGuard::footerFromHeader(AllocBlockHeader* header) {
     return reinterpret_cast<AllocBlockFooter*>(
         reinterpret_cast<uint8_t*>(header) + ALLOC_HEADER_SIZE + header->requestedSize);
@@ -149,9 +267,10 @@ const void* BlockGuard::paddingFromHeader(const AllocBlockHeader* header) {
            ALLOC_HEADER_SIZE + header->requestedSize + ALLOC_FOOTER_SIZE;
 }
 
-size_t BlockGuard::paddingSize(const AllocBlockHeader* header) {
-    const size_t totalBytes = static_cast<size_t>(header->pageCount) * ALLOC_PAGE_SIZE;
-    const size_t usedBytes  = ALLOC_HEADER_SIZE + header->requestedSize + ALLOC_FOOTER_SIZE;
+size_t BlockGuard::paddingSize(const AllocBlockHeader* header, size_t pageSize) {
+    const size_t totalBytes = static_cast<size_t>(header->pageCount) * pageSize;
+    const size_t usedBytes  = header->headOffset +
+                              ALLOC_HEADER_SIZE + header->requestedSize + ALLOC_FOOTER_SIZE;
     ALLOC_ASSERT(totalBytes >= usedBytes);
     return totalBytes - usedBytes;
 }
@@ -25,12 +25,19 @@ struct BlockGuard {
     /* ── Запись ── */
 
     static void writeHeader(void* dest, uint32_t requestedSize,
-                            uint16_t startPage, uint16_t pageCount,
-                            uint8_t zoneIndex, uint32_t sequenceNum);
+                            uint32_t startPage, uint32_t pageCount,
+                            uint8_t zoneIndex, uint32_t sequenceNum,
+                            uint16_t headOffset, uint8_t flags,
+                            uint32_t ownerTask);
 
     static void writeFooter(void* dest, uint32_t requestedSize,
-                            uint16_t startPage, uint16_t pageCount,
-                            uint8_t zoneIndex, uint32_t sequenceNum);
+                            uint32_t startPage, uint32_t pageCount,
+                            uint8_t zoneIndex, uint32_t sequenceNum,
+                            uint16_t headOffset, uint8_t flags,
+                            uint32_t callerPc);
+
+    /** Маркер и паттерн перед смещённым хедером (headOffset ≥ sizeof(AllocLeadMarker)). */
+    static void writeLead(void* pageStart, uint16_t headOffset);
 
     /* ── Валидация ── */
 
@@ -39,6 +46,9 @@ struct BlockGuard {
     static bool validatePair(const AllocBlockHeader* header,
                              const AllocBlockFooter* footer);
 
+    /** Маркер и паттерн перед хедером области (headOffset == 0 — всегда true). */
+    static bool validateLead(const void* pageStart, uint16_t headOffset);
+
     /* ── Паттерны ── */
 
     static void fillPadding(void* paddingStart, size_t size);
@@ -59,10 +69,17 @@ struct BlockGuard {
     static AllocBlockFooter*       footerFromHeader(AllocBlockHeader* header);
     static const AllocBlockFooter* footerFromHeader(const AllocBlockHeader* header);
 
+    /**
+     * Хедер области, начинающейся на странице pageStart: в начале
+     * страницы или по маркеру AllocLeadMarker. Содержимое не проверяется.
+     */
+    static const AllocBlockHeader* headerAtPage(const void* pageStart);
+
     static void*                   paddingFromHeader(AllocBlockHeader* header);
     static const void*             paddingFromHeader(const AllocBlockHeader* header);
 
-    static size_t paddingSize(const AllocBlockHeader* header);
+    /** Байт паддинга после футера (pageSize — размер страницы зоны). */
+    static size_t paddingSize(const AllocBlockHeader* header, size_t pageSize);
 };
 
 } // namespace AllocCustom
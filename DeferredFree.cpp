@@ -0,0 +1,65 @@
+/**
+ * @file DeferredFree.cpp
+ * @brief Реализация lock-free очереди отложенных free.
+ */
+#include "DeferredFree.hpp"
+
+namespace AllocCustom {
+
+static_assert(ALLOC_DEFERRED_FREE_CAPACITY >= 2U &&
+              (ALLOC_DEFERRED_FREE_CAPACITY & (ALLOC_DEFERRED_FREE_CAPACITY - 1U)) == 0U,
+              "ALLOC_DEFERRED_FREE_CAPACITY должен быть степенью двойки");
+
+void DeferredFreeQueue::init() {
+    for (uint32_t i = 0; i < kCapacity; ++i) {
+        cells[i].seq = i;
+        cells[i].ptr = nullptr;
+    }
+    head = 0U;
+    __atomic_store_n(&tail, 0U, __ATOMIC_RELEASE);
+}
+
+bool DeferredFreeQueue::push(void* ptr) {
+    uint32_t pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    Cell* cell;
+    for (;;) {
+        cell = &cells[pos & kMask];
+        const uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        const auto diff = static_cast<int32_t>(seq - pos);
+        if (diff == 0) {
+            /* Ячейка свободна — занять позицию */
+            if (__atomic_compare_exchange_n(&tail, &pos, pos + 1U, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;   /* Потребитель ещё не освободил ячейку — очередь полна */
+        } else {
+            pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->ptr = ptr;
+    __atomic_store_n(&cell->seq, pos + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t DeferredFreeQueue::pop(void** out, size_t max) {
+    size_t n = 0U;
+    while (n < max) {
+        Cell* cell = &cells[head & kMask];
+        const uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        if (seq != head + 1U) break;   /* Пусто или ячейка ещё не опубликована */
+
+        out[n++] = cell->ptr;
+        __atomic_store_n(&cell->seq, head + kCapacity, __ATOMIC_RELEASE);
+        ++head;
+    }
+    return n;
+}
+
+bool DeferredFreeQueue::isEmpty() const {
+    return __atomic_load_n(&cells[head & kMask].seq, __ATOMIC_ACQUIRE) != head + 1U;
+}
+
+} // namespace AllocCustom
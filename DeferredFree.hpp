@@ -0,0 +1,50 @@
+/**
+ * @file DeferredFree.hpp
+ * @brief Lock-free очередь отложенных free (POD, trivially constructible).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+
+namespace AllocCustom {
+
+/**
+ * @brief Ограниченная MPSC-очередь указателей.
+ *
+ * Производители — задачи и ISR (любое ядро), потребитель — один
+ * (служебная задача). Ячейка несёт номер поколения: производитель
+ * занимает позицию CAS-ом на tail и публикует ячейку записью seq,
+ * поэтому вытеснение производителя посреди push не ломает очередь —
+ * потребитель просто остановится на неопубликованной ячейке.
+ *
+ * Требует атомарного CAS (LDREX/STREX: Cortex-M3 и старше).
+ * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
+ */
+struct DeferredFreeQueue {
+    static constexpr uint32_t kCapacity = ALLOC_DEFERRED_FREE_CAPACITY;
+    static constexpr uint32_t kMask     = kCapacity - 1U;
+
+    struct Cell {
+        uint32_t seq;   /**< Поколение ячейки */
+        void*    ptr;
+    };
+
+    Cell     cells[kCapacity];
+    uint32_t head;      /**< Позиция потребителя */
+    uint32_t tail;      /**< Следующая позиция производителя */
+
+    void init();
+
+    /** Поставить указатель в очередь (ISR-safe); false — очередь полна. */
+    bool push(void* ptr);
+
+    /** Забрать до max указателей (только потребитель). */
+    size_t pop(void** out, size_t max);
+
+    /** Очередь пуста (оценка — без синхронизации с производителями). */
+    bool isEmpty() const;
+};
+
+} // namespace AllocCustom
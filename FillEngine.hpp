@@ -0,0 +1,36 @@
+/**
+ * @file FillEngine.hpp
+ * @brief Абстракция аппаратной заливки памяти паттерном (DMA/MDMA).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+
+namespace AllocCustom {
+
+/**
+ * @brief Асинхронная заливка памяти байтом-паттерном.
+ *
+ * На целевом MCU — канал DMA/MDMA (реализация в отдельном .cpp).
+ * На хосте — заглушка (FillEngineStub.cpp): заливку выполняет CPU.
+ * Вызывается под локом зоны: start()/done() не должны блокироваться.
+ */
+struct FillEngine {
+    /**
+     * Начать заливку size байт по адресу dst.
+     * @return Номер заливки (≥ 0) или -1, если канал занят/недоступен.
+     */
+    static int  start(void* dst, uint8_t pattern, size_t size);
+
+    /** Заливка завершена (номер освобождается при первом true). */
+    static bool done(int ticket);
+
+    /** Дождаться завершения заливки. */
+    static void wait(int ticket);
+
+    static bool available();
+};
+
+} // namespace AllocCustom
@@ -0,0 +1,14 @@
+/**
+ * @file FillEngineStub.cpp
+ * @brief Заглушка FillEngine (DMA недоступен или HOST_BUILD).
+ */
+#include "FillEngine.hpp"
+
+namespace AllocCustom {
+
+int  FillEngine::start(void* /*dst*/, uint8_t /*pattern*/, size_t /*size*/) { return -1; }
+bool FillEngine::done(int /*ticket*/) { return true; }
+void FillEngine::wait(int /*ticket*/) {}
+bool FillEngine::available() { return false; }
+
+} // namespace AllocCustom
@@ -0,0 +1,164 @@
+/**
+ * @file FreeExtentIndex.cpp
+ * @brief Реализация сегрегированного индекса свободных участков.
+ */
+#include "FreeExtentIndex.hpp"
+
+namespace AllocCustom {
+
+static_assert(ALLOC_FREE_EXTENT_CAPACITY > 0U &&
+              ALLOC_FREE_EXTENT_CAPACITY < FreeExtentIndex::kNone,
+              "ALLOC_FREE_EXTENT_CAPACITY вне диапазона");
+
+/* ───────── Инициализация ───────── */
+
+void FreeExtentIndex::init() {
+    for (uint16_t i = 0; i < ALLOC_FREE_EXTENT_CAPACITY; ++i) {
+        nodes[i].start  = 0U;
+        nodes[i].length = 0U;
+        nodes[i].next   = static_cast<uint16_t>(i + 1U < ALLOC_FREE_EXTENT_CAPACITY ? i + 1U : kNone);
+        nodes[i].prev   = kNone;
+    }
+    for (uint8_t b = 0; b < kBinCount; ++b) {
+        binHead[b] = kNone;
+    }
+    binMask     = 0U;
+    freeHead    = 0U;
+    extentCount = 0U;
+    complete    = true;
+}
+
+void FreeExtentIndex::rebuild(const PageBitmap& inUse) {
+    init();
+    uint32_t page = inUse.nextClear(0U);
+    while (page < inUse.pageCount) {
+        const uint32_t len = inUse.clearRunFrom(page);
+        insert(page, len);
+        page = inUse.nextClear(page + len);
+    }
+}
+
+/* ───────── Классы ───────── */
+
+uint8_t FreeExtentIndex::binFor(uint32_t length) {
+    ALLOC_ASSERT(length > 0U);
+    return static_cast<uint8_t>(31 - __builtin_clz(length));
+}
+
+uint16_t FreeExtentIndex::bestInBin(uint8_t bin, uint32_t minLength) const {
+    uint16_t best = kNone;
+    for (uint16_t i = binHead[bin]; i != kNone; i = nodes[i].next) {
+        if (nodes[i].length < minLength) continue;
+#if ALLOC_FIT_POLICY == ALLOC_FIT_BEST
+        if (best == kNone || nodes[i].length < nodes[best].length) {
+            best = i;
+            if (nodes[i].length == minLength) break;
+        }
+#else
+        best = i;
+        break;
+#endif
+    }
+    return best;
+}
+
+/* ───────── Поиск ───────── */
+
+int32_t FreeExtentIndex::find(uint32_t count) const {
+    if (count == 0U) return -1;
+
+    /* Сначала свой класс: в нём участки могут оказаться короче count */
+    const uint8_t bin = binFor(count);
+    uint16_t idx = bestInBin(bin, count);
+    if (idx != kNone) {
+        return static_cast<int32_t>(nodes[idx].start);
+    }
+
+    /* Любой участок старших классов заведомо подходит */
+    const uint32_t upper = (bin + 1U < kBinCount) ? (binMask & ~((2U << bin) - 1U)) : 0U;
+    if (upper == 0U) return -1;
+
+    const auto upperBin = static_cast<uint8_t>(__builtin_ctz(upper));
+    idx = bestInBin(upperBin, count);
+    ALLOC_ASSERT(idx != kNone);
+    return static_cast<int32_t>(nodes[idx].start);
+}
+
+uint32_t FreeExtentIndex::largest() const {
+    if (binMask == 0U) return 0U;
+    const auto top = static_cast<uint8_t>(31 - __builtin_clz(binMask));
+    uint32_t best = 0U;
+    for (uint16_t i = binHead[top]; i != kNone; i = nodes[i].next) {
+        if (nodes[i].length > best) best = nodes[i].length;
+    }
+    return best;
+}
+
+uint32_t FreeExtentIndex::smallest() const {
+    if (binMask == 0U) return 0U;
+    const auto bottom = static_cast<uint8_t>(__builtin_ctz(binMask));
+    uint32_t best = UINT32_MAX;
+    for (uint16_t i = binHead[bottom]; i != kNone; i = nodes[i].next) {
+        if (nodes[i].length < best) best = nodes[i].length;
+    }
+    return best;
+}
+
+/* ───────── Модификация ───────── */
+
+void FreeExtentIndex::insert(uint32_t start, uint32_t length) {
+    if (length == 0U) return;
+    if (freeHead == kNone) {
+        complete = false;   /* Участок останется только в битовой карте */
+        return;
+    }
+
+    const uint16_t idx = freeHead;
+    freeHead = nodes[idx].next;
+
+    const uint8_t bin = binFor(length);
+    nodes[idx].start  = start;
+    nodes[idx].length = length;
+    nodes[idx].prev   = kNone;
+    nodes[idx].next   = binHead[bin];
+    if (binHead[bin] != kNone) {
+        nodes[binHead[bin]].prev = idx;
+    }
+    binHead[bin] = idx;
+    binMask |= (1U << bin);
+    ++extentCount;
+}
+
+bool FreeExtentIndex::remove(uint32_t start, uint32_t length) {
+    if (length == 0U) return false;
+    const uint8_t bin = binFor(length);
+    for (uint16_t i = binHead[bin]; i != kNone; i = nodes[i].next) {
+        if (nodes[i].start == start && nodes[i].length == length) {
+            unlink(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void FreeExtentIndex::unlink(uint16_t idx) {
+    const uint8_t bin = binFor(nodes[idx].length);
+    if (nodes[idx].prev != kNone) {
+        nodes[nodes[idx].prev].next = nodes[idx].next;
+    } else {
+        binHead[bin] = nodes[idx].next;
+    }
+    if (nodes[idx].next != kNone) {
+        nodes[nodes[idx].next].prev = nodes[idx].prev;
+    }
+    if (binHead[bin] == kNone) {
+        binMask &= ~(1U << bin);
+    }
+
+    nodes[idx].next = freeHead;
+    nodes[idx].prev = kNone;
+    freeHead = idx;
+    --extentCount;
+}
+
+} // namespace AllocCustom
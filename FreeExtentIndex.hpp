@@ -0,0 +1,77 @@
+/**
+ * @file FreeExtentIndex.hpp
+ * @brief Сегрегированный индекс свободных участков зоны (POD, trivially constructible).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+#include "PageBitmap.hpp"
+
+namespace AllocCustom {
+
+/**
+ * @brief Индекс свободных участков, разложенных по классам длины.
+ *
+ * Класс участка — floor(log2(length)). Узлы берутся из статического
+ * пула на ALLOC_FREE_EXTENT_CAPACITY записей. Источник истины —
+ * битовая карта inUse: при нехватке узлов индекс помечается неполным
+ * и перестраивается по карте при первой неудачной аллокации.
+ *
+ * Слияние соседних участков выполняет владелец (PageAllocator),
+ * определяя границы по битовой карте.
+ *
+ * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
+ */
+struct FreeExtentIndex {
+    static constexpr uint16_t kNone     = 0xFFFFU;
+    static constexpr uint8_t  kBinCount = 32U;
+
+    struct Node {
+        uint32_t start;     /**< Первая страница участка */
+        uint32_t length;    /**< Длина участка (страниц) */
+        uint16_t next;      /**< Следующий узел класса / пула */
+        uint16_t prev;      /**< Предыдущий узел класса */
+    };
+
+    Node     nodes[ALLOC_FREE_EXTENT_CAPACITY];
+    uint16_t binHead[kBinCount];
+    uint32_t binMask;       /**< Бит b: класс b непуст */
+    uint16_t freeHead;      /**< Пул свободных узлов */
+    uint16_t extentCount;   /**< Число участков в индексе */
+    bool     complete;      /**< Индекс содержит все свободные участки карты */
+
+    /** Инициализация: пустой индекс. */
+    void init();
+
+    /** Перестроить индекс по битовой карте занятости. */
+    void rebuild(const PageBitmap& inUse);
+
+    /**
+     * Подобрать участок из count страниц согласно ALLOC_FIT_POLICY.
+     * Индекс не изменяется.
+     * @return Первая страница подходящего участка или -1.
+     */
+    int32_t find(uint32_t count) const;
+
+    /** Добавить участок (без слияния). При нехватке узлов — complete = false. */
+    void insert(uint32_t start, uint32_t length);
+
+    /** Удалить участок; false, если его нет в индексе. */
+    bool remove(uint32_t start, uint32_t length);
+
+    /** Длина наибольшего участка в индексе. */
+    uint32_t largest() const;
+
+    /** Длина наименьшего участка в индексе (0 — индекс пуст). */
+    uint32_t smallest() const;
+
+private:
+    static uint8_t binFor(uint32_t length);
+
+    void     unlink(uint16_t idx);
+    uint16_t bestInBin(uint8_t bin, uint32_t minLength) const;
+};
+
+} // namespace AllocCustom
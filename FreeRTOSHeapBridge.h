@@ -5,6 +5,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include "FreeRTOS.h"
 #include "AllocatorZones.h"
 
@@ -15,10 +16,19 @@ extern "C" {
 void*  FreeRTOSHeapInternalAllocate(size_t size);
 void   FreeRTOSHeapInternalDeallocate(void* ptr);
 void*  FreeRTOSHeapInternalCalloc(size_t num, size_t size);
+void*  FreeRTOSHeapInternalAllocateZone(size_t size, HeapZone_t zone);
+void*  FreeRTOSHeapInternalCallocZone(size_t num, size_t size, HeapZone_t zone);
+void*  FreeRTOSHeapInternalAllocateAligned(size_t size, size_t alignment);
+void*  FreeRTOSHeapInternalAllocateZoneAligned(size_t size, size_t alignment, HeapZone_t zone);
+void   FreeRTOSHeapInternalDeallocateSized(void* ptr, size_t size, size_t alignment, HeapZone_t zone);
+void*  FreeRTOSHeapInternalReallocate(void* ptr, size_t size);
+size_t FreeRTOSHeapInternalAllocateBatch(size_t size, size_t count, void** out);
+void   FreeRTOSHeapInternalDeallocateBatch(void* const* ptrs, size_t n);
 size_t FreeRTOSHeapInternalGetFreeHeapSize(void);
 size_t FreeRTOSHeapInternalGetMinimumEverFreeHeapSize(void);
 void   FreeRTOSHeapInternalGetHeapStats(HeapStats_t* stats);
 void   FreeRTOSHeapInternalResetState(void);
+void   FreeRTOSHeapInternalTagCaller(void* ptr, uintptr_t pc);
 void   vPortDefineHeapRegionsCpp(const HeapRegion_t* pxHeapRegions);
 
 #ifdef __cplusplus
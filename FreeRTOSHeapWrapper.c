@@ -7,10 +7,44 @@
  */
 
 #include "FreeRTOSHeapBridge.h"
+#include "AllocatorExt.h"
+
+/*
+ * Адрес вызова pvPortMalloc* пишется в футер уже после выделения:
+ * внутри аллокатора __builtin_return_address указывал бы на эту обёртку.
+ */
+#if ALLOC_ENABLE_TASK_STATS && ALLOC_TRACK_CALLER_PC
+#define HEAP_TAG_CALLER( pv )                                                          \
+    do {                                                                               \
+        if( ( pv ) != NULL )                                                           \
+        {                                                                              \
+            FreeRTOSHeapInternalTagCaller( ( pv ), ( uintptr_t ) __builtin_return_address( 0 ) ); \
+        }                                                                              \
+    } while( 0 )
+#else
+#define HEAP_TAG_CALLER( pv )    ( ( void ) 0 )
+#endif
 
 void * pvPortMalloc( size_t xWantedSize )
 {
     void * pvReturn = FreeRTOSHeapInternalAllocate( xWantedSize );
+    HEAP_TAG_CALLER( pvReturn );
+
+#if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    if( pvReturn == NULL )
+    {
+        extern void vApplicationMallocFailedHook( void );
+        vApplicationMallocFailedHook();
+    }
+#endif
+
+    return pvReturn;
+}
+
+void * pvPortMallocZone( size_t xWantedSize, HeapZone_t zone )
+{
+    void * pvReturn = FreeRTOSHeapInternalAllocateZone( xWantedSize, zone );
+    HEAP_TAG_CALLER( pvReturn );
 
 #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
     if( pvReturn == NULL )
@@ -28,6 +62,79 @@ void vPortFree( void * pv )
     FreeRTOSHeapInternalDeallocate( pv );
 }
 
+void * pvPortMallocAligned( size_t xWantedSize, size_t xAlignment )
+{
+    void * pvReturn = FreeRTOSHeapInternalAllocateAligned( xWantedSize, xAlignment );
+    HEAP_TAG_CALLER( pvReturn );
+
+#if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    if( pvReturn == NULL )
+    {
+        extern void vApplicationMallocFailedHook( void );
+        vApplicationMallocFailedHook();
+    }
+#endif
+
+    return pvReturn;
+}
+
+void * pvPortMallocZoneAligned( size_t xWantedSize, size_t xAlignment, HeapZone_t zone )
+{
+    void * pvReturn = FreeRTOSHeapInternalAllocateZoneAligned( xWantedSize, xAlignment, zone );
+    HEAP_TAG_CALLER( pvReturn );
+
+#if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    if( pvReturn == NULL )
+    {
+        extern void vApplicationMallocFailedHook( void );
+        vApplicationMallocFailedHook();
+    }
+#endif
+
+    return pvReturn;
+}
+
+void vPortFreeSized( void * pv, size_t xWantedSize, size_t xAlignment, HeapZone_t zone )
+{
+    FreeRTOSHeapInternalDeallocateSized( pv, xWantedSize, xAlignment, zone );
+}
+
+void * pvPortRealloc( void * pv, size_t xWantedSize )
+{
+    void * pvReturn = FreeRTOSHeapInternalReallocate( pv, xWantedSize );
+    HEAP_TAG_CALLER( pvReturn );
+
+#if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    if( ( pvReturn == NULL ) && ( xWantedSize > 0U ) )
+    {
+        extern void vApplicationMallocFailedHook( void );
+        vApplicationMallocFailedHook();
+    }
+#endif
+
+    return pvReturn;
+}
+
+size_t xPortMallocBatch( size_t xWantedSize, size_t xCount, void ** ppvOut )
+{
+    size_t xAllocated = FreeRTOSHeapInternalAllocateBatch( xWantedSize, xCount, ppvOut );
+
+#if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    if( xAllocated < xCount )
+    {
+        extern void vApplicationMallocFailedHook( void );
+        vApplicationMallocFailedHook();
+    }
+#endif
+
+    return xAllocated;
+}
+
+void vPortFreeBatch( void * const * ppv, size_t xCount )
+{
+    FreeRTOSHeapInternalDeallocateBatch( ppv, xCount );
+}
+
 size_t xPortGetFreeHeapSize( void )
 {
     return FreeRTOSHeapInternalGetFreeHeapSize();
@@ -45,7 +152,16 @@ void vPortInitialiseBlocks( void )
 
 void * pvPortCalloc( size_t xNum, size_t xSize )
 {
-    return FreeRTOSHeapInternalCalloc( xNum, xSize );
+    void * pvReturn = FreeRTOSHeapInternalCalloc( xNum, xSize );
+    HEAP_TAG_CALLER( pvReturn );
+    return pvReturn;
+}
+
+void * pvPortCallocZone( size_t xNum, size_t xSize, HeapZone_t zone )
+{
+    void * pvReturn = FreeRTOSHeapInternalCallocZone( xNum, xSize, zone );
+    HEAP_TAG_CALLER( pvReturn );
+    return pvReturn;
 }
 
 void vPortGetHeapStats( HeapStats_t * pxHeapStats )
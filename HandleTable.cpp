@@ -0,0 +1,132 @@
+/**
+ * @file HandleTable.cpp
+ * @brief Реализация каталога и таблиц хендлов.
+ */
+#include "HandleTable.hpp"
+#include <cstring>
+
+namespace AllocCustom {
+
+namespace {
+
+constexpr uint32_t kSlotMask = 0xFFFFU;
+constexpr uint32_t kGenShift = 16U;
+
+HeapHandle_t makeHandle(uint32_t slot, uint16_t generation) {
+    return (static_cast<uint32_t>(generation) << kGenShift) | (slot + 1U);
+}
+
+} // namespace
+
+/* ───────── Каталог ───────── */
+
+void HandleDirectory::init() {
+    std::memset(entries, 0, sizeof(entries));
+}
+
+HeapHandle_t HandleDirectory::reserve(uint8_t zone) {
+    for (uint32_t i = 0; i < ALLOC_HANDLE_CAPACITY; ++i) {
+        Entry& e = entries[i];
+        if (e.active) continue;
+
+        /* Поколение 0 не выдаётся — хендл никогда не равен INVALID */
+        if (++e.generation == 0U) e.generation = 1U;
+        e.zone   = zone;
+        e.active = 1U;
+        return makeHandle(i, e.generation);
+    }
+    return HEAP_HANDLE_INVALID;
+}
+
+HandleDirectory::Entry* HandleDirectory::find(HeapHandle_t handle) {
+    const uint32_t idx = slotOf(handle);
+    if (idx >= ALLOC_HANDLE_CAPACITY) return nullptr;
+
+    Entry& e = entries[idx];
+    if (!e.active || e.generation != generationOf(handle)) return nullptr;
+    return &e;
+}
+
+void HandleDirectory::release(HeapHandle_t handle) {
+    Entry* e = find(handle);
+    ALLOC_ASSERT(e != nullptr);
+    if (e != nullptr) e->active = 0U;
+}
+
+uint16_t HandleDirectory::slotOf(HeapHandle_t handle) {
+    return static_cast<uint16_t>((handle & kSlotMask) - 1U);
+}
+
+uint16_t HandleDirectory::generationOf(HeapHandle_t handle) {
+    return static_cast<uint16_t>(handle >> kGenShift);
+}
+
+/* ───────── Таблица зоны ───────── */
+
+void HandleTable::init() {
+    std::memset(slots, 0, sizeof(slots));
+}
+
+HandleTable::Slot* HandleTable::acquire(HeapHandle_t handle, uint32_t startPage) {
+    const uint32_t idx = HandleDirectory::slotOf(handle);
+    ALLOC_ASSERT(idx < ALLOC_HANDLE_CAPACITY && !slots[idx].active);
+
+    Slot& s = slots[idx];
+    s.startPage  = startPage;
+    s.generation = HandleDirectory::generationOf(handle);
+    s.pins       = 0U;
+    s.heat       = 0U;
+    s.active     = 1U;
+    return &s;
+}
+
+HandleTable::Slot* HandleTable::find(HeapHandle_t handle) {
+    const uint32_t idx = HandleDirectory::slotOf(handle);
+    if (idx >= ALLOC_HANDLE_CAPACITY) return nullptr;
+
+    Slot& s = slots[idx];
+    if (!s.active || s.generation != HandleDirectory::generationOf(handle)) return nullptr;
+    return &s;
+}
+
+HandleTable::Slot* HandleTable::findByPage(uint32_t startPage) {
+    for (auto& s : slots) {
+        if (s.active && s.startPage == startPage) return &s;
+    }
+    return nullptr;
+}
+
+void HandleTable::release(Slot* slot) {
+    ALLOC_ASSERT(slot->active && slot->pins == 0U);
+    slot->active = 0U;
+}
+
+HandleTable::Slot* HandleTable::hottest(uint16_t minHeat) {
+    Slot* best = nullptr;
+    for (auto& s : slots) {
+        if (!s.active || s.pins != 0U || s.heat < minHeat) continue;
+        if (best == nullptr || s.heat > best->heat) best = &s;
+    }
+    return best;
+}
+
+HandleTable::Slot* HandleTable::coldest(uint16_t maxHeat) {
+    Slot* best = nullptr;
+    for (auto& s : slots) {
+        if (!s.active || s.pins != 0U || s.heat > maxHeat) continue;
+        if (best == nullptr || s.heat < best->heat) best = &s;
+    }
+    return best;
+}
+
+void HandleTable::decay() {
+    for (auto& s : slots) {
+        s.heat = static_cast<uint16_t>(s.heat >> 1U);
+    }
+}
+
+HeapHandle_t HandleTable::handleOf(const Slot* slot) const {
+    return makeHandle(static_cast<uint32_t>(slot - slots), slot->generation);
+}
+
+} // namespace AllocCustom
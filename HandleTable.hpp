@@ -0,0 +1,107 @@
+/**
+ * @file HandleTable.hpp
+ * @brief Хендлы перемещаемых областей: каталог координатора и таблицы зон
+ *        (POD, trivially constructible).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+#include "AllocTypes.h"
+
+namespace AllocCustom {
+
+ALLOC_STATIC_ASSERT(ALLOC_HANDLE_CAPACITY > 0U && ALLOC_HANDLE_CAPACITY < 0xFFFFU,
+                    "ALLOC_HANDLE_CAPACITY must fit the 16-bit slot field of HeapHandle_t");
+
+/**
+ * @brief Каталог хендлов координатора: слот → зона, в которой живёт область.
+ *
+ * Номер слота общий для всех зон: область хендла занимает слот с тем же
+ * номером в HandleTable своей зоны. Поколение растёт при освобождении —
+ * устаревший хендл не находится. Меняется под локом координатора.
+ *
+ * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
+ */
+struct HandleDirectory {
+    struct Entry {
+        uint16_t generation;   /**< Поколение (≠ 0 у выданного хендла) */
+        uint8_t  zone;         /**< Зона области */
+        uint8_t  active;
+    };
+
+    Entry entries[ALLOC_HANDLE_CAPACITY];
+
+    /** Инициализация: все слоты свободны. */
+    void init();
+
+    /**
+     * Занять слот под область в зоне zone.
+     * @return Хендл или HEAP_HANDLE_INVALID (слотов нет).
+     */
+    HeapHandle_t reserve(uint8_t zone);
+
+    /** Запись живого хендла; nullptr — устарел или испорчен. */
+    Entry* find(HeapHandle_t handle);
+
+    /** Освободить слот хендла; хендл устаревает. */
+    void release(HeapHandle_t handle);
+
+    /** Номер слота хендла (без проверки). */
+    static uint16_t slotOf(HeapHandle_t handle);
+
+    /** Поколение хендла. */
+    static uint16_t generationOf(HeapHandle_t handle);
+};
+
+/**
+ * @brief Перемещаемые области одной зоны по слотам каталога.
+ *
+ * Слот хранит первую страницу области — указатель вычисляется при
+ * закреплении, поэтому уплотнитель меняет только startPage.
+ * Меняется под локом зоны.
+ *
+ * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
+ */
+struct HandleTable {
+    struct Slot {
+        uint32_t startPage;    /**< Первая страница области */
+        uint16_t generation;   /**< Поколение хендла (для проверки) */
+        uint16_t pins;         /**< Незакрытых lock — область не перемещается */
+        uint16_t heat;         /**< Частота lock (ALLOC_ENABLE_MIGRATION), затухает */
+        uint8_t  active;
+    };
+
+    Slot slots[ALLOC_HANDLE_CAPACITY];
+
+    /** Инициализация: все слоты свободны. */
+    void init();
+
+    /** Занять слот хендла (слот должен быть свободен в этой зоне). */
+    Slot* acquire(HeapHandle_t handle, uint32_t startPage);
+
+    /** Слот живого хендла в этой зоне; nullptr — не здесь, устарел или испорчен. */
+    Slot* find(HeapHandle_t handle);
+
+    /** Слот области, начинающейся на странице startPage (линейный поиск). */
+    Slot* findByPage(uint32_t startPage);
+
+    /** Освободить слот. */
+    void release(Slot* slot);
+
+    /**
+     * Незакреплённый слот с наибольшим heat ≥ minHeat / наименьшим
+     * heat ≤ maxHeat; nullptr — такого нет.
+     */
+    Slot* hottest(uint16_t minHeat);
+    Slot* coldest(uint16_t maxHeat);
+
+    /** Затухание heat: половина за вызов. */
+    void decay();
+
+    /** Хендл слота. */
+    HeapHandle_t handleOf(const Slot* slot) const;
+};
+
+} // namespace AllocCustom
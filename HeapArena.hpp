@@ -0,0 +1,68 @@
+/**
+ * @file HeapArena.hpp
+ * @brief RAII-обёртка над аренами C-API (heapArena*, AllocatorExt.h).
+ *
+ * Арена — одна страничная область: объекты выделяются сдвигом указателя
+ * без хедеров и освобождаются все сразу — reset() или деструктором
+ * (одна запись карантина на всю область).
+ *
+ *   RegionAlloc::Arena scratch(8192U, RegionAlloc::Zone::Fast);
+ *   auto* buf = scratch.allocArray<uint8_t>(512U);
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "AllocatorExt.h"
+
+namespace RegionAlloc {
+
+class Arena {
+public:
+    Arena(size_t capacity, Zone zone) {
+        (void)heapArenaCreate(&arena_, capacity, static_cast<HeapZone_t>(zone));
+    }
+    ~Arena() { heapArenaDestroy(&arena_); }
+
+    Arena(const Arena&)            = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /** Область выделена. */
+    bool   valid()    const { return arena_.base != nullptr; }
+    size_t capacity() const { return arena_.capacity; }
+    size_t used()     const { return arena_.used; }
+    size_t peak()     const { return arena_.peak; }
+
+    void* alloc(size_t size) { return heapArenaAlloc(&arena_, size); }
+    void* allocAligned(size_t size, size_t alignment) {
+        return heapArenaAllocAligned(&arena_, size, alignment);
+    }
+
+    /** Массив count элементов T (без конструирования); nullptr — не хватило места. */
+    template <typename T>
+    T* allocArray(size_t count) {
+        if (count > SIZE_MAX / sizeof(T)) return nullptr;
+        return static_cast<T*>(heapArenaAllocAligned(&arena_, count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * Сконструировать T в арене. Деструктор T не вызывается —
+     * только для типов, которым он не нужен.
+     */
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* p = heapArenaAllocAligned(&arena_, sizeof(T), alignof(T));
+        return (p != nullptr) ? new (p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    /** Освободить все объекты, область остаётся. */
+    void reset() { heapArenaReset(&arena_); }
+
+private:
+    HeapArena_t arena_;
+};
+
+} // namespace RegionAlloc
@@ -0,0 +1,68 @@
+/**
+ * @file HeapTrace.cpp
+ * @brief Реализация lock-free кольца трассы.
+ */
+#include "HeapTrace.hpp"
+#include <cstring>
+
+namespace AllocCustom {
+
+static_assert(ALLOC_TRACE_CAPACITY >= 2U &&
+              (ALLOC_TRACE_CAPACITY & (ALLOC_TRACE_CAPACITY - 1U)) == 0U,
+              "ALLOC_TRACE_CAPACITY должен быть степенью двойки");
+
+void TraceRing::init() {
+    for (uint32_t i = 0; i < kCapacity; ++i) {
+        cells[i].seq = i;
+        std::memset(&cells[i].record, 0, sizeof(HeapTraceRecord_t));
+    }
+    head = 0U;
+    __atomic_store_n(&dropped, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&tail, 0U, __ATOMIC_RELEASE);
+}
+
+bool TraceRing::push(const HeapTraceRecord_t& record) {
+    uint32_t pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    Cell* cell;
+    for (;;) {
+        cell = &cells[pos & kMask];
+        const uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        const auto diff = static_cast<int32_t>(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&tail, &pos, pos + 1U, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Потребитель отстал — трасса не должна тормозить аллокатор */
+            __atomic_fetch_add(&dropped, 1U, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->record = record;
+    __atomic_store_n(&cell->seq, pos + 1U, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t TraceRing::pop(HeapTraceRecord_t* out, size_t max) {
+    size_t n = 0U;
+    while (n < max) {
+        Cell* cell = &cells[head & kMask];
+        const uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        if (seq != head + 1U) break;   /* Пусто или ячейка ещё не опубликована */
+
+        out[n++] = cell->record;
+        __atomic_store_n(&cell->seq, head + kCapacity, __ATOMIC_RELEASE);
+        ++head;
+    }
+    return n;
+}
+
+uint32_t TraceRing::droppedCount() const {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+} // namespace AllocCustom
@@ -0,0 +1,50 @@
+/**
+ * @file HeapTrace.hpp
+ * @brief Lock-free кольцо записей трассы аллокатора (POD, trivially constructible).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+#include "AllocTypes.h"
+
+namespace AllocCustom {
+
+/**
+ * @brief Ограниченное MPSC-кольцо записей HeapTraceRecord_t.
+ *
+ * Устроено как DeferredFreeQueue: позиция занимается CAS-ом на tail,
+ * ячейка публикуется записью seq. Производители (задачи, ISR) не ждут:
+ * если потребитель отстал, запись отбрасывается и учитывается в dropped.
+ * Потребитель — один (задача, отправляющая трассу в RTT/ITM/UART).
+ *
+ * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
+ */
+struct TraceRing {
+    static constexpr uint32_t kCapacity = ALLOC_TRACE_CAPACITY;
+    static constexpr uint32_t kMask     = kCapacity - 1U;
+
+    struct Cell {
+        uint32_t          seq;   /**< Поколение ячейки */
+        HeapTraceRecord_t record;
+    };
+
+    Cell     cells[kCapacity];
+    uint32_t head;      /**< Позиция потребителя */
+    uint32_t tail;      /**< Следующая позиция производителя */
+    uint32_t dropped;   /**< Отброшено записей (кольцо было полно) */
+
+    void init();
+
+    /** Добавить запись (ISR-safe); false — кольцо полно, запись потеряна. */
+    bool push(const HeapTraceRecord_t& record);
+
+    /** Забрать до max записей (только потребитель). */
+    size_t pop(HeapTraceRecord_t* out, size_t max);
+
+    /** Число отброшенных записей с момента init. */
+    uint32_t droppedCount() const;
+};
+
+} // namespace AllocCustom
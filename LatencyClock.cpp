@@ -0,0 +1,68 @@
+/**
+ * @file LatencyClock.cpp
+ * @brief Счётчик тиков: DWT->CYCCNT на таргете, steady_clock на хосте.
+ */
+#include "LatencyClock.hpp"
+
+#ifdef HOST_BUILD
+#include <chrono>
+#else
+#include "FreeRTOS.h"
+#endif
+
+namespace AllocCustom {
+
+#ifdef HOST_BUILD
+
+void LatencyClock::init() {}
+
+uint32_t LatencyClock::now() {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return static_cast<uint32_t>(ns);
+}
+
+uint32_t LatencyClock::ticksPerSecond() { return 1000000000U; }
+
+#else
+
+namespace {
+/* Регистры отладки Cortex-M (CoreDebug, DWT) */
+volatile uint32_t* const kDemcr     = reinterpret_cast<volatile uint32_t*>(0xE000EDFCU);
+volatile uint32_t* const kDwtCtrl   = reinterpret_cast<volatile uint32_t*>(0xE0001000U);
+volatile uint32_t* const kDwtCyccnt = reinterpret_cast<volatile uint32_t*>(0xE0001004U);
+volatile uint32_t* const kDwtLar    = reinterpret_cast<volatile uint32_t*>(0xE0001FB0U);
+
+constexpr uint32_t kDemcrTrcena    = 1UL << 24;
+constexpr uint32_t kDwtCyccntEna   = 1UL << 0;
+constexpr uint32_t kDwtUnlockKey   = 0xC5ACCE55U;
+} // namespace
+
+void LatencyClock::init() {
+    *kDemcr |= kDemcrTrcena;
+    *kDwtLar = kDwtUnlockKey;   /* Cortex-M7: снять блокировку DWT, на M3/M4 игнорируется */
+    *kDwtCyccnt = 0U;
+    *kDwtCtrl |= kDwtCyccntEna;
+}
+
+uint32_t LatencyClock::now() { return *kDwtCyccnt; }
+
+uint32_t LatencyClock::ticksPerSecond() { return static_cast<uint32_t>(configCPU_CLOCK_HZ); }
+
+#endif
+
+void LatencyClock::record(HeapLatencyHistogram_t* histogram, uint32_t ticks) {
+    /* Корзина — floor(log2(ticks)), нулевые замеры — в корзину 0 */
+    uint32_t bucket = static_cast<uint32_t>(31 - __builtin_clz(ticks | 1U));
+    if (bucket >= ALLOC_LATENCY_BUCKETS) {
+        bucket = ALLOC_LATENCY_BUCKETS - 1U;
+    }
+    ++histogram->buckets[bucket];
+    ++histogram->count;
+    histogram->totalTicks += ticks;
+    if (ticks > histogram->maxTicks) {
+        histogram->maxTicks = ticks;
+    }
+}
+
+} // namespace AllocCustom
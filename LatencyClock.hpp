@@ -0,0 +1,48 @@
+/**
+ * @file LatencyClock.hpp
+ * @brief Счётчик тиков для замера задержек операций аллокатора.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+#include "AllocTypes.h"
+
+namespace AllocCustom {
+
+/**
+ * @brief Свободно бегущий 32-битный счётчик тиков.
+ *
+ * На таргете — DWT->CYCCNT (Cortex-M3 и старше), на хосте —
+ * наносекунды steady_clock. Разность now() корректна при
+ * переполнении, пока замер короче периода счётчика.
+ */
+struct LatencyClock {
+    /** Запустить счётчик (вызывается из defineHeapRegions). */
+    static void     init();
+
+    static uint32_t now();
+
+    /** Частота счётчика (тиков в секунду). */
+    static uint32_t ticksPerSecond();
+
+    /** Учесть замер ticks в гистограмме. */
+    static void     record(HeapLatencyHistogram_t* histogram, uint32_t ticks);
+};
+
+} // namespace AllocCustom
+
+/*
+ * Замер участка кода: ALLOC_LATENCY_BEGIN(t) … ALLOC_LATENCY_END(hist, t).
+ * При ALLOC_ENABLE_LATENCY_STATS == 0 не оставляют кода.
+ */
+#if ALLOC_ENABLE_LATENCY_STATS
+#define ALLOC_LATENCY_BEGIN(stamp) \
+    const uint32_t stamp = ::AllocCustom::LatencyClock::now()
+#define ALLOC_LATENCY_END(histogram, stamp) \
+    ::AllocCustom::LatencyClock::record(&(histogram), ::AllocCustom::LatencyClock::now() - (stamp))
+#else
+#define ALLOC_LATENCY_BEGIN(stamp)          ((void)0)
+#define ALLOC_LATENCY_END(histogram, stamp) ((void)0)
+#endif
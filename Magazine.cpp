@@ -0,0 +1,49 @@
+/**
+ * @file Magazine.cpp
+ * @brief Реализация магазинов объектов slab.
+ */
+#include "Magazine.hpp"
+#include <cstring>
+
+namespace AllocCustom {
+
+static_assert(ALLOC_MAGAZINE_BATCH > 0U && ALLOC_MAGAZINE_BATCH <= ALLOC_MAGAZINE_SIZE,
+              "ALLOC_MAGAZINE_BATCH должен быть в [1, ALLOC_MAGAZINE_SIZE]");
+
+void MagazineCache::init() {
+    std::memset(this, 0, sizeof(*this));
+}
+
+void* MagazineCache::pop(uint8_t zone, uint8_t cls) {
+    Magazine& m = mags[zone][cls];
+    if (m.count == 0U) return nullptr;
+    ++cachedAllocs;
+    return m.items[--m.count];
+}
+
+bool MagazineCache::push(uint8_t zone, uint8_t cls, void* obj) {
+    Magazine& m = mags[zone][cls];
+    if (m.count >= kSize) return false;
+    m.items[m.count++] = obj;
+    return true;
+}
+
+uint16_t MagazineCache::take(uint8_t zone, uint8_t cls, void** out, uint16_t max) {
+    Magazine& m = mags[zone][cls];
+    uint16_t n = 0U;
+    while (n < max && m.count > 0U) {
+        out[n++] = m.items[--m.count];
+    }
+    return n;
+}
+
+bool MagazineCache::isEmpty() const {
+    for (uint8_t z = 0; z < ALLOC_MAX_ZONES; ++z) {
+        for (uint8_t c = 0; c < kClassCount; ++c) {
+            if (mags[z][c].count != 0U) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace AllocCustom
@@ -0,0 +1,54 @@
+/**
+ * @file Magazine.hpp
+ * @brief Магазины объектов slab уровня ядра/задачи (POD, trivially constructible).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+
+namespace AllocCustom {
+
+/**
+ * @brief Набор магазинов одного владельца (ядра или задачи).
+ *
+ * Магазин — LIFO-стек недавно освобождённых объектов одного класса
+ * одной зоны. Объекты в магазине остаются «выданными» с точки зрения
+ * SlabAllocator (guard USED, payload залит карантинным паттерном).
+ *
+ * Синхронизацию обеспечивает владелец: для магазина ядра — маска
+ * прерываний на своём ядре, для магазина задачи — сама задача.
+ *
+ * POD-тип: zero-init из BSS безопасен.
+ */
+struct MagazineCache {
+    static constexpr uint8_t  kClassCount = ALLOC_SLAB_CLASS_COUNT;
+    static constexpr uint16_t kSize       = ALLOC_MAGAZINE_SIZE;
+
+    struct Magazine {
+        void*    items[kSize];
+        uint16_t count;
+    };
+
+    Magazine mags[ALLOC_MAX_ZONES][kClassCount];
+
+    /* ── Статистика ── */
+    size_t cachedAllocs;   /**< Выдано из магазина */
+    size_t cachedFrees;    /**< Принято в магазин */
+
+    void init();
+
+    /** Взять объект; nullptr, если магазин пуст. */
+    void* pop(uint8_t zone, uint8_t cls);
+
+    /** Положить объект; false, если магазин полон. */
+    bool push(uint8_t zone, uint8_t cls, void* obj);
+
+    /** Извлечь до max объектов (для слива в slab). */
+    uint16_t take(uint8_t zone, uint8_t cls, void** out, uint16_t max);
+
+    bool isEmpty() const;
+};
+
+} // namespace AllocCustom
@@ -5,6 +5,8 @@
 #include "PageAllocator.hpp"
 #include "BlockGuard.hpp"
 #include "MpuGuard.hpp"
+#include "FillEngine.hpp"
+#include "LatencyClock.hpp"
 #include <cstring>
 
 namespace AllocCustom {
@@ -15,27 +17,105 @@ static_assert(ALLOC_PAGE_SIZE >= ALLOC_HEADER_SIZE + ALLOC_FOOTER_SIZE + 1U,
               "Страница слишком мала: header + footer + 1 байт payload");
 static_assert(sizeof(AllocBlockHeader) == ALLOC_HEADER_SIZE, "Header size");
 static_assert(sizeof(AllocBlockFooter) == ALLOC_FOOTER_SIZE, "Footer size");
+static_assert(!ALLOC_ENABLE_MIGRATION || ALLOC_ENABLE_HANDLES,
+              "ALLOC_ENABLE_MIGRATION требует ALLOC_ENABLE_HANDLES");
+static_assert(!ALLOC_ENABLE_ZERO_TRACKING || ALLOC_PATTERN_CLEARED_PAGE == 0x00U,
+              "ALLOC_ENABLE_ZERO_TRACKING: очищенная страница должна быть нулевой");
+static_assert(!ALLOC_LAZY_CLEAR_ON_EVICT || ALLOC_ENABLE_ZERO_TRACKING,
+              "ALLOC_LAZY_CLEAR_ON_EVICT требует ALLOC_ENABLE_ZERO_TRACKING");
+static_assert(!ALLOC_FAST_FREE || ALLOC_CHECK_INCREMENTAL,
+              "ALLOC_FAST_FREE требует ALLOC_CHECK_INCREMENTAL");
+static_assert(ALLOC_HEADER_SIZE % ALLOC_MALLOC_ALIGNMENT == 0U &&
+              sizeof(AllocSlabGuard) % ALLOC_MALLOC_ALIGNMENT == 0U,
+              "Payload должен быть выровнен на ALLOC_MALLOC_ALIGNMENT");
+static_assert(ALLOC_ARENA_ALIGNMENT != 0U && (ALLOC_ARENA_ALIGNMENT & (ALLOC_ARENA_ALIGNMENT - 1U)) == 0U,
+              "ALLOC_ARENA_ALIGNMENT — степень двойки");
 
 /* ───────── Инициализация ───────── */
 
-void PageAllocator::init(uint8_t* start, size_t size, uint8_t zone) {
+void PageAllocator::init(uint8_t* start, size_t size, uint8_t zone, uint32_t pageBytes,
+                         const AllocZonePolicy& policy) {
     ALLOC_ASSERT(start != nullptr);
-    ALLOC_ASSERT(size >= ALLOC_PAGE_SIZE);
+    ALLOC_ASSERT((pageBytes & (pageBytes - 1U)) == 0U && "Размер страницы — степень двойки");
+    ALLOC_ASSERT(pageBytes >= ALLOC_HEADER_SIZE + ALLOC_FOOTER_SIZE + 1U);
+    ALLOC_ASSERT(size >= pageBytes);
+
+    pageShift = 0U;
+    while ((1UL << pageShift) < pageBytes) ++pageShift;
 
     baseAddress = start;
     regionSize  = size;
-    totalPages  = static_cast<uint16_t>(size / ALLOC_PAGE_SIZE);
+    pageSize    = pageBytes;
     zoneIndex   = zone;
 
-    ALLOC_ASSERT(totalPages > 0U);
-    ALLOC_ASSERT(totalPages <= ALLOC_MAX_PAGES_PER_ZONE);
+    /* Политика может только отключать собранное макросами */
+    checkLevel = ALLOC_QUARANTINE_CHECK_LEVEL;
+    if (policy.checkLevel != 0U && policy.checkLevel - 1U < checkLevel) {
+        checkLevel = static_cast<uint8_t>(policy.checkLevel - 1U);
+    }
+    fillOnFree        = ALLOC_FILL_ON_FREE && (policy.disable & ALLOC_ZONE_NO_FILL) == 0U;
+    clearOnEvict      = ALLOC_ENABLE_CLEAR_ON_EVICT && (policy.disable & ALLOC_ZONE_NO_CLEAR) == 0U;
+    mpuProtect        = ALLOC_ENABLE_MPU_PROTECTION && (policy.disable & ALLOC_ZONE_NO_MPU) == 0U;
+    checkAllAllocated = ALLOC_CHECK_ALL_ALLOCATED && (policy.disable & ALLOC_ZONE_NO_CHECK_ALL) == 0U;
+    /* Без паттерна проверять в карантине нечего, кроме хедера/футера */
+    if (!fillOnFree && checkLevel >= 2U) checkLevel = 1U;
+
+    /*
+     * Битовые карты — в конце зоны. Страниц столько, чтобы страницы
+     * и карты (со своим выравниванием) поместились в size.
+     */
+    size_t pages = size >> pageShift;
+    ALLOC_ASSERT(pages <= UINT32_MAX);
+    while (pages > 0U && metadataOffset(pages) + kBitmapCount *
+           PageBitmap::storageBytes(static_cast<uint32_t>(pages)) > size) {
+        --pages;
+    }
+    ALLOC_ASSERT(pages > 0U && "Зона меньше страницы с битовыми картами");
+    totalPages = static_cast<uint32_t>(pages);
+    metadata   = start + metadataOffset(pages);
+#if ALLOC_QUARANTINE_MAX_BYTES > 0
+    quarantineMaxPages = static_cast<uint32_t>(ALLOC_QUARANTINE_MAX_BYTES >> pageShift);
+#endif
 
-    bitmapInUse.init(totalPages);
-    bitmapAllocated.init(totalPages);
+    bitmapInUse.init(totalPages, bitmapStorage(0U));
+    bitmapAllocated.init(totalPages, bitmapStorage(1U));
+#if ALLOC_ENABLE_ZERO_TRACKING
+    /* Содержимое новой зоны неизвестно: нулевых страниц нет */
+    bitmapZeroed.init(totalPages, bitmapStorage(kZeroBitmapIndex));
+#endif
     quarantine.init();
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    extents.rebuild(bitmapInUse);
+#endif
+
+    quarantineCursor = 0U;
+    pageCursor       = 0U;
+#if ALLOC_ENABLE_HANDLES
+    handles.init();
+    compactCursor    = 0U;
+#endif
+#if ALLOC_ENABLE_ASYNC_FILL
+    for (auto& f : pendingFills) {
+        f.active = 0U;
+    }
+    pendingFillCount = 0U;
+#endif
+
+#if ALLOC_ENABLE_LATENCY_STATS
+    std::memset(&latency, 0, sizeof(latency));
+#endif
+#if ALLOC_ENABLE_TASK_STATS
+    allocOwner = HEAP_TASK_OWNER_NONE;
+    std::memset(taskAccounts, 0, sizeof(taskAccounts));
+    std::memset(&ownerlessAccount, 0, sizeof(ownerlessAccount));
+    std::memset(&otherAccount, 0, sizeof(otherAccount));
+    ownerlessAccount.owner = HEAP_TASK_OWNER_NONE;
+    otherAccount.owner     = HEAP_TASK_OWNER_OTHER;
+#endif
 
     sequenceCounter  = 0U;
     freePagesCount   = totalPages;
+    freeExtentCount  = 1U;
     minEverFreePages = totalPages;
     successfulAllocs = 0U;
     successfulFrees  = 0U;
@@ -45,120 +125,494 @@ void PageAllocator::init(uint8_t* start, size_t size, uint8_t zone) {
 
 /* ───────── Вспомогательные ───────── */
 
-uint16_t PageAllocator::pagesNeeded(size_t requestedSize) {
+uint32_t PageAllocator::pagesNeeded(size_t requestedSize) const {
+    /* Больше зоны — заведомо не поместится (и не переполнит счётчик страниц) */
+    if (requestedSize >= regionSize) return UINT32_MAX;
     const size_t total = ALLOC_HEADER_SIZE + requestedSize + ALLOC_FOOTER_SIZE;
-    return static_cast<uint16_t>((total + ALLOC_PAGE_SIZE - 1U) / ALLOC_PAGE_SIZE);
+    return static_cast<uint32_t>((total + pageSize - 1U) >> pageShift);
 }
 
-uint8_t* PageAllocator::pageAddress(uint16_t pageIdx) const {
-    return baseAddress + static_cast<size_t>(pageIdx) * ALLOC_PAGE_SIZE;
+uint8_t* PageAllocator::pageAddress(uint32_t pageIdx) const {
+    return baseAddress + (static_cast<size_t>(pageIdx) << pageShift);
+}
+
+size_t PageAllocator::metadataOffset(size_t pages) const {
+    const uintptr_t end = reinterpret_cast<uintptr_t>(baseAddress) + (pages << pageShift);
+    const uintptr_t aligned = (end + sizeof(uint32_t) - 1U) & ~static_cast<uintptr_t>(sizeof(uint32_t) - 1U);
+    return aligned - reinterpret_cast<uintptr_t>(baseAddress);
+}
+
+void* PageAllocator::bitmapStorage(uint8_t idx) const {
+    ALLOC_ASSERT(idx < kBitmapCount);
+    return metadata + static_cast<size_t>(idx) * PageBitmap::storageBytes(totalPages);
 }
 
 int32_t PageAllocator::pageIndex(const void* addr) const {
     const auto* ptr = static_cast<const uint8_t*>(addr);
-    const uint8_t* end = baseAddress + static_cast<size_t>(totalPages) * ALLOC_PAGE_SIZE;
+    const uint8_t* end = baseAddress + (static_cast<size_t>(totalPages) << pageShift);
     if (ptr < baseAddress || ptr >= end) {
         return -1;
     }
-    return static_cast<int32_t>((ptr - baseAddress) / ALLOC_PAGE_SIZE);
+    return static_cast<int32_t>(static_cast<size_t>(ptr - baseAddress) >> pageShift);
+}
+
+/* ───────── Свободные участки ───────── */
+
+int32_t PageAllocator::findRun(uint32_t pages) {
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    int32_t sp = extents.find(pages);
+    if (sp < 0 && !extents.complete) {
+        /* Индекс переполнялся — перестроить и повторить, затем first-fit */
+        extents.rebuild(bitmapInUse);
+        sp = extents.find(pages);
+        if (sp < 0 && !extents.complete) {
+            sp = bitmapInUse.findFreeRun(pages);
+        }
+    }
+    return sp;
+#else
+    return bitmapInUse.findFreeRun(pages);
+#endif
+}
+
+int32_t PageAllocator::findRunFrom(uint32_t pages, uint32_t firstPage, uint32_t stride) {
+    if (pages > freePagesCount) return -1;
+    ALLOC_LATENCY_BEGIN(t0);
+    /* Кратные страницы — только по битовой карте (она точна при любой политике) */
+    const int32_t sp = (stride <= 1U && firstPage == 0U)
+        ? findRun(pages)
+        : bitmapInUse.findFreeRunAligned(pages, firstPage, stride);
+    ALLOC_LATENCY_END(latency.ops[HEAP_LATENCY_FIND_RUN], t0);
+    return sp;
+}
+
+size_t PageAllocator::reclaimablePages() const {
+    size_t pages = freePagesCount + quarantine.pagesHeld;
+#if ALLOC_ENABLE_ASYNC_FILL
+    for (const auto& f : pendingFills) {
+        if (f.active) pages += f.pageCount;
+    }
+#endif
+    return pages;
+}
+
+int32_t PageAllocator::acquireRun(uint32_t pages, uint32_t firstPage, uint32_t stride) {
+    /* Заведомо не поместится — не ждать очисток и не опустошать карантин зря */
+    if (pages > totalPages || pages > reclaimablePages()) return -1;
+
+    int32_t sp = findRunFrom(pages, firstPage, stride);
+#if ALLOC_ENABLE_ASYNC_FILL
+    if (sp < 0 && pendingFillCount > 0U) {
+        /* Места нет — дождаться очищаемых страниц и повторить */
+        reapFills(true);
+        sp = findRunFrom(pages, firstPage, stride);
+    }
+#endif
+#if ALLOC_QUARANTINE_EVICT_ON_PRESSURE
+    /* Места нет — досрочно вытеснять карантин, начиная с самых старых */
+    AllocQuarantineEntry oldest{};
+    while (sp < 0 && quarantine.evictOldest(&oldest)) {
+        evictFromQuarantine(oldest);
+#if ALLOC_ENABLE_ASYNC_FILL
+        reapFills(true);
+#endif
+        sp = findRunFrom(pages, firstPage, stride);
+    }
+#endif
+    return sp;
+}
+
+void PageAllocator::claimPages(uint32_t startPage, uint32_t pageCount) {
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    /* Участок, из которого выделяем, и остатки слева/справа */
+    const uint32_t left  = bitmapInUse.clearRunBefore(startPage);
+    const uint32_t right = bitmapInUse.clearRunFrom(startPage + pageCount);
+    const bool removed = extents.remove(startPage - left, left + pageCount + right);
+    ALLOC_ASSERT(removed || !extents.complete);
+    (void)removed;
+    extents.insert(startPage - left, left);
+    extents.insert(startPage + pageCount, right);
+#endif
+
+    /* Участок исчезает, остаются свободные соседи слева и справа */
+    freeExtentCount = freeExtentCount - 1U + (freeNeighbourBefore(startPage) ? 1U : 0U) +
+                      (freeNeighbourAfter(startPage + pageCount) ? 1U : 0U);
+
+    bitmapInUse.setRange(startPage, pageCount);
+
+    freePagesCount -= pageCount;
+    if (freePagesCount < minEverFreePages) {
+        minEverFreePages = freePagesCount;
+    }
+}
+
+void PageAllocator::releasePages(uint32_t startPage, uint32_t pageCount) {
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    /* Соседние свободные участки сливаются с освобождаемым */
+    const uint32_t left  = bitmapInUse.clearRunBefore(startPage);
+    const uint32_t right = bitmapInUse.clearRunFrom(startPage + pageCount);
+    extents.remove(startPage - left, left);
+    extents.remove(startPage + pageCount, right);
+    extents.insert(startPage - left, left + pageCount + right);
+#endif
+
+    /* Новый участок поглощает свободных соседей */
+    freeExtentCount = freeExtentCount + 1U - (freeNeighbourBefore(startPage) ? 1U : 0U) -
+                      (freeNeighbourAfter(startPage + pageCount) ? 1U : 0U);
+
+    bitmapInUse.clearRange(startPage, pageCount);
+#if ALLOC_ENABLE_ZERO_TRACKING
+    bitmapZeroed.clearRange(startPage, pageCount);
+#endif
+    freePagesCount += pageCount;
+}
+
+void PageAllocator::markZeroed(uint32_t startPage, uint32_t pageCount) {
+#if ALLOC_ENABLE_ZERO_TRACKING
+    bitmapZeroed.setRange(startPage, pageCount);
+#else
+    (void)startPage;
+    (void)pageCount;
+#endif
+}
+
+void PageAllocator::zeroPayload(void* userPtr, size_t size) {
+#if ALLOC_ENABLE_ZERO_TRACKING
+    const auto* header = BlockGuard::headerFromUserData(userPtr);
+    auto* lo = static_cast<uint8_t*>(userPtr);
+    auto* hi = lo + size;
+    const uint32_t end = header->startPage + header->pageCount;
+
+    /* Серии неочищенных страниц — одним memset каждая */
+    uint32_t page = bitmapZeroed.nextClear(header->startPage);
+    while (page < end) {
+        uint32_t runEnd = bitmapZeroed.nextSet(page);
+        if (runEnd > end) runEnd = end;
+        uint8_t* from = pageAddress(page);
+        uint8_t* to   = pageAddress(runEnd);
+        if (from < lo) from = lo;
+        if (to > hi)   to   = hi;
+        if (from < to) {
+            std::memset(from, 0, static_cast<size_t>(to - from));
+        }
+        page = (runEnd < end) ? bitmapZeroed.nextClear(runEnd) : end;
+    }
+#else
+    std::memset(userPtr, 0, size);
+#endif
+}
+
+bool PageAllocator::freeNeighbourBefore(uint32_t page) const {
+    return page > 0U && !bitmapInUse.test(page - 1U);
+}
+
+bool PageAllocator::freeNeighbourAfter(uint32_t page) const {
+    return page < totalPages && !bitmapInUse.test(page);
+}
+
+uint32_t PageAllocator::largestFreeExtent() const {
+    if (!initialized) return 0U;
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    if (extents.complete) return extents.largest();
+#endif
+    return bitmapInUse.longestFreeRun();
+}
+
+size_t PageAllocator::largestFreeBytes() const {
+    return static_cast<size_t>(largestFreeExtent()) << pageShift;
+}
+
+size_t PageAllocator::smallestFreeBytes() const {
+    if (!initialized || freeExtentCount == 0U) return 0U;
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    if (extents.complete) return static_cast<size_t>(extents.smallest()) << pageShift;
+#endif
+    /* Обход участков по карте: nextClear — начало, nextSet — конец */
+    uint32_t smallest = UINT32_MAX;
+    uint32_t page = bitmapInUse.nextClear(0U);
+    while (page < totalPages) {
+        const uint32_t end = bitmapInUse.nextSet(page);
+        if (end - page < smallest) smallest = end - page;
+        if (smallest == 1U || end >= totalPages) break;
+        page = bitmapInUse.nextClear(end);
+    }
+    return static_cast<size_t>(smallest) << pageShift;
+}
+
+uint32_t PageAllocator::freeBlockCount() const {
+    return initialized ? freeExtentCount : 0U;
+}
+
+size_t PageAllocator::quarantineBytes() const {
+    if (!initialized) return 0U;
+    size_t pages = quarantine.pagesHeld;
+#if ALLOC_ENABLE_ASYNC_FILL
+    for (const auto& f : pendingFills) {
+        if (f.active && f.kind == kFillClear) pages += f.pageCount;
+    }
+#endif
+    return pages << pageShift;
 }
 
 /* ───────── Аллокация ───────── */
 
 void* PageAllocator::allocate(size_t requestedSize) {
+    return allocatePages(requestedSize, 0U);
+}
+
+void* PageAllocator::allocatePages(size_t requestedSize, uint8_t flags) {
     if (!initialized || requestedSize == 0U) return nullptr;
 
-    const uint16_t pages = pagesNeeded(requestedSize);
-    if (pages > freePagesCount) return nullptr;
+    /* Страницы с завершённой очисткой — снова свободны */
+    reapFills(false);
+
+    const uint32_t pages = pagesNeeded(requestedSize);
 
     /* Проверки целостности перед операцией */
-#if ALLOC_QUARANTINE_CHECK_LEVEL > 0
-    ALLOC_ASSERT(verifyQuarantine());
-#endif
-#if ALLOC_CHECK_ALL_ALLOCATED
-    ALLOC_ASSERT(verifyAllocated());
-#endif
+    const bool checked = operationChecks();
+    ALLOC_ASSERT(checked);
+    (void)checked;
 
     /* Поиск непрерывного свободного участка */
-    const int32_t sp32 = bitmapInUse.findFreeRun(pages);
+    const int32_t sp32 = acquireRun(pages, 0U, 1U);
+    if (sp32 < 0) return nullptr;
+
+    const auto sp = static_cast<uint32_t>(sp32);
+    claimPages(sp, pages);
+    return placeBlock(sp, pages, requestedSize, 0U, flags);
+}
+
+void* PageAllocator::allocateAligned(size_t requestedSize, size_t alignment) {
+    if (!initialized || requestedSize == 0U) return nullptr;
+    if (alignment == 0U || (alignment & (alignment - 1U)) != 0U) return nullptr;
+    if (alignment > (static_cast<size_t>(1U) << ALLOC_BLOCK_FLAG_ALIGN_MASK)) return nullptr;
+
+    reapFills(false);
+    const bool checked = operationChecks();
+    ALLOC_ASSERT(checked);
+    (void)checked;
+
+    /*
+     * Payload = pageAddress(sp) + headOffset + ALLOC_HEADER_SIZE.
+     * Для alignment ≤ страницы смещение одно и то же для любой страницы;
+     * для большего — подходит каждая (alignment / pageSize)-я
+     * страница, начиная с firstPage.
+     */
+    const uintptr_t natural = reinterpret_cast<uintptr_t>(baseAddress) + ALLOC_HEADER_SIZE;
+    const uintptr_t aligned = (natural + alignment - 1U) & ~(static_cast<uintptr_t>(alignment) - 1U);
+    size_t   offset    = aligned - natural;
+    uint32_t firstPage = 0U;
+    uint32_t stride    = 1U;
+    if (alignment > pageSize) {
+        firstPage = static_cast<uint32_t>(offset >> pageShift);
+        offset   &= pageSize - 1U;
+        stride    = static_cast<uint32_t>(alignment >> pageShift);
+    }
+
+    /* Перед смещённым хедером должен поместиться маркер */
+    while (offset != 0U && offset < sizeof(AllocLeadMarker)) {
+        if (alignment > pageSize) {
+            /* Хедер — в конце предыдущей страницы */
+            firstPage = (firstPage > 0U) ? firstPage - 1U : stride - 1U;
+            offset   += pageSize;
+        } else {
+            offset   += alignment;
+        }
+    }
+
+    const size_t total = offset + requestedSize;
+    if ((total >> pageShift) >= totalPages) return nullptr;
+    const uint32_t pages = pagesNeeded(total);
+
+    const int32_t sp32 = acquireRun(pages, firstPage, stride);
     if (sp32 < 0) return nullptr;
 
-    const auto sp  = static_cast<uint16_t>(sp32);
-    const uint32_t seq = sequenceCounter++;
+    uint8_t shift = 0U;
+    while ((static_cast<size_t>(1U) << shift) < alignment) ++shift;
+
+    const auto sp = static_cast<uint32_t>(sp32);
+    claimPages(sp, pages);
+    return placeBlock(sp, pages, requestedSize, static_cast<uint16_t>(offset), shift);
+}
+
+void* PageAllocator::placeBlock(uint32_t startPage, uint32_t pageCount, size_t requestedSize,
+                               uint16_t headOffset, uint8_t flags) {
+    /* Пометка в битовой карте живых областей */
+    bitmapAllocated.setRange(startPage, pageCount);
+
+    /* Маркер, хедер, футер, паддинг */
+    if (headOffset > 0U) {
+        BlockGuard::writeLead(pageAddress(startPage), headOffset);
+    }
+#if ALLOC_ENABLE_TASK_STATS
+    const uint32_t owner = allocOwner;
+    TaskAccount* account = accountFor(owner);
+    account->bytes += static_cast<size_t>(pageCount) << pageShift;
+    ++account->blocks;
+#else
+    const uint32_t owner = HEAP_TASK_OWNER_NONE;
+#endif
+    writeGuards(startPage, pageCount, requestedSize, sequenceCounter++, headOffset, flags, owner, 0U);
 
-    /* Пометки в битовых картах */
-    bitmapInUse.setRange(sp, pages);
-    bitmapAllocated.setRange(sp, pages);
+    ++successfulAllocs;
+
+    return BlockGuard::userDataFromHeader(pageAddress(startPage) + headOffset);
+}
+
+size_t PageAllocator::blockAlignment(const void* userPtr) const {
+    const uint8_t shift = validateBlock(const_cast<void*>(userPtr))->flags & ALLOC_BLOCK_FLAG_ALIGN_MASK;
+    return (shift != 0U) ? (static_cast<size_t>(1U) << shift) : 0U;
+}
+
+size_t PageAllocator::allocateBatch(size_t requestedSize, size_t count, void** out) {
+    if (!initialized || requestedSize == 0U || count == 0U || out == nullptr) return 0U;
+
+    reapFills(false);
+    const uint32_t pages = pagesNeeded(requestedSize);
+
+    /* Проверки целостности — одна на пакет */
+    const bool checked = operationChecks();
+    ALLOC_ASSERT(checked);
+    (void)checked;
+
+    /* Сначала — единый участок под весь пакет (произведение — без переполнения) */
+    if (count <= freePagesCount / pages) {
+        const size_t runPages = static_cast<size_t>(pages) * count;
+        const int32_t sp32 = findRunFrom(static_cast<uint32_t>(runPages), 0U, 1U);
+        if (sp32 >= 0) {
+            const auto sp = static_cast<uint32_t>(sp32);
+            claimPages(sp, static_cast<uint32_t>(runPages));
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = placeBlock(sp + i * pages, pages, requestedSize, 0U, 0U);
+            }
+            return count;
+        }
+    }
 
+    /* Иначе — по одной области, пока есть место */
+    size_t n = 0U;
+    while (n < count) {
+        const int32_t sp32 = acquireRun(pages, 0U, 1U);
+        if (sp32 < 0) break;
+        const auto sp = static_cast<uint32_t>(sp32);
+        claimPages(sp, pages);
+        out[n++] = placeBlock(sp, pages, requestedSize, 0U, 0U);
+    }
+    return n;
+}
+
+void PageAllocator::writeGuards(uint32_t startPage, uint32_t pageCount,
+                                size_t requestedSize, uint32_t seq,
+                                uint16_t headOffset, uint8_t flags,
+                                uint32_t ownerTask, uint32_t callerPc) {
     /* Хедер */
-    uint8_t* headerAddr = pageAddress(sp);
+    uint8_t* headerAddr = pageAddress(startPage) + headOffset;
     BlockGuard::writeHeader(headerAddr,
                             static_cast<uint32_t>(requestedSize),
-                            sp, pages, zoneIndex, seq);
+                            startPage, pageCount, zoneIndex, seq, headOffset, flags,
+                            ownerTask);
 
     /* Футер */
     auto* header = reinterpret_cast<AllocBlockHeader*>(headerAddr);
     auto* footer = BlockGuard::footerFromHeader(header);
     BlockGuard::writeFooter(footer,
                             static_cast<uint32_t>(requestedSize),
-                            sp, pages, zoneIndex, seq);
+                            startPage, pageCount, zoneIndex, seq, headOffset, flags,
+                            callerPc);
 
     /* Паддинг */
-    const size_t padLen = BlockGuard::paddingSize(header);
+    const size_t padLen = BlockGuard::paddingSize(header, pageSize);
     if (padLen > 0U) {
         BlockGuard::fillPadding(BlockGuard::paddingFromHeader(header), padLen);
     }
-
-    /* Статистика */
-    freePagesCount -= pages;
-    if (freePagesCount < minEverFreePages) {
-        minEverFreePages = freePagesCount;
-    }
-    ++successfulAllocs;
-
-    return BlockGuard::userDataFromHeader(headerAddr);
 }
 
 /* ───────── Деаллокация ───────── */
 
-void PageAllocator::deallocate(void* userPtr) {
-    if (!initialized || userPtr == nullptr) return;
-
-    /* Валидация хедера */
-    auto* header = BlockGuard::headerFromUserData(userPtr);
-    ALLOC_ASSERT(BlockGuard::validateHeader(header));
+AllocBlockHeader* PageAllocator::validateBlock(void* userPtr) const {
+    auto* header = validateHeader(userPtr);
 
     /* Валидация футера */
     const auto* footer = BlockGuard::footerFromHeader(
                              const_cast<const AllocBlockHeader*>(header));
     ALLOC_ASSERT(BlockGuard::validateFooter(footer));
     ALLOC_ASSERT(BlockGuard::validatePair(header, footer));
+    (void)footer;
+    return header;
+}
+
+AllocBlockHeader* PageAllocator::validateHeader(void* userPtr) const {
+    auto* header = BlockGuard::headerFromUserData(userPtr);
+    ALLOC_ASSERT(BlockGuard::validateHeader(header));
 
     /* Принадлежность зоне */
     ALLOC_ASSERT(header->zoneIndex == zoneIndex);
-    const uint16_t sp = header->startPage;
-    const uint16_t pc = header->pageCount;
-    ALLOC_ASSERT(static_cast<uint32_t>(sp) + pc <= totalPages);
+    ALLOC_ASSERT(static_cast<uint32_t>(header->startPage) + header->pageCount <= totalPages);
+    ALLOC_ASSERT(bitmapAllocated.test(header->startPage) && "Область не выдана");
+    ALLOC_ASSERT(reinterpret_cast<uint8_t*>(header) ==
+                 pageAddress(header->startPage) + header->headOffset);
+    return header;
+}
+
+void PageAllocator::deallocate(void* userPtr) {
+    if (!initialized || userPtr == nullptr) return;
+
+#if ALLOC_FAST_FREE
+    /* Футер и остальная куча — инкрементальным обходом (карантин, idle) */
+    auto* header = validateHeader(userPtr);
+    ALLOC_ASSERT((header->flags & ALLOC_BLOCK_FLAG_MOVABLE) == 0U && "Область по хендлу — freeHandle");
+#else
+    auto* header = validateBlock(userPtr);
+    ALLOC_ASSERT((header->flags & ALLOC_BLOCK_FLAG_MOVABLE) == 0U && "Область по хендлу — freeHandle");
 
     /* Проверки целостности */
-#if ALLOC_QUARANTINE_CHECK_LEVEL > 0
-    ALLOC_ASSERT(verifyQuarantine());
+    const bool checked = operationChecks();
+    ALLOC_ASSERT(checked);
+    (void)checked;
 #endif
-#if ALLOC_CHECK_ALL_ALLOCATED
-    ALLOC_ASSERT(verifyAllocated());
+
+    retireBlock(header);
+
+    ++successfulFrees;
+}
+
+void PageAllocator::deallocateUnchecked(void* userPtr) {
+    if (!initialized || userPtr == nullptr) return;
+    auto* header = validateBlock(userPtr);
+    ALLOC_ASSERT((header->flags & ALLOC_BLOCK_FLAG_MOVABLE) == 0U && "Область по хендлу — freeHandle");
+    retireBlock(header);
+    ++successfulFrees;
+}
+
+void PageAllocator::retireBlock(AllocBlockHeader* header) {
+    void* userPtr = BlockGuard::userDataFromHeader(header);
+    const uint32_t sp = header->startPage;
+    const uint32_t pc = header->pageCount;
+
+#if ALLOC_ENABLE_TASK_STATS
+    TaskAccount* account = accountFor(header->ownerTask);
+    ALLOC_ASSERT(account->blocks > 0U);
+    account->bytes -= static_cast<size_t>(pc) << pageShift;
+    --account->blocks;
 #endif
 
     /* Добавление в карантин (с возможным вытеснением) */
     AllocQuarantineEntry evicted{};
     const bool didEvict = quarantine.add(sp, pc, header->requestedSize,
-                                         zoneIndex, &evicted);
+                                         zoneIndex, header->headOffset, &evicted);
     if (didEvict) {
         evictFromQuarantine(evicted);
     }
 
     /* Заполнение payload карантинным паттерном */
 #if ALLOC_FILL_ON_FREE
-    BlockGuard::fillQuarantinePayload(userPtr, header->requestedSize);
+    if (fillOnFree &&
+        fill(userPtr, ALLOC_PATTERN_QUARANTINE_FILL, header->requestedSize,
+             sp, pc, kFillQuarantine)) {
+        quarantine.find(sp)->fillPending = 1U;
+    }
+#else
+    (void)userPtr;
 #endif
 
     /* Обновление битовых карт:
@@ -167,12 +621,81 @@ void PageAllocator::deallocate(void* userPtr) {
      */
     bitmapAllocated.clearRange(sp, pc);
 
+    /* Предел объёма карантина: вытеснять старые записи (возможно, и эту) */
+#if ALLOC_QUARANTINE_MAX_BYTES > 0
+    while (quarantine.pages() > quarantineMaxPages) {
+        const bool any = quarantine.evictOldest(&evicted);
+        ALLOC_ASSERT(any);
+        (void)any;
+        evictFromQuarantine(evicted);
+    }
+#endif
+
     /* MPU-защита карантинных страниц */
 #if ALLOC_ENABLE_MPU_PROTECTION
-    updateMpuProtection(sp, pc);
+    if (mpuProtect && quarantine.find(sp) != nullptr) {
+        updateMpuProtection(sp, pc);
+    }
 #endif
+}
 
-    ++successfulFrees;
+/* ───────── Изменение размера ───────── */
+
+size_t PageAllocator::blockSize(const void* userPtr) const {
+    return validateBlock(const_cast<void*>(userPtr))->requestedSize;
+}
+
+bool PageAllocator::resize(void* userPtr, size_t newSize) {
+    if (!initialized || userPtr == nullptr || newSize == 0U) return false;
+
+    const auto* header = validateBlock(userPtr);
+    const uint32_t sp  = header->startPage;
+    const uint32_t pc  = header->pageCount;
+    const uint32_t seq = header->sequenceNum;
+    const uint16_t hoff  = header->headOffset;
+    const uint8_t  flags = header->flags;
+    const uint32_t owner = header->ownerTask;
+    const uint32_t callerPc = BlockGuard::footerFromHeader(header)->callerPc;
+    const uint32_t pages = pagesNeeded(hoff + newSize);
+
+    /* Паддинг станет payload-ом или будет перезаписан — он должен быть цел */
+    const size_t ps = BlockGuard::paddingSize(header, pageSize);
+    ALLOC_ASSERT(ps == 0U || BlockGuard::validatePadding(BlockGuard::paddingFromHeader(header), ps));
+    (void)ps;
+
+    if (pages > pc) {
+        /* Рост: нужны свободные страницы сразу за областью */
+        reapFills(false);
+        const auto extra = pages - pc;
+        const auto next  = sp + pc;
+        if (next >= totalPages || bitmapInUse.clearRunFrom(next) < extra) {
+            return false;
+        }
+        claimPages(next, extra);
+        bitmapAllocated.setRange(next, extra);
+#if ALLOC_ENABLE_TASK_STATS
+        accountFor(owner)->bytes += static_cast<size_t>(extra) << pageShift;
+#endif
+        writeGuards(sp, pages, newSize, seq, hoff, flags, owner, callerPc);
+        return true;
+    }
+
+    /* Сжатие или рост в пределах тех же страниц */
+    writeGuards(sp, pages, newSize, seq, hoff, flags, owner, callerPc);
+
+    if (pages < pc) {
+        /* Хвостовые страницы — отдельная область, уходящая в карантин */
+        const auto tail  = sp + pages;
+        const auto count = pc - pages;
+        const size_t tailSize = (static_cast<size_t>(count) << pageShift) -
+                                ALLOC_HEADER_SIZE - ALLOC_FOOTER_SIZE;
+        writeGuards(tail, count, tailSize, sequenceCounter++, 0U, 0U, owner, 0U);
+#if ALLOC_ENABLE_TASK_STATS
+        ++accountFor(owner)->blocks;   /* retireBlock спишет хвост как отдельную область */
+#endif
+        retireBlock(reinterpret_cast<AllocBlockHeader*>(pageAddress(tail)));
+    }
+    return true;
 }
 
 /* ───────── Calloc ───────── */
@@ -182,14 +705,201 @@ void* PageAllocator::calloc(size_t num, size_t elemSize) {
     const size_t total = num * elemSize;
     void* ptr = allocate(total);
     if (ptr != nullptr) {
-        std::memset(ptr, 0, total);
+        zeroPayload(ptr, total);
     }
     return ptr;
 }
 
+/* ───────── Перемещаемые области ───────── */
+
+#if ALLOC_ENABLE_HANDLES
+
+bool PageAllocator::allocateHandle(size_t requestedSize, HeapHandle_t handle) {
+    void* p = allocatePages(requestedSize, ALLOC_BLOCK_FLAG_MOVABLE);
+    if (p == nullptr) return false;
+    (void)handles.acquire(handle, BlockGuard::headerFromUserData(p)->startPage);
+    return true;
+}
+
+void* PageAllocator::lockHandle(HeapHandle_t handle) {
+    if (!initialized) return nullptr;
+    HandleTable::Slot* slot = handles.find(handle);
+    if (slot == nullptr) return nullptr;
+    ALLOC_ASSERT(slot->pins < UINT16_MAX);
+    ++slot->pins;
+#if ALLOC_ENABLE_MIGRATION
+    if (slot->heat < UINT16_MAX) ++slot->heat;
+#endif
+    return BlockGuard::userDataFromHeader(pageAddress(slot->startPage));
+}
+
+bool PageAllocator::unlockHandle(HeapHandle_t handle) {
+    if (!initialized) return false;
+    HandleTable::Slot* slot = handles.find(handle);
+    if (slot == nullptr || slot->pins == 0U) return false;
+    --slot->pins;
+    return true;
+}
+
+void PageAllocator::freeHandle(HeapHandle_t handle) {
+    if (!initialized) return;
+    HandleTable::Slot* slot = handles.find(handle);
+    ALLOC_ASSERT(slot != nullptr && "Недействительный хендл");
+    if (slot == nullptr) return;
+    ALLOC_ASSERT(slot->pins == 0U && "Освобождение закреплённой области");
+
+    auto* header = validateBlock(BlockGuard::userDataFromHeader(pageAddress(slot->startPage)));
+    const bool checked = operationChecks();
+    ALLOC_ASSERT(checked);
+    (void)checked;
+
+    handles.release(slot);
+    retireBlock(header);
+    ++successfulFrees;
+}
+
+uint32_t PageAllocator::compactStep(uint32_t budget) {
+    if (!initialized) return 0U;
+
+    uint32_t moved = 0U;
+    uint32_t spent = 0U;
+    while (spent < budget) {
+        /* Первый свободный участок от курсора и область сразу за ним */
+        const uint32_t gap  = bitmapInUse.nextClear(compactCursor);
+        const uint32_t page = (gap < totalPages) ? bitmapInUse.nextSet(gap) : totalPages;
+        if (page >= totalPages) {
+            /* Дальше зона свободна до конца — проход завершён */
+            compactCursor = 0U;
+            break;
+        }
+        ++spent;
+
+        /*
+         * Не сдвигаемая область (карантин, очистка, slab, закреплённая)
+         * пропускается вместе с примыкающими к ней: следующий кандидат —
+         * за следующим свободным участком.
+         */
+        compactCursor = page;
+        if (!bitmapAllocated.test(page)) continue;
+
+        auto* header = const_cast<AllocBlockHeader*>(BlockGuard::headerAtPage(pageAddress(page)));
+        ALLOC_ASSERT(BlockGuard::validateHeader(header));
+        if ((header->flags & ALLOC_BLOCK_FLAG_MOVABLE) == 0U) continue;
+
+        HandleTable::Slot* slot = handles.findByPage(page);
+        ALLOC_ASSERT(slot != nullptr && "Перемещаемая область без хендла");
+        if (slot == nullptr || slot->pins != 0U) continue;
+
+        const uint32_t pages = header->pageCount;
+        moveBlock(header, gap);
+        slot->startPage = gap;
+        moved += pages;
+        spent += pages;
+        compactCursor = gap + pages;
+    }
+    return moved;
+}
+
+#if ALLOC_ENABLE_MIGRATION
+bool PageAllocator::migrateHandle(HeapHandle_t handle, PageAllocator& dest) {
+    HandleTable::Slot* slot = handles.find(handle);
+    if (slot == nullptr || slot->pins != 0U) return false;
+
+    void* src = BlockGuard::userDataFromHeader(pageAddress(slot->startPage));
+    const auto* header = validateBlock(src);
+    const size_t size = header->requestedSize;
+
+#if ALLOC_ENABLE_TASK_STATS
+    dest.allocOwner = header->ownerTask;
+#endif
+    if (!dest.allocateHandle(size, handle)) return false;
+
+    /* Перенос — не пользовательское выделение */
+    --dest.successfulAllocs;
+
+    HandleTable::Slot* moved = dest.handles.find(handle);
+    ALLOC_ASSERT(moved != nullptr);
+    moved->heat = slot->heat;
+    void* dst = BlockGuard::userDataFromHeader(dest.pageAddress(moved->startPage));
+    std::memcpy(dst, src, size);
+#if ALLOC_ENABLE_TASK_STATS
+    dest.setCallerPc(dst, BlockGuard::footerFromHeader(header)->callerPc);
+#endif
+
+    /*
+     * Старое место — сразу в свободные, минуя карантин (как при
+     * уплотнении): освобождения не было, а место в зоне нужно сейчас.
+     */
+    const uint32_t sp = header->startPage;
+    const uint32_t pc = header->pageCount;
+#if ALLOC_ENABLE_TASK_STATS
+    TaskAccount* account = accountFor(header->ownerTask);
+    ALLOC_ASSERT(account->blocks > 0U);
+    account->bytes -= static_cast<size_t>(pc) << pageShift;
+    --account->blocks;
+#endif
+    handles.release(slot);
+    bitmapAllocated.clearRange(sp, pc);
+    releasePages(sp, pc);
+#if ALLOC_ENABLE_CLEAR_ON_EVICT
+    if (clearOnEvict) {
+        BlockGuard::fillClearedPages(pageAddress(sp), static_cast<size_t>(pc) << pageShift);
+        markZeroed(sp, pc);
+    }
+#endif
+    return true;
+}
+#endif
+
+void PageAllocator::moveBlock(AllocBlockHeader* header, uint32_t to) {
+    const uint32_t from  = header->startPage;
+    const uint32_t pages = header->pageCount;
+    const auto* footer   = BlockGuard::footerFromHeader(header);
+    ALLOC_ASSERT(BlockGuard::validateFooter(footer) && BlockGuard::validatePair(header, footer));
+    ALLOC_ASSERT(header->headOffset == 0U && to < from);
+
+    const size_t   requestedSize = header->requestedSize;
+    const uint32_t seq      = header->sequenceNum;
+    const uint8_t  flags    = header->flags;
+    const uint32_t owner    = header->ownerTask;
+    const uint32_t callerPc = footer->callerPc;
+
+    /* Хедер, payload, футер и паддинг — одним копированием (участки перекрываются) */
+    std::memmove(pageAddress(to), pageAddress(from), static_cast<size_t>(pages) << pageShift);
+
+    /*
+     * Старое место — сразу в свободные, минуя карантин: область жива,
+     * освобождения не было. Новое занимается из объединённого участка.
+     */
+    bitmapAllocated.clearRange(from, pages);
+    releasePages(from, pages);
+    claimPages(to, pages);
+    bitmapAllocated.setRange(to, pages);
+    writeGuards(to, pages, requestedSize, seq, 0U, flags, owner, callerPc);
+
+    /* Хвост старого места с копией данных */
+#if ALLOC_ENABLE_CLEAR_ON_EVICT
+    if (clearOnEvict) {
+        const uint32_t tail = (to + pages > from) ? to + pages : from;
+        BlockGuard::fillClearedPages(pageAddress(tail),
+                                     static_cast<size_t>(from + pages - tail) << pageShift);
+        markZeroed(tail, from + pages - tail);
+    }
+#endif
+}
+
+#endif /* ALLOC_ENABLE_HANDLES */
+
 /* ───────── Вытеснение из карантина ───────── */
 
 void PageAllocator::evictFromQuarantine(const AllocQuarantineEntry& entry) {
+    ALLOC_LATENCY_BEGIN(t0);
+
+    /* Заливка карантинным паттерном должна завершиться до очистки */
+    if (entry.fillPending) {
+        waitFill(entry.startPage);
+    }
+
     /* Снять MPU */
     if (entry.mpuRegion >= 0) {
         MpuGuard::unprotect(entry.mpuRegion);
@@ -197,43 +907,131 @@ void PageAllocator::evictFromQuarantine(const AllocQuarantineEntry& entry) {
 
     /* Очистка страниц (если включена) */
 #if ALLOC_ENABLE_CLEAR_ON_EVICT
-    uint8_t* start = pageAddress(entry.startPage);
-    const size_t bytes = static_cast<size_t>(entry.pageCount) * ALLOC_PAGE_SIZE;
-    BlockGuard::fillClearedPages(start, bytes);
+    /* Лениво — только поверх паттерна: обнулит calloc, если страницы достанутся ему */
+    const bool clear = clearOnEvict && !(ALLOC_LAZY_CLEAR_ON_EVICT && fillOnFree);
+    if (clear) {
+        uint8_t* start = pageAddress(entry.startPage);
+        const size_t bytes = static_cast<size_t>(entry.pageCount) << pageShift;
+        if (fill(start, ALLOC_PATTERN_CLEARED_PAGE, bytes,
+                 entry.startPage, entry.pageCount, kFillClear)) {
+            ALLOC_LATENCY_END(latency.ops[HEAP_LATENCY_EVICT], t0);
+            return;   /* Страницы освободит reapFills() */
+        }
+    }
+#else
+    const bool clear = false;
 #endif
 
-    /* Освобождение в битовых картах */
-    bitmapInUse.clearRange(entry.startPage, entry.pageCount);
+    /* Освобождение в битовых картах (со слиянием соседних участков) */
+    releasePages(entry.startPage, entry.pageCount);
+    if (clear) {
+        markZeroed(entry.startPage, entry.pageCount);
+    }
     /* bitmapAllocated уже 0 для карантинных записей */
+    ALLOC_LATENCY_END(latency.ops[HEAP_LATENCY_EVICT], t0);
+}
+
+/* ───────── Асинхронные заливки ───────── */
+
+bool PageAllocator::fill(void* dst, uint8_t pattern, size_t size,
+                         uint32_t startPage, uint32_t pageCount, uint8_t kind) {
+#if ALLOC_ENABLE_ASYNC_FILL
+    if (size >= ALLOC_ASYNC_FILL_THRESHOLD && pendingFillCount < ALLOC_ASYNC_FILL_SLOTS) {
+        const int ticket = FillEngine::start(dst, pattern, size);
+        if (ticket >= 0) {
+            for (auto& f : pendingFills) {
+                if (f.active) continue;
+                f.startPage = startPage;
+                f.pageCount = pageCount;
+                f.ticket    = static_cast<int16_t>(ticket);
+                f.kind      = kind;
+                f.active    = 1U;
+                ++pendingFillCount;
+                return true;
+            }
+        }
+    }
+#else
+    (void)startPage;
+    (void)pageCount;
+    (void)kind;
+#endif
+    std::memset(dst, pattern, size);
+    return false;
+}
+
+void PageAllocator::reapFills(bool wait) {
+#if ALLOC_ENABLE_ASYNC_FILL
+    if (pendingFillCount == 0U) return;
+    for (auto& f : pendingFills) {
+        if (!f.active) continue;
+        if (wait) {
+            FillEngine::wait(f.ticket);
+        } else if (!FillEngine::done(f.ticket)) {
+            continue;
+        }
+
+        f.active = 0U;
+        --pendingFillCount;
+        if (f.kind == kFillClear) {
+            releasePages(f.startPage, f.pageCount);
+            markZeroed(f.startPage, f.pageCount);
+        } else {
+            AllocQuarantineEntry* e = quarantine.find(f.startPage);
+            if (e != nullptr) {
+                e->fillPending = 0U;
+            }
+        }
+    }
+#else
+    (void)wait;
+#endif
+}
 
-    freePagesCount += entry.pageCount;
+void PageAllocator::waitFill(uint32_t startPage) {
+#if ALLOC_ENABLE_ASYNC_FILL
+    for (auto& f : pendingFills) {
+        if (!f.active || f.startPage != startPage || f.kind != kFillQuarantine) continue;
+        FillEngine::wait(f.ticket);
+        f.active = 0U;
+        --pendingFillCount;
+    }
+#else
+    (void)startPage;
+#endif
+}
+
+void PageAllocator::pollFills() {
+    if (initialized) {
+        reapFills(false);
+    }
 }
 
 /* ───────── MPU ───────── */
 
-void PageAllocator::updateMpuProtection(uint16_t startPage, uint16_t pageCount) {
+void PageAllocator::updateMpuProtection(uint32_t startPage, uint32_t pageCount) {
     if (!MpuGuard::available()) return;
 
     /* Расширяем диапазон влево/вправо пока страницы не «allocated» */
-    uint16_t regionStart = startPage;
-    uint16_t regionEnd   = static_cast<uint16_t>(startPage + pageCount);
+    uint32_t regionStart = startPage;
+    uint32_t regionEnd   = startPage + pageCount;
 
-    while (regionStart > 0U && !bitmapAllocated.test(static_cast<uint16_t>(regionStart - 1U))) {
+    while (regionStart > 0U && !bitmapAllocated.test(regionStart - 1U)) {
         --regionStart;
     }
     while (regionEnd < totalPages && !bitmapAllocated.test(regionEnd)) {
         ++regionEnd;
     }
 
-    const uint16_t regionPages = static_cast<uint16_t>(regionEnd - regionStart);
-    const size_t   regionBytes = static_cast<size_t>(regionPages) * ALLOC_PAGE_SIZE;
+    const uint32_t regionPages = regionEnd - regionStart;
+    const size_t   regionBytes = static_cast<size_t>(regionPages) << pageShift;
     const uintptr_t regionAddr = reinterpret_cast<uintptr_t>(pageAddress(regionStart));
 
     /* Наибольшая степень двойки, помещающаяся и выровненная */
     size_t protectSize   = MpuGuard::floorPow2(regionBytes);
     uintptr_t protectAddr = MpuGuard::alignDown(regionAddr, protectSize);
 
-    while (protectSize > ALLOC_PAGE_SIZE) {
+    while (protectSize > pageSize) {
         const uintptr_t endAddr = protectAddr + protectSize;
         const bool ok = (protectAddr >= reinterpret_cast<uintptr_t>(pageAddress(regionStart)))
                      && (endAddr     <= reinterpret_cast<uintptr_t>(pageAddress(regionEnd)));
@@ -243,14 +1041,22 @@ void PageAllocator::updateMpuProtection(uint16_t startPage, uint16_t pageCount)
             reinterpret_cast<uintptr_t>(pageAddress(startPage)), protectSize);
     }
 
-    /* Снимаем старые MPU-регионы, покрываемые новым */
-    for (uint16_t i = 0; i < QuarantineTable::capacity(); ++i) {
-        auto* e = quarantine.entryAt(i);
-        if (!e->active || e->mpuRegion < 0) continue;
+    /* Записи внутри нового региона — из индекса по адресу, без полного обхода */
+    const uintptr_t protectEnd = protectAddr + protectSize;
+    const uintptr_t baseAddr   = reinterpret_cast<uintptr_t>(baseAddress);
+    const uint32_t  firstPage  = (protectAddr <= baseAddr) ? 0U
+        : static_cast<uint32_t>((protectAddr - baseAddr + pageSize - 1U) >> pageShift);
+    const uint16_t  firstPos   = quarantine.lowerBound(firstPage);
 
+    /* Снимаем старые MPU-регионы, покрываемые новым */
+    for (uint16_t pos = firstPos; pos < quarantine.count(); ++pos) {
+        auto* e = quarantine.byAddressAt(pos);
         const uintptr_t ea = reinterpret_cast<uintptr_t>(pageAddress(e->startPage));
-        const uintptr_t ee = ea + static_cast<size_t>(e->pageCount) * ALLOC_PAGE_SIZE;
-        if (ea >= protectAddr && ee <= protectAddr + protectSize) {
+        if (ea >= protectEnd) break;
+        if (e->mpuRegion < 0) continue;
+
+        const uintptr_t ee = ea + (static_cast<size_t>(e->pageCount) << pageShift);
+        if (ea >= protectAddr && ee <= protectEnd) {
             MpuGuard::unprotect(e->mpuRegion);
             e->mpuRegion = -1;
         }
@@ -259,13 +1065,13 @@ void PageAllocator::updateMpuProtection(uint16_t startPage, uint16_t pageCount)
     /* Защищаем объединённый регион и обновляем записи */
     const int region = MpuGuard::protect(protectAddr, protectSize);
     if (region >= 0) {
-        for (uint16_t i = 0; i < QuarantineTable::capacity(); ++i) {
-            auto* e = quarantine.entryAt(i);
-            if (!e->active) continue;
-
+        for (uint16_t pos = firstPos; pos < quarantine.count(); ++pos) {
+            auto* e = quarantine.byAddressAt(pos);
             const uintptr_t ea = reinterpret_cast<uintptr_t>(pageAddress(e->startPage));
-            const uintptr_t ee = ea + static_cast<size_t>(e->pageCount) * ALLOC_PAGE_SIZE;
-            if (ea >= protectAddr && ee <= protectAddr + protectSize) {
+            if (ea >= protectEnd) break;
+
+            const uintptr_t ee = ea + (static_cast<size_t>(e->pageCount) << pageShift);
+            if (ea >= protectAddr && ee <= protectEnd) {
                 e->mpuRegion = static_cast<int8_t>(region);
             }
         }
@@ -274,9 +1080,9 @@ void PageAllocator::updateMpuProtection(uint16_t startPage, uint16_t pageCount)
 
 /* ───────── Информация ───────── */
 
-size_t PageAllocator::freeBytes()        const { return initialized ? freePagesCount   * ALLOC_PAGE_SIZE : 0U; }
-size_t PageAllocator::minEverFreeBytes() const { return initialized ? minEverFreePages * ALLOC_PAGE_SIZE : 0U; }
-size_t PageAllocator::totalBytes()       const { return initialized ? static_cast<size_t>(totalPages) * ALLOC_PAGE_SIZE : 0U; }
+size_t PageAllocator::freeBytes()        const { return initialized ? freePagesCount   << pageShift : 0U; }
+size_t PageAllocator::minEverFreeBytes() const { return initialized ? minEverFreePages << pageShift : 0U; }
+size_t PageAllocator::totalBytes()       const { return initialized ? static_cast<size_t>(totalPages) << pageShift : 0U; }
 size_t PageAllocator::usedBytes()        const { return totalBytes() - freeBytes(); }
 bool   PageAllocator::isInitialized()    const { return initialized; }
 
@@ -284,80 +1090,226 @@ bool PageAllocator::ownsPointer(const void* userPtr) const {
     if (!initialized || userPtr == nullptr) return false;
     const auto* ptr = static_cast<const uint8_t*>(userPtr);
     const uint8_t* lo = baseAddress + ALLOC_HEADER_SIZE;
-    const uint8_t* hi = baseAddress + static_cast<size_t>(totalPages) * ALLOC_PAGE_SIZE;
+    const uint8_t* hi = baseAddress + (static_cast<size_t>(totalPages) << pageShift);
     return ptr >= lo && ptr < hi;
 }
 
 /* ───────── Верификация карантина ───────── */
 
-bool PageAllocator::verifyQuarantine() const {
-    for (uint16_t i = 0; i < QuarantineTable::capacity(); ++i) {
-        const auto* entry = quarantine.entryAt(i);
-        if (!entry->active) continue;
-
-        const auto* header = reinterpret_cast<const AllocBlockHeader*>(
-            pageAddress(entry->startPage));
+bool PageAllocator::verifyQuarantineEntry(const AllocQuarantineEntry* entry) const {
+    const auto* header = reinterpret_cast<const AllocBlockHeader*>(
+        pageAddress(entry->startPage) + entry->headOffset);
 
-        if (!BlockGuard::validateHeader(header)) return false;
+    if (!BlockGuard::validateHeader(header)) return false;
 
-        const auto* footer = BlockGuard::footerFromHeader(header);
-        if (!BlockGuard::validateFooter(footer)) return false;
-        if (!BlockGuard::validatePair(header, footer)) return false;
+    const auto* footer = BlockGuard::footerFromHeader(header);
+    if (!BlockGuard::validateFooter(footer)) return false;
+    if (!BlockGuard::validatePair(header, footer)) return false;
 
 #if ALLOC_QUARANTINE_CHECK_LEVEL >= 2
-        const void* payload = BlockGuard::userDataFromHeader(header);
-        if (!BlockGuard::validateQuarantinePayload(payload, header->requestedSize)) {
-            return false;
-        }
+    /* Пока FillEngine заливает паттерн, payload не проверяется */
+    const void* payload = BlockGuard::userDataFromHeader(header);
+    if (checkLevel >= 2U && !entry->fillPending &&
+        !BlockGuard::validateQuarantinePayload(payload, header->requestedSize)) {
+        return false;
+    }
 #endif
 
 #if ALLOC_QUARANTINE_CHECK_LEVEL >= 3
+    if (checkLevel >= 3U) {
+        if (!BlockGuard::validateLead(pageAddress(entry->startPage), entry->headOffset)) {
+            return false;
+        }
         const void* pad = BlockGuard::paddingFromHeader(header);
-        const size_t ps = BlockGuard::paddingSize(header);
+        const size_t ps = BlockGuard::paddingSize(header, pageSize);
         if (ps > 0U && !BlockGuard::validatePadding(pad, ps)) {
             return false;
         }
+    }
 #endif
+    return true;
+}
+
+bool PageAllocator::verifyQuarantine() const {
+    for (uint16_t i = 0; i < QuarantineTable::capacity(); ++i) {
+        const auto* entry = quarantine.entryAt(i);
+        if (entry->active && !verifyQuarantineEntry(entry)) return false;
     }
     return true;
 }
 
 /* ───────── Верификация аллоцированных областей ───────── */
 
+uint32_t PageAllocator::verifyAllocatedAt(uint32_t page) const {
+    if (!bitmapAllocated.test(page)) return 1U;
+
+    const uint8_t* pageStart = pageAddress(page);
+    const auto*    header    = BlockGuard::headerAtPage(pageStart);
+    const size_t   lead      = reinterpret_cast<const uint8_t*>(header) - pageStart;
+    if (lead + ALLOC_HEADER_SIZE > (static_cast<size_t>(totalPages - page) << pageShift)) {
+        return 1U;
+    }
+
+    /* Проверяем, является ли страница началом области */
+    if (!BlockGuard::validateHeader(header) || header->startPage != page ||
+        header->headOffset != lead) {
+        return 1U;
+    }
+
+    const auto* footer = BlockGuard::footerFromHeader(header);
+    if (!BlockGuard::validateFooter(footer)) return 0U;
+    if (!BlockGuard::validatePair(header, footer)) return 0U;
+
+    return header->pageCount;
+}
+
 bool PageAllocator::verifyAllocated() const {
-    for (uint16_t i = 0; i < totalPages; ) {
-        if (!bitmapAllocated.test(i)) {
-            ++i;
+    for (uint32_t i = 0; i < totalPages; ) {
+        const uint32_t step = verifyAllocatedAt(i);
+        if (step == 0U) return false;
+        i += step;
+    }
+    return true;
+}
+
+/* ───────── Обход живых областей ───────── */
+
+size_t PageAllocator::walkAllocated(uint32_t owner, HeapBlockVisitor_t visitor,
+                                    void* context) const {
+    size_t visited = 0U;
+    for (uint32_t page = bitmapAllocated.nextSet(0U); page < totalPages;
+         page = bitmapAllocated.nextSet(page)) {
+        const uint8_t* pageStart = pageAddress(page);
+        const auto*    header    = BlockGuard::headerAtPage(pageStart);
+        const size_t   lead      = reinterpret_cast<const uint8_t*>(header) - pageStart;
+
+        /* Не начало области (slab-страница, хвост) — следующая страница */
+        if (lead + ALLOC_HEADER_SIZE > (static_cast<size_t>(totalPages - page) << pageShift) ||
+            !BlockGuard::validateHeader(header) || header->startPage != page ||
+            header->headOffset != lead || header->pageCount == 0U) {
+            ++page;
             continue;
         }
 
-        const auto* header = reinterpret_cast<const AllocBlockHeader*>(pageAddress(i));
+        if (owner == HEAP_TASK_OWNER_ANY || owner == header->ownerTask) {
+            HeapBlockInfo_t info;
+            info.ptr           = const_cast<void*>(BlockGuard::userDataFromHeader(header));
+            info.requestedSize = header->requestedSize;
+            info.bytes         = static_cast<size_t>(header->pageCount) << pageShift;
+            info.ownerTask     = header->ownerTask;
+            info.callerPc      = BlockGuard::footerFromHeader(header)->callerPc;
+            info.sequenceNum   = header->sequenceNum;
+            info.zoneIndex     = zoneIndex;
+            if (visitor != nullptr) {
+                visitor(&info, context);
+            }
+            ++visited;
+        }
+        page += header->pageCount;
+    }
+    return visited;
+}
 
-        /* Проверяем, является ли страница началом области */
-        if (!BlockGuard::validateHeader(header) || header->startPage != i) {
-            ++i;
-            continue;
+#if ALLOC_ENABLE_TASK_STATS
+
+/* ───────── Учёт по задачам ───────── */
+
+PageAllocator::TaskAccount* PageAllocator::accountFor(uint32_t owner) {
+    if (owner == HEAP_TASK_OWNER_NONE) return &ownerlessAccount;
+
+    constexpr uint32_t mask = ALLOC_TASK_STATS_SLOTS - 1U;
+    /* Младшие биты TCB выровнены — отбрасываем и перемешиваем */
+    uint32_t h = (owner >> 3) * 2654435761U;
+    h = (h ^ (h >> 16)) & mask;
+    for (uint32_t probe = 0U; probe < ALLOC_TASK_STATS_SLOTS; ++probe) {
+        TaskAccount& slot = taskAccounts[(h + probe) & mask];
+        if (slot.owner == owner) return &slot;
+        if (slot.owner == HEAP_TASK_OWNER_NONE) {
+            slot.owner = owner;
+            return &slot;
         }
+    }
+    return &otherAccount;
+}
 
-        const auto* footer = BlockGuard::footerFromHeader(header);
-        if (!BlockGuard::validateFooter(footer)) return false;
-        if (!BlockGuard::validatePair(header, footer)) return false;
+void PageAllocator::setCallerPc(void* userPtr, uint32_t callerPc) {
+    AllocBlockHeader* header = validateBlock(userPtr);
+    BlockGuard::writeFooter(BlockGuard::footerFromHeader(header),
+                            header->requestedSize, header->startPage, header->pageCount,
+                            header->zoneIndex, header->sequenceNum, header->headOffset,
+                            header->flags, callerPc);
+}
 
-        i = static_cast<uint16_t>(i + header->pageCount);
+size_t PageAllocator::taskStats(HeapTaskStats_t* out, size_t maxCount) const {
+    size_t n = 0U;
+    auto emit = [&](const TaskAccount& a) {
+        if (a.blocks == 0U || n >= maxCount) return;
+        out[n].ownerTask = a.owner;
+        out[n].blocks    = a.blocks;
+        out[n].bytes     = a.bytes;
+        ++n;
+    };
+    for (const auto& a : taskAccounts) {
+        emit(a);
     }
-    return true;
+    emit(ownerlessAccount);
+    emit(otherAccount);
+    return n;
 }
 
+#endif /* ALLOC_ENABLE_TASK_STATS */
+
 /* ───────── Запуск всех проверок ───────── */
 
 bool PageAllocator::runChecks() const {
     bool ok = true;
 #if ALLOC_QUARANTINE_CHECK_LEVEL > 0
-    ok = ok && verifyQuarantine();
+    ok = ok && (checkLevel == 0U || verifyQuarantine());
+#endif
+#if ALLOC_CHECK_ALL_ALLOCATED
+    ok = ok && (!checkAllAllocated || verifyAllocated());
+#endif
+    return ok;
+}
+
+/* ───────── Инкрементальные проверки ───────── */
+
+bool PageAllocator::runIncrementalChecks(uint16_t quarantineBudget, uint16_t pageBudget) {
+    if (!initialized) return true;
+
+#if ALLOC_QUARANTINE_CHECK_LEVEL > 0
+    const uint16_t cap = QuarantineTable::capacity();
+    for (uint16_t n = 0; checkLevel > 0U && n < quarantineBudget && n < cap; ++n) {
+        const auto* entry = quarantine.entryAt(quarantineCursor);
+        quarantineCursor = static_cast<uint16_t>((quarantineCursor + 1U) % cap);
+        if (entry->active && !verifyQuarantineEntry(entry)) return false;
+    }
+#else
+    (void)quarantineBudget;
 #endif
+
 #if ALLOC_CHECK_ALL_ALLOCATED
-    ok = ok && verifyAllocated();
+    /* Шаг — область целиком или одна страница вне областей */
+    for (uint16_t n = 0; checkAllAllocated && n < pageBudget; ++n) {
+        if (pageCursor >= totalPages) pageCursor = 0U;
+        const uint32_t step = verifyAllocatedAt(pageCursor);
+        if (step == 0U) return false;
+        pageCursor += step;
+    }
+#else
+    (void)pageBudget;
+#endif
+    return true;
+}
+
+bool PageAllocator::operationChecks() {
+    ALLOC_LATENCY_BEGIN(t0);
+#if ALLOC_CHECK_INCREMENTAL
+    const bool ok = runIncrementalChecks(ALLOC_CHECK_QUARANTINE_BUDGET, ALLOC_CHECK_PAGE_BUDGET);
+#else
+    const bool ok = runChecks();
 #endif
+    ALLOC_LATENCY_END(latency.ops[HEAP_LATENCY_CHECKS], t0);
     return ok;
 }
 
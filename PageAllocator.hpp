@@ -9,16 +9,22 @@
 #include "AllocConf.h"
 #include "AllocTypes.h"
 #include "PageBitmap.hpp"
+#include "FreeExtentIndex.hpp"
 #include "Quarantine.hpp"
+#include "HandleTable.hpp"
 
 namespace AllocCustom {
 
 /**
  * @brief Страничный аллокатор для одной непрерывной зоны.
  *
- * Выделяет память страницами по ALLOC_PAGE_SIZE байт.
+ * Выделяет память страницами по pageSize байт (степень двойки, своя
+ * у каждой зоны — ALLOC_ZONE_PAGE_SIZES), проверки и заливки — по
+ * политике зоны (ALLOC_ZONE_POLICIES).
  * Каждая область обрамляется хедером и футером.
  * Освобождённые области помещаются в карантин.
+ * Битовые карты лежат в конце самой зоны (размер — по числу страниц),
+ * поэтому предела на число страниц в зоне нет.
  *
  * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
  * НЕ выполняет собственную синхронизацию.
@@ -27,31 +33,161 @@ struct PageAllocator {
     /* ── Состояние зоны ── */
     uint8_t* baseAddress;
     size_t   regionSize;
-    uint16_t totalPages;
+    uint32_t pageSize;     /**< Размер страницы зоны (байт) */
+    uint8_t  pageShift;    /**< log2(pageSize) */
+    uint32_t totalPages;
+    uint8_t* metadata;     /**< Хранилище битовых карт (в конце зоны) */
     uint8_t  zoneIndex;
     bool     initialized;
 
+    /* ── Действующая политика зоны (ALLOC_ZONE_POLICIES в пределах макросов) ── */
+    uint8_t  checkLevel;          /**< Уровень проверки карантина */
+    bool     fillOnFree;
+    bool     clearOnEvict;
+    bool     mpuProtect;
+    bool     checkAllAllocated;
+
     /* ── Битовые карты ── */
+
+    /**
+     * Битовых карт в конце зоны: inUse, allocated, (при slab) карта
+     * slab-страниц и (при ALLOC_ENABLE_ZERO_TRACKING) карта нулевых страниц.
+     */
+    static constexpr uint8_t kZeroBitmapIndex = ALLOC_ENABLE_SLAB ? 3U : 2U;
+    static constexpr uint8_t kBitmapCount = kZeroBitmapIndex + (ALLOC_ENABLE_ZERO_TRACKING ? 1U : 0U);
+
     PageBitmap bitmapInUse;      /**< 1 = занято/карантин, 0 = свободно */
     PageBitmap bitmapAllocated;  /**< 1 = занято, 0 = карантин/свободно */
+#if ALLOC_ENABLE_ZERO_TRACKING
+    /**
+     * 1 = страница целиком нулевая. Достоверна только для свободных страниц:
+     * releasePages сбрасывает, места, очищающие страницы, — выставляют;
+     * занятые страницы не трогаются (calloc читает карту сразу после захвата).
+     */
+    PageBitmap bitmapZeroed;
+#endif
+
+#if ALLOC_FIT_POLICY != ALLOC_FIT_FIRST
+    /* ── Индекс свободных участков ── */
+    FreeExtentIndex extents;
+#endif
 
     /* ── Карантин ── */
     QuarantineTable quarantine;
+#if ALLOC_QUARANTINE_MAX_BYTES > 0
+    uint32_t        quarantineMaxPages;   /**< ALLOC_QUARANTINE_MAX_BYTES в страницах зоны */
+#endif
+
+    /* ── Виды заливок ── */
+    static constexpr uint8_t kFillQuarantine = 1U;   /**< Payload карантинной записи */
+    static constexpr uint8_t kFillClear      = 2U;   /**< Очистка при вытеснении */
+
+#if ALLOC_ENABLE_ASYNC_FILL
+    /* ── Незавершённые заливки FillEngine ── */
+
+    struct PendingFill {
+        uint32_t startPage;
+        uint32_t pageCount;
+        int16_t  ticket;    /**< Номер заливки FillEngine */
+        uint8_t  kind;      /**< kFillQuarantine / kFillClear */
+        uint8_t  active;
+    };
+
+    /*
+     * Пока очистка не завершена, страницы остаются в bitmapInUse
+     * («очищаются») и не выдаются, но уже не числятся в карантине.
+     */
+    PendingFill pendingFills[ALLOC_ASYNC_FILL_SLOTS];
+    uint8_t     pendingFillCount;
+#endif
+
+#if ALLOC_ENABLE_HANDLES
+    /* ── Перемещаемые области ── */
+    HandleTable handles;
+    uint32_t    compactCursor;   /**< Страница, с которой продолжается проход уплотнения */
+#endif
+
+    /* ── Курсоры инкрементальной проверки ── */
+    uint16_t quarantineCursor;
+    uint32_t pageCursor;
+
+#if ALLOC_ENABLE_TASK_STATS
+    /* ── Учёт по задачам ── */
+
+    static_assert((ALLOC_TASK_STATS_SLOTS & (ALLOC_TASK_STATS_SLOTS - 1U)) == 0U,
+                  "ALLOC_TASK_STATS_SLOTS must be a power of two");
+
+    struct TaskAccount {
+        uint32_t owner;    /**< Тег задачи; 0 — слот свободен */
+        uint32_t blocks;
+        size_t   bytes;    /**< Занято страницами (байт) */
+    };
+
+    /** Владелец следующих областей — выставляет координатор под замком зоны. */
+    uint32_t    allocOwner;
+    TaskAccount taskAccounts[ALLOC_TASK_STATS_SLOTS];   /**< Открытая адресация, слоты не освобождаются */
+    TaskAccount ownerlessAccount;   /**< HEAP_TASK_OWNER_NONE (до старта планировщика, slab-страницы) */
+    TaskAccount otherAccount;       /**< Задачи, не поместившиеся в таблицу */
+#endif
 
     /* ── Статистика ── */
+#if ALLOC_ENABLE_LATENCY_STATS
+    HeapLatencyStats_t latency;   /**< Задержки операций зоны (ticksPerSecond не заполняется) */
+#endif
     uint32_t sequenceCounter;
     size_t   freePagesCount;
+    uint32_t freeExtentCount;   /**< Непрерывных свободных участков в bitmapInUse */
     size_t   minEverFreePages;
     size_t   successfulAllocs;
     size_t   successfulFrees;
 
     /* ── Основные операции ── */
 
-    void  init(uint8_t* start, size_t size, uint8_t zone);
+    void  init(uint8_t* start, size_t size, uint8_t zone, uint32_t pageBytes,
+               const AllocZonePolicy& policy);
     void* allocate(size_t requestedSize);
     void  deallocate(void* userPtr);
     void* calloc(size_t num, size_t elemSize);
 
+    /**
+     * Изменить размер области на месте: рост — за счёт свободных страниц
+     * сразу за областью, сжатие — перенос футера и отправка хвостовых
+     * страниц в карантин. Хедер и футер переписываются.
+     * @return false — на месте нельзя, область не изменена.
+     */
+    bool  resize(void* userPtr, size_t newSize);
+
+    /**
+     * Выделить область с payload, выровненным на alignment (степень двойки).
+     * Хедер лежит сразу перед payload; при alignment > pageSize
+     * подбирается подходящая первая страница.
+     */
+    void* allocateAligned(size_t requestedSize, size_t alignment);
+
+    /** Выравнивание, запрошенное при allocateAligned (0 — обычная область). */
+    size_t blockAlignment(const void* userPtr) const;
+
+    /** Запрошенный размер живой области (по хедеру). */
+    size_t blockSize(const void* userPtr) const;
+
+    /** Завершить готовые асинхронные заливки (освободить очищенные страницы). */
+    void pollFills();
+
+    /* ── Пакетные операции ── */
+
+    /**
+     * Выделить до count областей одного размера. Проверки целостности —
+     * один раз на пакет; при наличии места области идут подряд.
+     * @return Число выделенных областей (out[0..n)).
+     */
+    size_t allocateBatch(size_t requestedSize, size_t count, void** out);
+
+    /**
+     * Освободить область без проверок целостности зоны — вызывающий
+     * выполняет runChecks() один раз на пакет. Хедер/футер проверяются.
+     */
+    void   deallocateUnchecked(void* userPtr);
+
     /* ── Информация ── */
 
     size_t freeBytes()        const;
@@ -61,6 +197,88 @@ struct PageAllocator {
     bool   ownsPointer(const void* userPtr) const;
     bool   isInitialized()    const;
 
+    /** Наибольший непрерывный свободный участок (страниц / байт). */
+    uint32_t largestFreeExtent() const;
+    size_t   largestFreeBytes()  const;
+
+    /** Наименьший непрерывный свободный участок (байт); 0 — свободных нет. */
+    size_t   smallestFreeBytes() const;
+
+    /** Число непрерывных свободных участков (ведётся инкрементально). */
+    uint32_t freeBlockCount()    const;
+
+    /**
+     * Страницы, которые освободятся без участия пользователя: карантин
+     * и вытесненные области, ожидающие очистки FillEngine (байт).
+     */
+    size_t   quarantineBytes()   const;
+
+#if ALLOC_ENABLE_TASK_STATS
+    /* ── Учёт по задачам ── */
+
+    /**
+     * Записать адрес вызова в футер живой области (после выделения —
+     * PC берётся в обёртке heap API). Хедер не меняется.
+     */
+    void setCallerPc(void* userPtr, uint32_t callerPc);
+
+    /**
+     * Счётчики задач зоны: до maxCount записей в out, включая
+     * NONE и OTHER (если не пусты).
+     * @return Число записанных элементов.
+     */
+    size_t taskStats(HeapTaskStats_t* out, size_t maxCount) const;
+#endif
+
+    /**
+     * Обойти живые области зоны (по bitmapAllocated), вызвав visitor для
+     * областей владельца owner (HEAP_TASK_OWNER_ANY — для всех).
+     * @return Число посещённых областей.
+     */
+    size_t walkAllocated(uint32_t owner, HeapBlockVisitor_t visitor, void* context) const;
+
+#if ALLOC_ENABLE_HANDLES
+    /* ── Перемещаемые области ── */
+
+    /**
+     * Выделить страничную область (ALLOC_BLOCK_FLAG_MOVABLE) под хендл,
+     * выданный каталогом координатора. Указатель действителен только
+     * между lockHandle и unlockHandle.
+     * @return false — нет места.
+     */
+    bool  allocateHandle(size_t requestedSize, HeapHandle_t handle);
+
+    /** Закрепить область и вернуть её адрес; nullptr — недействительный хендл. */
+    void* lockHandle(HeapHandle_t handle);
+
+    /** Снять одно закрепление; false — хендл недействителен или не закреплён. */
+    bool  unlockHandle(HeapHandle_t handle);
+
+    /** Освободить область (в карантин, как deallocate). Закреплённую — нельзя. */
+    void  freeHandle(HeapHandle_t handle);
+
+    /**
+     * Шаг уплотнения: незакреплённые перемещаемые области, стоящие сразу
+     * за свободным участком, сдвигаются к началу зоны (memmove, новые
+     * хедер/футер, обе битовые карты). Скопированные страницы и
+     * просмотренные участки расходуют budget; область перемещается
+     * целиком, даже если она больше остатка бюджета.
+     * @return Перемещено страниц за шаг.
+     */
+    uint32_t compactStep(uint32_t budget);
+
+#if ALLOC_ENABLE_MIGRATION
+    /**
+     * Перенести незакреплённую область хендла в зону dest: выделение там
+     * под тот же хендл, копия payload, страницы здесь — сразу в свободные
+     * (минуя карантин). heat, владелец и адрес вызова сохраняются,
+     * счётчики alloc/free не меняются. Вызывающий держит локи обеих зон.
+     * @return false — хендла здесь нет, он закреплён или в dest нет места.
+     */
+    bool  migrateHandle(HeapHandle_t handle, PageAllocator& dest);
+#endif
+#endif
+
     /* ── Диагностика ── */
 
     /** Проверить все записи карантина (возвращает false при порче). */
@@ -72,14 +290,124 @@ struct PageAllocator {
     /** Выполнить все включённые проверки. */
     bool runChecks() const;
 
-private:
-    static uint16_t pagesNeeded(size_t requestedSize);
+    /**
+     * Проверить следующие quarantineBudget слотов карантина и
+     * pageBudget шагов обхода областей, сдвинув курсоры.
+     */
+    bool runIncrementalChecks(uint16_t quarantineBudget, uint16_t pageBudget);
+
+    /**
+     * Проверки перед операцией: полные или инкрементальные (ALLOC_CHECK_INCREMENTAL).
+     * Сдвигает курсоры и пишет HEAP_LATENCY_CHECKS — вызывать вне ALLOC_ASSERT.
+     */
+    bool operationChecks();
 
-    uint8_t*       pageAddress(uint16_t pageIdx) const;
+    /* ── Навигация ── */
+
+    uint8_t*       pageAddress(uint32_t pageIdx) const;
     int32_t        pageIndex(const void* addr) const;
 
+    /** Хранилище битовой карты idx (< kBitmapCount) в конце зоны. */
+    void*          bitmapStorage(uint8_t idx) const;
+
+private:
+    uint32_t pagesNeeded(size_t requestedSize) const;
+
+    /** Смещение хранилища битовых карт от начала зоны при pages страницах. */
+    size_t   metadataOffset(size_t pages) const;
+
+    /** Проверить хедер/футер живой области этой зоны. */
+    AllocBlockHeader* validateBlock(void* userPtr) const;
+
+    /** Только хедер: контрольная сумма, зона, границы, bitmapAllocated. */
+    AllocBlockHeader* validateHeader(void* userPtr) const;
+
+    /** Выделение страничной области с флагами хедера flags. */
+    void* allocatePages(size_t requestedSize, uint8_t flags);
+
+    /** Разметить выделенный участок как область (bitmapAllocated, guard-ы, статистика). */
+    void* placeBlock(uint32_t startPage, uint32_t pageCount, size_t requestedSize,
+                     uint16_t headOffset, uint8_t flags);
+
+#if ALLOC_ENABLE_TASK_STATS
+    /** Счётчик владельца owner (занимает слот при первом обращении). */
+    TaskAccount* accountFor(uint32_t owner);
+#endif
+
+    /** Поместить область в карантин (без проверок и статистики). */
+    void retireBlock(AllocBlockHeader* header);
+
+#if ALLOC_ENABLE_HANDLES
+    /** Сдвинуть область со страницы from на страницу to (to < from, участок перед ней свободен). */
+    void moveBlock(AllocBlockHeader* header, uint32_t to);
+#endif
+
+    /** Переписать хедер, футер и паддинг области. */
+    void writeGuards(uint32_t startPage, uint32_t pageCount,
+                     size_t requestedSize, uint32_t seq,
+                     uint16_t headOffset, uint8_t flags,
+                     uint32_t ownerTask, uint32_t callerPc);
+
+    /** Подобрать свободный участок согласно ALLOC_FIT_POLICY. */
+    int32_t findRun(uint32_t pages);
+
+    /** Участок, начинающийся на firstPage + k·stride (stride 1 — по политике). */
+    int32_t findRunFrom(uint32_t pages, uint32_t firstPage, uint32_t stride);
+
+    /** Свободные страницы вместе с карантином и незавершёнными заливками. */
+    size_t reclaimablePages() const;
+
+    /**
+     * Найти участок под pages страниц (заведомо больший, чем
+     * reclaimablePages, — сразу -1); при нехватке — дождаться
+     * асинхронных очисток и (ALLOC_QUARANTINE_EVICT_ON_PRESSURE)
+     * вытеснить карантин.
+     */
+    int32_t acquireRun(uint32_t pages, uint32_t firstPage, uint32_t stride);
+
+    /** Пометить участок занятым (inUse + индекс + статистика). */
+    void claimPages(uint32_t startPage, uint32_t pageCount);
+
+    /** Вернуть участок в свободные со слиянием соседей. */
+    void releasePages(uint32_t startPage, uint32_t pageCount);
+
+    /** Страницы очищены (ALLOC_PATTERN_CLEARED_PAGE) — отметить в bitmapZeroed. */
+    void markZeroed(uint32_t startPage, uint32_t pageCount);
+
+    /** Обнулить payload свежей области size байт — только на неочищенных страницах. */
+    void zeroPayload(void* userPtr, size_t size);
+
+    /** Страница перед page / сама page существует и свободна (для счёта участков). */
+    bool freeNeighbourBefore(uint32_t page) const;
+    bool freeNeighbourAfter(uint32_t page) const;
+
+    /** Проверить одну запись карантина. */
+    bool verifyQuarantineEntry(const AllocQuarantineEntry* entry) const;
+
+    /**
+     * Проверить область, начинающуюся на странице page (если она есть).
+     * @return Число страниц до следующего кандидата; 0 — порча.
+     */
+    uint32_t verifyAllocatedAt(uint32_t page) const;
+
     void evictFromQuarantine(const AllocQuarantineEntry& entry);
-    void updateMpuProtection(uint16_t startPage, uint16_t pageCount);
+
+    /* ── Асинхронные заливки ── */
+
+    /**
+     * Залить size байт паттерном: крупные — через FillEngine, если есть
+     * свободный слот, остальные — CPU.
+     * @return true — заливка ушла в FillEngine и завершится позже.
+     */
+    bool fill(void* dst, uint8_t pattern, size_t size,
+              uint32_t startPage, uint32_t pageCount, uint8_t kind);
+
+    /** Завершить готовые (или все при wait) заливки. */
+    void reapFills(bool wait);
+
+    /** Дождаться заливки участка, начинающегося с startPage (если она есть). */
+    void waitFill(uint32_t startPage);
+    void updateMpuProtection(uint32_t startPage, uint32_t pageCount);
 };
 
 } // namespace AllocCustom
@@ -7,81 +7,417 @@
 
 namespace AllocCustom {
 
-void PageBitmap::init(uint16_t count) {
-    ALLOC_ASSERT(count <= ALLOC_MAX_PAGES_PER_ZONE);
-    std::memset(words, 0, sizeof(words));
+namespace {
+
+/** Маска бит слова wordIdx, попадающих в диапазон [start, start+count). */
+inline uint32_t rangeMask(uint32_t wordIdx, uint32_t start, uint32_t count) {
+    const uint32_t first = wordIdx * 32U;
+    const uint32_t lo = (start > first) ? start - first : 0U;
+    const uint32_t end = start + count - first;   /* > lo */
+    const uint32_t hi = (end < 32U) ? end : 32U;
+    const uint32_t upper = (hi == 32U) ? 0xFFFFFFFFU : ((1U << hi) - 1U);
+    return upper & (0xFFFFFFFFU << lo);
+}
+
+/** Число подряд идущих единиц с младшего бита (CTZ инверсии). */
+inline uint32_t trailingOnes(uint32_t x) {
+    return (x == 0xFFFFFFFFU) ? 32U : static_cast<uint32_t>(__builtin_ctz(~x));
+}
+
+/** Число подряд идущих единиц со старшего бита (CLZ инверсии). */
+inline uint32_t leadingOnes(uint32_t x) {
+    return (x == 0xFFFFFFFFU) ? 32U : static_cast<uint32_t>(__builtin_clz(~x));
+}
+
+/** Длина наибольшей серии единиц в слове — прыжками по CTZ. */
+inline uint32_t longestOnes(uint32_t x) {
+    uint32_t best = 0U;
+    while (x != 0U) {
+        const uint32_t pos  = static_cast<uint32_t>(__builtin_ctz(x));
+        const uint32_t ones = trailingOnes(x >> pos);
+        if (ones > best) best = ones;
+        if (pos + ones >= 32U) break;
+        x &= 0xFFFFFFFFU << (pos + ones);
+    }
+    return best;
+}
+
+} // namespace
+
+size_t PageBitmap::storageBytes(uint32_t count) {
+    const size_t w = (static_cast<size_t>(count) + 31U) / 32U;
+    const size_t s = (w + kWordsPerSuper - 1U) / kWordsPerSuper;
+    const size_t bytes = w * sizeof(uint32_t) + 2U * s * sizeof(uint32_t) + 3U * s * sizeof(uint16_t);
+    return (bytes + sizeof(uint32_t) - 1U) & ~(sizeof(uint32_t) - 1U);
+}
+
+void PageBitmap::init(uint32_t count, void* storage) {
+    ALLOC_ASSERT(storage != nullptr);
+    ALLOC_ASSERT((reinterpret_cast<uintptr_t>(storage) % sizeof(uint32_t)) == 0U);
+
+    const uint32_t w = (count + 31U) / 32U;
+    const uint32_t s = (w + kWordsPerSuper - 1U) / kWordsPerSuper;
+    std::memset(storage, 0, storageBytes(count));
+
+    /* Разметка: слова, флаги слов, затем 16-битные сводки суперблоков */
+    words        = static_cast<uint32_t*>(storage);
+    fullWords    = words + w;
+    emptyWords   = fullWords + s;
+    superPrefix  = reinterpret_cast<uint16_t*>(emptyWords + s);
+    superSuffix  = superPrefix + s;
+    superLongest = superSuffix + s;
+
     pageCount = count;
+    if (count > 0U) {
+        refreshSummary(0U, (count - 1U) / 32U);
+    }
 }
 
-void PageBitmap::set(uint16_t page) {
+void PageBitmap::set(uint32_t page) {
     ALLOC_ASSERT(page < pageCount);
     words[page / 32U] |= (1U << (page % 32U));
+    refreshSummary(page / 32U, page / 32U);
 }
 
-void PageBitmap::clear(uint16_t page) {
+void PageBitmap::clear(uint32_t page) {
     ALLOC_ASSERT(page < pageCount);
     words[page / 32U] &= ~(1U << (page % 32U));
+    refreshSummary(page / 32U, page / 32U);
 }
 
-bool PageBitmap::test(uint16_t page) const {
+bool PageBitmap::test(uint32_t page) const {
     ALLOC_ASSERT(page < pageCount);
     return (words[page / 32U] & (1U << (page % 32U))) != 0U;
 }
 
-void PageBitmap::setRange(uint16_t start, uint16_t count) {
-    ALLOC_ASSERT(start + count <= pageCount);
-    for (uint16_t i = 0; i < count; ++i) {
-        set(static_cast<uint16_t>(start + i));
+void PageBitmap::setRange(uint32_t start, uint32_t count) {
+    ALLOC_ASSERT(static_cast<uint64_t>(start) + count <= pageCount);
+    if (count == 0U) return;
+    const uint32_t firstWord = start / 32U;
+    const uint32_t lastWord  = (start + count - 1U) / 32U;
+    for (uint32_t w = firstWord; w <= lastWord; ++w) {
+        words[w] |= rangeMask(w, start, count);
     }
+    refreshSummary(firstWord, lastWord);
 }
 
-void PageBitmap::clearRange(uint16_t start, uint16_t count) {
-    ALLOC_ASSERT(start + count <= pageCount);
-    for (uint16_t i = 0; i < count; ++i) {
-        clear(static_cast<uint16_t>(start + i));
+void PageBitmap::clearRange(uint32_t start, uint32_t count) {
+    ALLOC_ASSERT(static_cast<uint64_t>(start) + count <= pageCount);
+    if (count == 0U) return;
+    const uint32_t firstWord = start / 32U;
+    const uint32_t lastWord  = (start + count - 1U) / 32U;
+    for (uint32_t w = firstWord; w <= lastWord; ++w) {
+        words[w] &= ~rangeMask(w, start, count);
     }
+    refreshSummary(firstWord, lastWord);
 }
 
-int32_t PageBitmap::findFreeRun(uint16_t count) const {
-    if (count == 0 || count > pageCount) {
-        return -1;
+bool PageBitmap::testShared(uint32_t page) const {
+    ALLOC_ASSERT(page < pageCount);
+    return (__atomic_load_n(&words[page / 32U], __ATOMIC_RELAXED) & (1U << (page % 32U))) != 0U;
+}
+
+void PageBitmap::setRangeShared(uint32_t start, uint32_t count) {
+    ALLOC_ASSERT(static_cast<uint64_t>(start) + count <= pageCount);
+    if (count == 0U) return;
+    const uint32_t firstWord = start / 32U;
+    const uint32_t lastWord  = (start + count - 1U) / 32U;
+    for (uint32_t w = firstWord; w <= lastWord; ++w) {
+        (void)__atomic_fetch_or(&words[w], rangeMask(w, start, count), __ATOMIC_RELAXED);
+    }
+    refreshSummary(firstWord, lastWord);
+}
+
+void PageBitmap::clearRangeShared(uint32_t start, uint32_t count) {
+    ALLOC_ASSERT(static_cast<uint64_t>(start) + count <= pageCount);
+    if (count == 0U) return;
+    const uint32_t firstWord = start / 32U;
+    const uint32_t lastWord  = (start + count - 1U) / 32U;
+    for (uint32_t w = firstWord; w <= lastWord; ++w) {
+        (void)__atomic_fetch_and(&words[w], ~rangeMask(w, start, count), __ATOMIC_RELAXED);
+    }
+    refreshSummary(firstWord, lastWord);
+}
+
+/* ───────── Сводка ───────── */
+
+uint32_t PageBitmap::freeMask(uint32_t wordIdx) const {
+    const uint32_t first = wordIdx * 32U;
+    if (first >= pageCount) return 0U;
+    const uint32_t valid = pageCount - first;
+    const uint32_t mask  = (valid >= 32U) ? 0xFFFFFFFFU : ((1U << valid) - 1U);
+    return ~words[wordIdx] & mask;
+}
+
+uint32_t PageBitmap::superPages(uint32_t superIdx) const {
+    const uint32_t first = superIdx * kPagesPerSuper;
+    const uint32_t rest  = pageCount - first;
+    return (rest < kPagesPerSuper) ? rest : kPagesPerSuper;
+}
+
+void PageBitmap::refreshSummary(uint32_t firstWord, uint32_t lastWord) {
+    for (uint32_t w = firstWord; w <= lastWord; ++w) {
+        const uint32_t s   = w / kWordsPerSuper;
+        const uint32_t bit = 1U << (w % kWordsPerSuper);
+        const uint32_t first = w * 32U;
+        const uint32_t valid = pageCount - first;
+        const uint32_t mask  = (valid >= 32U) ? 0xFFFFFFFFU : ((1U << valid) - 1U);
+        const uint32_t freeBits = freeMask(w);
+
+        fullWords[s]  = (freeBits == 0U)   ? (fullWords[s]  | bit) : (fullWords[s]  & ~bit);
+        emptyWords[s] = (freeBits == mask) ? (emptyWords[s] | bit) : (emptyWords[s] & ~bit);
     }
+    for (uint32_t s = firstWord / kWordsPerSuper; s <= lastWord / kWordsPerSuper; ++s) {
+        refreshSuper(s);
+    }
+}
+
+void PageBitmap::refreshSuper(uint32_t superIdx) {
+    const uint32_t wordCount = static_cast<uint32_t>((pageCount + 31U) / 32U);
+    const uint32_t firstWord = static_cast<uint32_t>(superIdx * kWordsPerSuper);
+    const uint32_t lastWord  = static_cast<uint32_t>(
+        (firstWord + kWordsPerSuper < wordCount) ? firstWord + kWordsPerSuper : wordCount);
+
+    uint32_t prefix   = 0U;
+    uint32_t run      = 0U;
+    uint32_t longest  = 0U;
+    bool     inPrefix = true;
 
-    uint16_t runStart = 0;
-    uint16_t runLen   = 0;
+    for (uint32_t w = firstWord; w < lastWord; ++w) {
+        const uint32_t bit   = 1U << (w % kWordsPerSuper);
+        const uint32_t first = w * 32U;
+        const uint32_t valid = (pageCount - first < 32U) ? pageCount - first : 32U;
+
+        if (fullWords[superIdx] & bit) {
+            if (inPrefix) { prefix = run; inPrefix = false; }
+            if (run > longest) longest = run;
+            run = 0U;
+            continue;
+        }
 
-    for (uint16_t i = 0; i < pageCount; ++i) {
-        /* Быстрый пропуск полностью занятых 32-битных слов */
-        const uint16_t wordIdx = i / 32U;
-        if (runLen == 0 && words[wordIdx] == 0xFFFFFFFFU) {
-            i = static_cast<uint16_t>((wordIdx + 1U) * 32U - 1U);
+        const uint32_t freeBits = freeMask(w);
+        const uint32_t lead = trailingOnes(freeBits);
+        if (lead >= valid) {
+            run += valid;
             continue;
         }
 
-        if (!test(i)) {
-            if (runLen == 0) {
-                runStart = i;
+        /* Серия из предыдущих слов обрывается внутри этого */
+        run += lead;
+        if (inPrefix) { prefix = run; inPrefix = false; }
+        if (run > longest) longest = run;
+
+        const uint32_t inner = longestOnes(freeBits);
+        if (inner > longest) longest = inner;
+
+        /* Биты за pageCount нулевые, поэтому хвост неполного слова = 0 */
+        run = leadingOnes(freeBits);
+    }
+    if (inPrefix) prefix = run;
+    if (run > longest) longest = run;
+
+    superPrefix[superIdx]  = static_cast<uint16_t>(prefix);
+    superSuffix[superIdx]  = static_cast<uint16_t>(run);
+    superLongest[superIdx] = static_cast<uint16_t>(longest);
+}
+
+/* ───────── Поиск свободного участка ───────── */
+
+int32_t PageBitmap::findInSuper(uint32_t superIdx, uint32_t count) const {
+    const uint32_t wordCount = static_cast<uint32_t>((pageCount + 31U) / 32U);
+    const uint32_t firstWord = static_cast<uint32_t>(superIdx * kWordsPerSuper);
+    const uint32_t lastWord  = static_cast<uint32_t>(
+        (firstWord + kWordsPerSuper < wordCount) ? firstWord + kWordsPerSuper : wordCount);
+
+    uint32_t runStart = 0U;
+    uint32_t runLen   = 0U;
+
+    for (uint32_t w = firstWord; w < lastWord; ++w) {
+        const uint32_t bit   = 1U << (w % kWordsPerSuper);
+        const uint32_t first = w * 32U;
+        const uint32_t valid = (pageCount - first < 32U) ? pageCount - first : 32U;
+
+        /* Быстрый пропуск полностью занятых слов */
+        if (fullWords[superIdx] & bit) {
+            runLen = 0U;
+            continue;
+        }
+        /* Полностью свободное слово — весь блок разом */
+        if (emptyWords[superIdx] & bit) {
+            if (runLen == 0U) runStart = first;
+            runLen += valid;
+            if (runLen >= count) return static_cast<int32_t>(runStart);
+            continue;
+        }
+
+        const uint32_t freeBits = freeMask(w);
+
+        /* Продолжение серии, пришедшей из младших слов */
+        if (runLen > 0U) {
+            const uint32_t lead = trailingOnes(freeBits);
+            if (runLen + lead >= count) return static_cast<int32_t>(runStart);
+            if (lead >= valid) {
+                runLen += valid;
+                continue;
             }
-            ++runLen;
-            if (runLen >= count) {
-                return static_cast<int32_t>(runStart);
+            runLen = 0U;
+        }
+
+        /* Серии внутри слова: CTZ — к началу, CTZ инверсии — к концу */
+        uint32_t x = freeBits;
+        while (x != 0U) {
+            const uint32_t pos  = static_cast<uint32_t>(__builtin_ctz(x));
+            const uint32_t ones = trailingOnes(x >> pos);
+            if (ones >= count) return static_cast<int32_t>(first + pos);
+            if (pos + ones >= 32U) {
+                runStart = first + pos;
+                runLen   = ones;
+                break;
             }
-        } else {
-            runLen = 0;
+            x &= 0xFFFFFFFFU << (pos + ones);
+        }
+    }
+
+    ALLOC_ASSERT(!"Сводка суперблока расходится с битовой картой");
+    return -1;
+}
+
+int32_t PageBitmap::findFreeRun(uint32_t count) const {
+    if (count == 0 || count > pageCount) {
+        return -1;
+    }
+
+    const uint32_t supers = static_cast<uint32_t>((pageCount + kPagesPerSuper - 1U) / kPagesPerSuper);
+    uint32_t carry = 0U;   /* Свободный хвост, тянущийся из предыдущих суперблоков */
+
+    for (uint32_t s = 0; s < supers; ++s) {
+        const uint32_t base = s * kPagesPerSuper;
+
+        /* Участок, начавшийся раньше, имеет приоритет (first-fit) */
+        if (carry > 0U && carry + superPrefix[s] >= count) {
+            return static_cast<int32_t>(base - carry);
+        }
+        if (superLongest[s] >= count) {
+            return findInSuper(s, count);
+        }
+
+        const uint32_t pages = superPages(s);
+        carry = (superPrefix[s] == pages) ? carry + pages : superSuffix[s];
+    }
+    return -1;
+}
+
+int32_t PageBitmap::findFreeRunAligned(uint32_t count, uint32_t first, uint32_t stride) const {
+    if (count == 0 || stride == 0 || count > pageCount) {
+        return -1;
+    }
+
+    uint32_t p = first;
+    while (p < pageCount && count <= pageCount - p) {
+        const uint32_t run = clearRunFrom(p);
+        if (run >= count) {
+            return static_cast<int32_t>(p);
         }
+        /* Следующий кандидат — не раньше первой свободной страницы за участком */
+        const uint32_t next = nextClear(p + run);
+        if (next >= pageCount) break;
+        const uint64_t cand = first + static_cast<uint64_t>(next - first + stride - 1U) / stride * stride;
+        if (cand >= pageCount) break;
+        p = static_cast<uint32_t>(cand);
     }
     return -1;
 }
 
-uint16_t PageBitmap::countSet() const {
-    uint16_t n = 0;
-    const uint16_t fullWords = pageCount / 32U;
-    for (uint16_t w = 0; w < fullWords; ++w) {
+uint32_t PageBitmap::longestFreeRun() const {
+    const uint32_t supers = static_cast<uint32_t>((pageCount + kPagesPerSuper - 1U) / kPagesPerSuper);
+    uint32_t carry = 0U;
+    uint32_t best  = 0U;
+
+    for (uint32_t s = 0; s < supers; ++s) {
+        if (superLongest[s] > best)          best = superLongest[s];
+        if (carry + superPrefix[s] > best)   best = carry + superPrefix[s];
+
+        const uint32_t pages = superPages(s);
+        carry = (superPrefix[s] == pages) ? carry + pages : superSuffix[s];
+    }
+    if (carry > best) best = carry;
+    return best;
+}
+
+/* ───────── Границы свободных участков ───────── */
+
+uint32_t PageBitmap::clearRunBefore(uint32_t page) const {
+    ALLOC_ASSERT(page <= pageCount);
+    uint32_t n   = 0U;
+    uint32_t pos = page;   /* исключающая граница */
+
+    while (pos > 0U) {
+        const auto     w    = static_cast<uint32_t>((pos - 1U) / 32U);
+        const uint32_t bits = (pos - 1U) % 32U + 1U;   /* бит слова ниже pos */
+        const uint32_t x    = (bits == 32U) ? freeMask(w) : (freeMask(w) << (32U - bits));
+        const uint32_t ones = leadingOnes(x);
+        n += ones;
+        if (ones < bits) break;
+        pos -= bits;
+    }
+    return n;
+}
+
+uint32_t PageBitmap::clearRunFrom(uint32_t page) const {
+    ALLOC_ASSERT(page <= pageCount);
+    uint32_t n   = 0U;
+    uint32_t pos = page;
+
+    while (pos < pageCount) {
+        const auto     w    = static_cast<uint32_t>(pos / 32U);
+        const uint32_t b    = pos % 32U;
+        const uint32_t ones = trailingOnes(freeMask(w) >> b);   /* биты за pageCount = 0 */
+        const uint32_t span = (ones > 32U - b) ? 32U - b : ones;
+        n += span;
+        if (span < 32U - b) break;
+        pos += 32U - b;
+    }
+    return n;
+}
+
+uint32_t PageBitmap::nextClear(uint32_t page) const {
+    const uint32_t wordCount = static_cast<uint32_t>((pageCount + 31U) / 32U);
+    for (uint32_t w = page / 32U; w < wordCount; ++w) {
+        uint32_t f = freeMask(w);
+        if (w == page / 32U) {
+            f &= 0xFFFFFFFFU << (page % 32U);
+        }
+        if (f != 0U) {
+            return static_cast<uint32_t>(w * 32U + __builtin_ctz(f));
+        }
+    }
+    return pageCount;
+}
+
+uint32_t PageBitmap::nextSet(uint32_t page) const {
+    const uint32_t wordCount = static_cast<uint32_t>((pageCount + 31U) / 32U);
+    for (uint32_t w = page / 32U; w < wordCount; ++w) {
+        uint32_t s = words[w];
+        if (w == page / 32U) {
+            s &= 0xFFFFFFFFU << (page % 32U);
+        }
+        if (s != 0U) {
+            const uint32_t idx = static_cast<uint32_t>(w * 32U + __builtin_ctz(s));
+            return (idx < pageCount) ? idx : pageCount;
+        }
+    }
+    return pageCount;
+}
+
+uint32_t PageBitmap::countSet() const {
+    uint32_t n = 0;
+    const uint32_t fullWords = pageCount / 32U;
+    for (uint32_t w = 0; w < fullWords; ++w) {
         /* __builtin_popcount доступен в GCC и Clang */
-        n = static_cast<uint16_t>(n + __builtin_popcount(words[w]));
+        n += static_cast<uint32_t>(__builtin_popcount(words[w]));
     }
     /* Остаток */
-    for (uint16_t i = fullWords * 32U; i < pageCount; ++i) {
+    for (uint32_t i = fullWords * 32U; i < pageCount; ++i) {
         if (test(i)) {
             ++n;
         }
@@ -89,8 +425,8 @@ uint16_t PageBitmap::countSet() const {
     return n;
 }
 
-uint16_t PageBitmap::countClear() const {
-    return static_cast<uint16_t>(pageCount - countSet());
+uint32_t PageBitmap::countClear() const {
+    return pageCount - countSet();
 }
 
 } // namespace AllocCustom
@@ -13,43 +13,114 @@ namespace AllocCustom {
 /**
  * @brief Битовая карта для отслеживания состояния страниц.
  *
+ * Поверх битового массива ведётся двухуровневая сводка:
+ *   - флаги слов «полностью занято» / «полностью свободно»;
+ *   - для суперблока из kWordsPerSuper слов — длина свободного
+ *     префикса, суффикса и наибольшего свободного участка внутри.
+ * findFreeRun() пропускает суперблоки, в которых участок заведомо
+ * не помещается, не трогая их слова.
+ *
+ * Биты за пределами pageCount считаются занятыми. Массивы карты и сводки
+ * лежат во внешнем хранилище (storageBytes()), которое выделяет владелец.
+ *
  * POD-тип: zero-init из BSS безопасен. Полная инициализация — через init().
  */
 struct PageBitmap {
-    static constexpr uint16_t kMaxWords = (ALLOC_MAX_PAGES_PER_ZONE + 31U) / 32U;
+    static constexpr uint32_t kWordsPerSuper = 8U;
+    static constexpr uint32_t kPagesPerSuper = kWordsPerSuper * 32U;
+
+    uint32_t* words;            /**< Битовый массив */
+    uint32_t  pageCount;        /**< Фактическое число страниц в зоне */
 
-    uint32_t words[kMaxWords];  /**< Битовый массив */
-    uint16_t pageCount;         /**< Фактическое число страниц в зоне */
+    /* ── Сводка ── */
+    uint32_t* fullWords;        /**< Бит w: слово полностью занято */
+    uint32_t* emptyWords;       /**< Бит w: слово полностью свободно */
+    uint16_t* superPrefix;      /**< Свободных страниц в начале суперблока */
+    uint16_t* superSuffix;      /**< Свободных страниц в конце суперблока */
+    uint16_t* superLongest;     /**< Наибольший свободный участок внутри */
 
-    /** Инициализация: обнуление всех бит, установка числа страниц. */
-    void init(uint16_t count);
+    /** Байт хранилища (кратно 4) под карту из count страниц. */
+    static size_t storageBytes(uint32_t count);
+
+    /**
+     * Инициализация поверх storage (storageBytes(count) байт, выравнивание 4):
+     * обнуление всех бит, установка числа страниц.
+     */
+    void init(uint32_t count, void* storage);
 
     /** Установить бит страницы (пометить как 1). */
-    void set(uint16_t page);
+    void set(uint32_t page);
 
     /** Снять бит страницы (пометить как 0). */
-    void clear(uint16_t page);
+    void clear(uint32_t page);
 
     /** Проверить бит страницы. */
-    bool test(uint16_t page) const;
+    bool test(uint32_t page) const;
 
     /** Установить диапазон бит [start, start+count). */
-    void setRange(uint16_t start, uint16_t count);
+    void setRange(uint32_t start, uint32_t count);
 
     /** Снять диапазон бит [start, start+count). */
-    void clearRange(uint16_t start, uint16_t count);
+    void clearRange(uint32_t start, uint32_t count);
+
+    /*
+     * Для карты, которую читают без лока владельца (slab-страницы):
+     * слова меняются и читаются атомарно (relaxed), остальное — как у
+     * test/setRange/clearRange. Пишет по-прежнему только владелец лока.
+     */
+    bool testShared(uint32_t page) const;
+    void setRangeShared(uint32_t start, uint32_t count);
+    void clearRangeShared(uint32_t start, uint32_t count);
 
     /**
      * Найти первый непрерывный участок из count нулевых бит.
      * @return Индекс первой страницы или -1 если не найден.
      */
-    int32_t findFreeRun(uint16_t count) const;
+    int32_t findFreeRun(uint32_t count) const;
+
+    /**
+     * Первый участок из count нулевых бит, начинающийся на странице
+     * first + k·stride.
+     * @return Индекс первой страницы или -1 если не найден.
+     */
+    int32_t findFreeRunAligned(uint32_t count, uint32_t first, uint32_t stride) const;
+
+    /** Длина наибольшего участка нулевых бит (по сводке, без обхода слов). */
+    uint32_t longestFreeRun() const;
+
+    /** Число нулевых бит непосредственно перед page (page ≤ pageCount). */
+    uint32_t clearRunBefore(uint32_t page) const;
+
+    /** Число нулевых бит, начиная с page (page ≤ pageCount). */
+    uint32_t clearRunFrom(uint32_t page) const;
+
+    /** Первый нулевой бит ≥ page; pageCount, если такого нет. */
+    uint32_t nextClear(uint32_t page) const;
+
+    /** Первый установленный бит ≥ page; pageCount, если такого нет. */
+    uint32_t nextSet(uint32_t page) const;
 
     /** Число установленных бит. */
-    uint16_t countSet() const;
+    uint32_t countSet() const;
 
     /** Число нулевых бит (свободных страниц). */
-    uint16_t countClear() const;
+    uint32_t countClear() const;
+
+private:
+    /** Маска свободных бит слова (биты за pageCount — заняты). */
+    uint32_t freeMask(uint32_t wordIdx) const;
+
+    /** Число страниц в суперблоке (последний может быть неполным). */
+    uint32_t superPages(uint32_t superIdx) const;
+
+    /** Пересчитать сводку по диапазону слов [firstWord, lastWord]. */
+    void refreshSummary(uint32_t firstWord, uint32_t lastWord);
+
+    /** Пересчитать префикс/суффикс/максимум суперблока. */
+    void refreshSuper(uint32_t superIdx);
+
+    /** Первый участок из count свободных страниц внутри суперблока. */
+    int32_t findInSuper(uint32_t superIdx, uint32_t count) const;
 };
 
 } // namespace AllocCustom
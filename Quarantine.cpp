@@ -4,78 +4,131 @@
  */
 #include "Quarantine.hpp"
 #include <cstring>
-#include <climits>
 
 namespace AllocCustom {
 
 void QuarantineTable::init() {
     std::memset(entries, 0, sizeof(entries));
+    std::memset(byAddress, 0, sizeof(byAddress));
     nextSequence = 1U;   /* 0 = неиспользованная запись */
+    head         = 0U;
+    used         = 0U;
     activeCount  = 0U;
+    pagesHeld    = 0U;
 }
 
-bool QuarantineTable::add(uint16_t startPage, uint16_t pageCount,
+bool QuarantineTable::add(uint32_t startPage, uint32_t pageCount,
                            uint32_t requestedSize, uint8_t zoneIndex,
+                           uint16_t headOffset,
                            AllocQuarantineEntry* evicted) {
     bool didEvict = false;
 
-    if (isFull()) {
-        AllocQuarantineEntry* oldest = findOldest();
-        ALLOC_ASSERT(oldest != nullptr);
-        if (evicted != nullptr) {
-            *evicted = *oldest;
-        }
-        oldest->active = 0U;
-        --activeCount;
-        didEvict = true;
+    skipRetired();
+    if (used >= ALLOC_QUARANTINE_CAPACITY) {
+        AllocQuarantineEntry dropped{};
+        didEvict = evictOldest(evicted != nullptr ? evicted : &dropped);
     }
 
-    /* Поиск свободного слота */
-    AllocQuarantineEntry* slot = nullptr;
-    for (uint16_t i = 0; i < ALLOC_QUARANTINE_CAPACITY; ++i) {
-        if (!entries[i].active) {
-            slot = &entries[i];
-            break;
-        }
-    }
-    ALLOC_ASSERT(slot != nullptr);
+    uint32_t tail = static_cast<uint32_t>(head) + used;
+    if (tail >= ALLOC_QUARANTINE_CAPACITY) tail -= ALLOC_QUARANTINE_CAPACITY;
+    const uint16_t slotIdx = static_cast<uint16_t>(tail);
+    AllocQuarantineEntry* slot = &entries[slotIdx];
+    ALLOC_ASSERT(!slot->active);
 
     slot->startPage     = startPage;
     slot->pageCount     = pageCount;
     slot->requestedSize = requestedSize;
     slot->freeSequence   = nextSequence++;
+    slot->headOffset    = headOffset;
     slot->mpuRegion     = -1;
     slot->zoneIndex     = zoneIndex;
     slot->active        = 1U;
-    slot->reserved      = 0U;
+    slot->fillPending   = 0U;
+    ++used;
+    pagesHeld += pageCount;
+
+    /* Вставка в индекс: записи карантина не пересекаются, ключи уникальны */
+    const uint16_t pos = lowerBound(startPage);
+    std::memmove(&byAddress[pos + 1U], &byAddress[pos],
+                 static_cast<size_t>(activeCount - pos) * sizeof(byAddress[0]));
+    byAddress[pos] = slotIdx;
     ++activeCount;
 
     return didEvict;
 }
 
+bool QuarantineTable::evictOldest(AllocQuarantineEntry* evicted) {
+    ALLOC_ASSERT(evicted != nullptr);
+    skipRetired();
+    if (used == 0U) return false;
+
+    /* Голова после skipRetired() всегда активна */
+    *evicted = entries[head];
+    retire(head);
+    skipRetired();
+    return true;
+}
+
 AllocQuarantineEntry* QuarantineTable::findOldest() {
-    AllocQuarantineEntry* oldest = nullptr;
-    uint32_t minSeq = UINT32_MAX;
+    skipRetired();
+    return (used != 0U) ? &entries[head] : nullptr;
+}
 
-    for (uint16_t i = 0; i < ALLOC_QUARANTINE_CAPACITY; ++i) {
-        if (entries[i].active && entries[i].freeSequence < minSeq) {
-            minSeq  = entries[i].freeSequence;
-            oldest  = &entries[i];
-        }
+AllocQuarantineEntry* QuarantineTable::find(uint32_t startPage) {
+    const uint16_t pos = lowerBound(startPage);
+    if (pos < activeCount && entries[byAddress[pos]].startPage == startPage) {
+        return &entries[byAddress[pos]];
     }
-    return oldest;
+    return nullptr;
 }
 
 void QuarantineTable::deactivate(AllocQuarantineEntry* entry) {
     ALLOC_ASSERT(entry != nullptr);
     ALLOC_ASSERT(entry->active);
-    entry->active = 0U;
+    retire(static_cast<uint16_t>(entry - entries));
+    skipRetired();
+}
+
+void QuarantineTable::retire(uint16_t slot) {
+    const uint16_t pos = lowerBound(entries[slot].startPage);
+    ALLOC_ASSERT(pos < activeCount && byAddress[pos] == slot);
+    std::memmove(&byAddress[pos], &byAddress[pos + 1U],
+                 static_cast<size_t>(activeCount - pos - 1U) * sizeof(byAddress[0]));
     --activeCount;
+    pagesHeld -= entries[slot].pageCount;
+    entries[slot].active = 0U;
+}
+
+void QuarantineTable::skipRetired() {
+    while (used != 0U && !entries[head].active) {
+        if (++head == ALLOC_QUARANTINE_CAPACITY) head = 0U;
+        --used;
+    }
 }
 
 bool     QuarantineTable::isEmpty() const { return activeCount == 0U; }
 bool     QuarantineTable::isFull()  const { return activeCount >= ALLOC_QUARANTINE_CAPACITY; }
 uint16_t QuarantineTable::count()   const { return activeCount; }
+uint32_t QuarantineTable::pages()   const { return pagesHeld; }
+
+uint16_t QuarantineTable::lowerBound(uint32_t page) const {
+    uint16_t lo = 0U;
+    uint16_t hi = activeCount;
+    while (lo < hi) {
+        const uint16_t mid = static_cast<uint16_t>(lo + (hi - lo) / 2U);
+        if (entries[byAddress[mid]].startPage < page) {
+            lo = static_cast<uint16_t>(mid + 1U);
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+AllocQuarantineEntry* QuarantineTable::byAddressAt(uint16_t pos) {
+    ALLOC_ASSERT(pos < activeCount);
+    return &entries[byAddress[pos]];
+}
 
 const AllocQuarantineEntry* QuarantineTable::entryAt(uint16_t idx) const {
     ALLOC_ASSERT(idx < ALLOC_QUARANTINE_CAPACITY);
@@ -11,45 +11,86 @@
 
 namespace AllocCustom {
 
+ALLOC_STATIC_ASSERT(ALLOC_QUARANTINE_CAPACITY > 0U && ALLOC_QUARANTINE_CAPACITY < 0xFFFFU,
+                    "ALLOC_QUARANTINE_CAPACITY must fit uint16_t indices");
+
 /**
  * @brief Таблица карантина для одной зоны.
  *
  * Хранит последние ALLOC_QUARANTINE_CAPACITY освобождённых областей.
- * При заполнении вытесняется самая старая запись (FIFO).
+ * Записи лежат в кольце в порядке освобождения: добавление — в хвост,
+ * вытеснение самой старой — из головы, обе операции O(1).
+ * Отдельный индекс byAddress упорядочен по первой странице: поиск
+ * записи и выборка по диапазону адресов — двоичным поиском.
+ *
  * POD-тип: zero-init из BSS безопасен.
  */
 struct QuarantineTable {
     AllocQuarantineEntry entries[ALLOC_QUARANTINE_CAPACITY];
+    uint16_t byAddress[ALLOC_QUARANTINE_CAPACITY]; /**< Слоты активных записей по startPage */
     uint32_t nextSequence;    /**< Следующий порядковый номер free */
+    uint16_t head;            /**< Слот самой старой записи кольца */
+    uint16_t used;            /**< Занято слотов кольца (вместе с деактивированными) */
     uint16_t activeCount;     /**< Число активных записей */
+    uint32_t pagesHeld;       /**< Страниц во всех активных записях */
 
     /** Инициализация: обнуление всех записей. */
     void init();
 
     /**
      * Добавить область в карантин.
-     * Если таблица полна, вытесняет самую старую запись.
+     * Если кольцо заполнено, вытесняет самую старую запись.
      * @param evicted [out] вытесненная запись (если произошло вытеснение).
      * @return true если произошло вытеснение.
      */
-    bool add(uint16_t startPage, uint16_t pageCount,
+    bool add(uint32_t startPage, uint32_t pageCount,
              uint32_t requestedSize, uint8_t zoneIndex,
+             uint16_t headOffset,
              AllocQuarantineEntry* evicted);
 
-    /** Найти самую старую активную запись. */
+    /**
+     * Вытеснить самую старую активную запись.
+     * @param evicted [out] вытесненная запись.
+     * @return false — карантин пуст.
+     */
+    bool evictOldest(AllocQuarantineEntry* evicted);
+
+    /** Самая старая активная запись. */
     AllocQuarantineEntry* findOldest();
 
-    /** Деактивировать запись. */
+    /** Найти активную запись по первой странице. */
+    AllocQuarantineEntry* find(uint32_t startPage);
+
+    /**
+     * Деактивировать запись. Слот освобождается, когда до него
+     * дойдёт голова кольца.
+     */
     void deactivate(AllocQuarantineEntry* entry);
 
     bool     isEmpty() const;
     bool     isFull()  const;
     uint16_t count()   const;
+    uint32_t pages()   const;
+
+    /* ── Индекс по адресу ── */
+
+    /** Позиция в индексе первой записи со startPage >= page. */
+    uint16_t lowerBound(uint32_t page) const;
+
+    /** Запись на позиции pos индекса (pos < count()). */
+    AllocQuarantineEntry* byAddressAt(uint16_t pos);
 
     const AllocQuarantineEntry* entryAt(uint16_t idx) const;
     AllocQuarantineEntry*       entryAt(uint16_t idx);
 
     static constexpr uint16_t capacity() { return ALLOC_QUARANTINE_CAPACITY; }
+
+private:
+    /** Убрать слот из индекса и снять флаг active. */
+    void retire(uint16_t slot);
+
+    /** Освободить деактивированные слоты в голове кольца. */
+    void skipRetired();
 };
 
 } // namespace AllocCustom
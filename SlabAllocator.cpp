@@ -0,0 +1,444 @@
+/**
+ * @file SlabAllocator.cpp
+ * @brief Реализация slab-слоя мелких объектов.
+ */
+#include "SlabAllocator.hpp"
+#include "PageAllocator.hpp"
+#include "BlockGuard.hpp"
+#include <cstring>
+
+namespace AllocCustom {
+
+/* ───────── Проверки конфигурации ───────── */
+
+static_assert(ALLOC_SLAB_CLASS_COUNT > 0U, "Нужен хотя бы один класс slab");
+static_assert(ALLOC_SLAB_MIN_CLASS_SIZE >= 8U &&
+              (ALLOC_SLAB_MIN_CLASS_SIZE & (ALLOC_SLAB_MIN_CLASS_SIZE - 1U)) == 0U,
+              "ALLOC_SLAB_MIN_CLASS_SIZE: степень двойки ≥ 8");
+/* Зоны со своей страницей — в проверке ALLOC_ZONE_PAGE_SIZES */
+static_assert(SlabAllocator::validGeometry(ALLOC_PAGE_SIZE),
+              "Старший класс slab должен вмещать хотя бы 2 объекта, смещение guard-а — в uint16_t");
+
+/* ───────── Инициализация ───────── */
+
+void SlabAllocator::init(PageAllocator* owner) {
+    ALLOC_ASSERT(owner != nullptr && owner->isInitialized());
+    zone = owner;
+#if ALLOC_ENABLE_SLAB
+    slabPages.init(owner->totalPages, owner->bitmapStorage(2U));
+#endif
+    std::memset(classes, 0, sizeof(classes));
+
+    successfulAllocs = 0U;
+    successfulFrees  = 0U;
+    slabsCreated     = 0U;
+    slabsReleased    = 0U;
+    cachedOut        = 0U;
+    cachedBack       = 0U;
+}
+
+/* ───────── Вспомогательные ───────── */
+
+bool SlabAllocator::servesSize(size_t requestedSize) {
+#if ALLOC_ENABLE_SLAB
+    return requestedSize > 0U && requestedSize <= classSize(kClassCount - 1U);
+#else
+    (void)requestedSize;
+    return false;
+#endif
+}
+
+uint8_t SlabAllocator::classFor(size_t requestedSize) {
+    uint8_t cls = 0U;
+    while (classSize(cls) < requestedSize) {
+        ++cls;
+    }
+    ALLOC_ASSERT(cls < kClassCount);
+    return cls;
+}
+
+bool SlabAllocator::ownsObject(const void* userPtr) const {
+#if ALLOC_ENABLE_SLAB
+    if (zone == nullptr) return false;
+    const int32_t page = zone->pageIndex(userPtr);
+    return page >= 0 && slabPages.testShared(static_cast<uint32_t>(page));
+#else
+    (void)userPtr;
+    return false;   /* Карта slab-страниц не размещена */
+#endif
+}
+
+uint8_t* SlabAllocator::slotAddress(SlabHeader* slab, uint8_t slot) {
+    return reinterpret_cast<uint8_t*>(slab) + kDescSize +
+           static_cast<size_t>(slot) * slotSize(slab->classIndex);
+}
+
+const uint8_t* SlabAllocator::slotAddress(const SlabHeader* slab, uint8_t slot) {
+    return reinterpret_cast<const uint8_t*>(slab) + kDescSize +
+           static_cast<size_t>(slot) * slotSize(slab->classIndex);
+}
+
+/* ───────── Guard объекта ───────── */
+
+uint16_t SlabAllocator::guardCheck(const AllocSlabGuard* g) {
+    return static_cast<uint16_t>(g->slabOffset ^ g->requestedSize ^
+                                 (g->classIndex | (g->state << 8U)) ^
+                                 ALLOC_PATTERN_SLAB_GUARD);
+}
+
+void SlabAllocator::writeGuard(AllocSlabGuard* g, uint16_t slabOffset,
+                               uint16_t requestedSize, uint8_t cls, uint8_t state) {
+    g->slabOffset    = slabOffset;
+    g->requestedSize = requestedSize;
+    g->classIndex    = cls;
+    g->state         = state;
+    g->check         = guardCheck(g);
+}
+
+bool SlabAllocator::validateGuard(const AllocSlabGuard* g) {
+    if (g->check != guardCheck(g)) return false;
+    if (g->state != ALLOC_SLAB_STATE_FREE && g->state != ALLOC_SLAB_STATE_USED &&
+        g->state != ALLOC_SLAB_STATE_CACHED) {
+        return false;
+    }
+    return g->classIndex < kClassCount && g->requestedSize <= classSize(g->classIndex);
+}
+
+/* ───────── Списки slab-ов ───────── */
+
+void SlabAllocator::listPush(SlabHeader** head, SlabHeader* slab) {
+    slab->prev = nullptr;
+    slab->next = *head;
+    if (*head != nullptr) {
+        (*head)->prev = slab;
+    }
+    *head = slab;
+}
+
+void SlabAllocator::listRemove(SlabHeader** head, SlabHeader* slab) {
+    if (slab->prev != nullptr) {
+        slab->prev->next = slab->next;
+    } else {
+        *head = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = nullptr;
+    slab->prev = nullptr;
+}
+
+/* ───────── Создание / возврат slab ───────── */
+
+SlabHeader* SlabAllocator::createSlab(uint8_t cls) {
+#if ALLOC_ENABLE_TASK_STATS
+    /* Slab общий для всех задач — его страницы ничьи */
+    zone->allocOwner = HEAP_TASK_OWNER_NONE;
+#endif
+    void* mem = zone->allocate(slabPayload(zone->pageSize));
+    if (mem == nullptr) return nullptr;
+
+    const auto* block = BlockGuard::headerFromUserData(mem);
+    slabPages.setRangeShared(block->startPage, block->pageCount);
+
+    auto* slab = static_cast<SlabHeader*>(mem);
+    slab->magic       = ALLOC_PATTERN_SLAB_MAGIC;
+    slab->classIndex  = cls;
+    slab->capacity    = slabCapacity(cls, zone->pageSize);
+    slab->usedCount   = 0U;
+    slab->reserved    = 0U;
+    slab->freeMask[0] = 0U;
+    slab->freeMask[1] = 0U;
+
+    for (uint8_t i = 0; i < slab->capacity; ++i) {
+        uint8_t* slot = slotAddress(slab, i);
+        writeGuard(reinterpret_cast<AllocSlabGuard*>(slot),
+                   static_cast<uint16_t>(slot - reinterpret_cast<uint8_t*>(slab)),
+                   0U, cls, ALLOC_SLAB_STATE_FREE);
+#if ALLOC_FILL_ON_FREE
+        if (zone->fillOnFree) {
+            BlockGuard::fillQuarantinePayload(slot + sizeof(AllocSlabGuard), classSize(cls));
+        }
+#endif
+        slab->freeMask[i / 32U] |= (1U << (i % 32U));
+    }
+
+    listPush(&classes[cls].partial, slab);
+    ++classes[cls].partialCount;
+    ++slabsCreated;
+    return slab;
+}
+
+void SlabAllocator::releaseSlab(SlabHeader* slab) {
+    SizeClass& c = classes[slab->classIndex];
+    listRemove(&c.partial, slab);
+    --c.partialCount;
+
+    const auto* block = BlockGuard::headerFromUserData(slab);
+    slabPages.clearRangeShared(block->startPage, block->pageCount);
+
+    slab->magic = 0U;
+    zone->deallocate(slab);
+    ++slabsReleased;
+}
+
+/* ───────── Аллокация ───────── */
+
+void* SlabAllocator::allocate(size_t requestedSize) {
+    if (zone == nullptr || !servesSize(requestedSize)) return nullptr;
+
+    const uint8_t cls = classFor(requestedSize);
+    SizeClass& c = classes[cls];
+
+    SlabHeader* slab = c.partial;
+    if (slab == nullptr) {
+        slab = createSlab(cls);
+        if (slab == nullptr) return nullptr;
+    }
+    ALLOC_ASSERT(slab->magic == ALLOC_PATTERN_SLAB_MAGIC);
+
+    /* Первый свободный слот */
+    const uint8_t word = (slab->freeMask[0] != 0U) ? 0U : 1U;
+    ALLOC_ASSERT(slab->freeMask[word] != 0U);
+    const auto slot = static_cast<uint8_t>(word * 32U + __builtin_ctz(slab->freeMask[word]));
+    slab->freeMask[word] &= ~(1U << (slot % 32U));
+
+    uint8_t* slotAddr = slotAddress(slab, slot);
+    auto* guard = reinterpret_cast<AllocSlabGuard*>(slotAddr);
+    uint8_t* payload = slotAddr + sizeof(AllocSlabGuard);
+
+    ALLOC_ASSERT(validateGuard(guard) && guard->state == ALLOC_SLAB_STATE_FREE);
+#if ALLOC_FILL_ON_FREE && ALLOC_QUARANTINE_CHECK_LEVEL >= 2
+    /* Запись в освобождённый объект */
+    ALLOC_ASSERT(zone->checkLevel < 2U ||
+                 BlockGuard::validateQuarantinePayload(payload, classSize(cls)));
+#endif
+
+    writeGuard(guard, guard->slabOffset, static_cast<uint16_t>(requestedSize),
+               cls, ALLOC_SLAB_STATE_USED);
+    if (requestedSize < classSize(cls)) {
+        BlockGuard::fillPadding(payload + requestedSize, classSize(cls) - requestedSize);
+    }
+
+    ++slab->usedCount;
+    if (slab->usedCount == slab->capacity) {
+        listRemove(&c.partial, slab);
+        --c.partialCount;
+        listPush(&c.full, slab);
+    }
+
+    ++successfulAllocs;
+    return payload;
+}
+
+/* ───────── Деаллокация ───────── */
+
+void SlabAllocator::deallocate(void* userPtr) {
+    release(userPtr, ALLOC_SLAB_STATE_USED);
+}
+
+void SlabAllocator::returnCached(void* userPtr) {
+    release(userPtr, ALLOC_SLAB_STATE_CACHED);
+}
+
+void SlabAllocator::release(void* userPtr, uint8_t state) {
+    if (zone == nullptr || userPtr == nullptr) return;
+
+    auto* payload = static_cast<uint8_t*>(userPtr);
+    auto* guard = reinterpret_cast<AllocSlabGuard*>(payload - sizeof(AllocSlabGuard));
+
+    /* Валидация guard-а и дескриптора */
+    ALLOC_ASSERT(validateGuard(guard));
+    ALLOC_ASSERT(guard->state == state && "Двойное освобождение объекта slab");
+    (void)state;
+
+    auto* slab = reinterpret_cast<SlabHeader*>(
+        reinterpret_cast<uint8_t*>(guard) - guard->slabOffset);
+    ALLOC_ASSERT(ownsObject(slab));
+    ALLOC_ASSERT(slab->magic == ALLOC_PATTERN_SLAB_MAGIC);
+    ALLOC_ASSERT(slab->classIndex == guard->classIndex);
+
+    const uint8_t cls = guard->classIndex;
+    const size_t rel = guard->slabOffset - kDescSize;
+    ALLOC_ASSERT(rel % slotSize(cls) == 0U);
+    const auto slot = static_cast<uint8_t>(rel / slotSize(cls));
+    ALLOC_ASSERT(slot < slab->capacity);
+    ALLOC_ASSERT((slab->freeMask[slot / 32U] & (1U << (slot % 32U))) == 0U);
+
+    /* Хвост класса — аналог паддинга страничной области */
+    const size_t tail = classSize(cls) - guard->requestedSize;
+    ALLOC_ASSERT(tail == 0U ||
+                 BlockGuard::validatePadding(payload + guard->requestedSize, tail));
+    (void)tail;
+
+    writeGuard(guard, guard->slabOffset, 0U, cls, ALLOC_SLAB_STATE_FREE);
+#if ALLOC_FILL_ON_FREE
+    if (zone->fillOnFree) {
+        BlockGuard::fillQuarantinePayload(payload, classSize(cls));
+    }
+#endif
+
+    SizeClass& c = classes[cls];
+    const bool wasFull = (slab->usedCount == slab->capacity);
+    slab->freeMask[slot / 32U] |= (1U << (slot % 32U));
+    --slab->usedCount;
+
+    if (wasFull) {
+        listRemove(&c.full, slab);
+        listPush(&c.partial, slab);
+        ++c.partialCount;
+    }
+
+    /* Пустой slab возвращаем в зону, если у класса есть другие */
+    if (slab->usedCount == 0U && c.partialCount > 1U) {
+        releaseSlab(slab);
+    }
+
+    ++successfulFrees;
+}
+
+/* ───────── Изменение размера ───────── */
+
+size_t SlabAllocator::objectSize(const void* userPtr) {
+    const auto* guard = reinterpret_cast<const AllocSlabGuard*>(
+        static_cast<const uint8_t*>(userPtr) - sizeof(AllocSlabGuard));
+    ALLOC_ASSERT(validateGuard(guard) && guard->state == ALLOC_SLAB_STATE_USED);
+    return guard->requestedSize;
+}
+
+bool SlabAllocator::resizeObject(void* userPtr, size_t newSize) {
+    auto* payload = static_cast<uint8_t*>(userPtr);
+    auto* guard = reinterpret_cast<AllocSlabGuard*>(payload - sizeof(AllocSlabGuard));
+
+    ALLOC_ASSERT(validateGuard(guard) && guard->state == ALLOC_SLAB_STATE_USED);
+    const uint8_t cls = guard->classIndex;
+    if (newSize == 0U || newSize > classSize(cls)) return false;
+
+    const size_t tail = classSize(cls) - guard->requestedSize;
+    ALLOC_ASSERT(tail == 0U ||
+                 BlockGuard::validatePadding(payload + guard->requestedSize, tail));
+    (void)tail;
+
+    writeGuard(guard, guard->slabOffset, static_cast<uint16_t>(newSize),
+               cls, ALLOC_SLAB_STATE_USED);
+    if (newSize < classSize(cls)) {
+        BlockGuard::fillPadding(payload + newSize, classSize(cls) - newSize);
+    }
+    return true;
+}
+
+/* ───────── Кэширование объектов ───────── */
+
+uint8_t SlabAllocator::recycleObject(void* userPtr, bool fillOnFree) {
+    auto* payload = static_cast<uint8_t*>(userPtr);
+    auto* guard = reinterpret_cast<AllocSlabGuard*>(payload - sizeof(AllocSlabGuard));
+
+    ALLOC_ASSERT(validateGuard(guard));
+    ALLOC_ASSERT(guard->state == ALLOC_SLAB_STATE_USED && "Двойное освобождение объекта slab");
+
+    const uint8_t cls = guard->classIndex;
+    const size_t tail = classSize(cls) - guard->requestedSize;
+    ALLOC_ASSERT(tail == 0U ||
+                 BlockGuard::validatePadding(payload + guard->requestedSize, tail));
+    (void)tail;
+
+    /* Для slab объект остаётся занятым — без хвоста, в состоянии CACHED */
+    writeGuard(guard, guard->slabOffset, static_cast<uint16_t>(classSize(cls)),
+               cls, ALLOC_SLAB_STATE_CACHED);
+#if ALLOC_FILL_ON_FREE
+    if (fillOnFree) {
+        BlockGuard::fillQuarantinePayload(payload, classSize(cls));
+    }
+#else
+    (void)fillOnFree;
+#endif
+    return cls;
+}
+
+void SlabAllocator::reuseObject(void* userPtr, size_t requestedSize, uint8_t checkLevel) {
+    auto* payload = static_cast<uint8_t*>(userPtr);
+    auto* guard = reinterpret_cast<AllocSlabGuard*>(payload - sizeof(AllocSlabGuard));
+
+    ALLOC_ASSERT(validateGuard(guard) && guard->state == ALLOC_SLAB_STATE_CACHED);
+    const uint8_t cls = guard->classIndex;
+    ALLOC_ASSERT(requestedSize > 0U && requestedSize <= classSize(cls));
+#if ALLOC_FILL_ON_FREE && ALLOC_QUARANTINE_CHECK_LEVEL >= 2
+    /* Запись в объект, лежавший в магазине */
+    ALLOC_ASSERT(checkLevel < 2U ||
+                 BlockGuard::validateQuarantinePayload(payload, classSize(cls)));
+#endif
+    (void)checkLevel;
+
+    writeGuard(guard, guard->slabOffset, static_cast<uint16_t>(requestedSize),
+               cls, ALLOC_SLAB_STATE_USED);
+    if (requestedSize < classSize(cls)) {
+        BlockGuard::fillPadding(payload + requestedSize, classSize(cls) - requestedSize);
+    }
+}
+
+/* ───────── Верификация ───────── */
+
+bool SlabAllocator::verifySlab(const SlabHeader* slab, uint8_t cls, uint8_t checkLevel,
+                               uint32_t pageSize) {
+    if (slab->magic != ALLOC_PATTERN_SLAB_MAGIC) return false;
+    if (slab->classIndex != cls || slab->capacity != slabCapacity(cls, pageSize)) return false;
+
+    uint8_t used = 0U;
+    for (uint8_t i = 0; i < slab->capacity; ++i) {
+        const uint8_t* slot = slotAddress(slab, i);
+        const auto* guard = reinterpret_cast<const AllocSlabGuard*>(slot);
+        const uint8_t* payload = slot + sizeof(AllocSlabGuard);
+
+        if (!validateGuard(guard) || guard->classIndex != cls) return false;
+        if (guard->slabOffset != static_cast<uint16_t>(slot - reinterpret_cast<const uint8_t*>(slab))) {
+            return false;
+        }
+
+        const bool maskFree = (slab->freeMask[i / 32U] & (1U << (i % 32U))) != 0U;
+        if (maskFree != (guard->state == ALLOC_SLAB_STATE_FREE)) return false;
+
+        if (!maskFree) {
+            ++used;
+#if ALLOC_QUARANTINE_CHECK_LEVEL >= 3
+            const size_t tail = classSize(cls) - guard->requestedSize;
+            if (checkLevel >= 3U && tail > 0U &&
+                !BlockGuard::validatePadding(payload + guard->requestedSize, tail)) {
+                return false;
+            }
+#endif
+            /* Объект в магазине — залит так же, как свободный слот */
+#if ALLOC_FILL_ON_FREE && ALLOC_QUARANTINE_CHECK_LEVEL >= 2
+            if (guard->state == ALLOC_SLAB_STATE_CACHED && checkLevel >= 2U &&
+                !BlockGuard::validateQuarantinePayload(payload, classSize(cls))) {
+                return false;
+            }
+#endif
+        } else {
+#if ALLOC_FILL_ON_FREE && ALLOC_QUARANTINE_CHECK_LEVEL >= 2
+            if (checkLevel >= 2U && !BlockGuard::validateQuarantinePayload(payload, classSize(cls))) {
+                return false;
+            }
+#endif
+        }
+        (void)payload;
+        (void)checkLevel;
+    }
+    return used == slab->usedCount;
+}
+
+bool SlabAllocator::verify() const {
+    if (zone == nullptr) return true;
+
+    for (uint8_t cls = 0; cls < kClassCount; ++cls) {
+        const SlabHeader* lists[2] = { classes[cls].partial, classes[cls].full };
+        for (const SlabHeader* slab : lists) {
+            for (; slab != nullptr; slab = slab->next) {
+                if (!ownsObject(slab)) return false;
+                if (!verifySlab(slab, cls, zone->checkLevel, zone->pageSize)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace AllocCustom
@@ -0,0 +1,188 @@
+/**
+ * @file SlabAllocator.hpp
+ * @brief Slab-слой мелких объектов поверх PageAllocator (POD, trivially constructible).
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "AllocConf.h"
+#include "AllocTypes.h"
+#include "PageBitmap.hpp"
+
+namespace AllocCustom {
+
+struct PageAllocator;
+
+/**
+ * @brief Дескриптор slab — лежит в начале payload страничной области.
+ *
+ * Сам slab — обычная область PageAllocator с хедером и футером,
+ * поэтому целиком попадает под verifyAllocated() и карантин.
+ */
+struct SlabHeader {
+    static constexpr uint16_t kMaxObjects = 64U;
+
+    uint32_t    magic;        /**< ALLOC_PATTERN_SLAB_MAGIC */
+    uint8_t     classIndex;   /**< Индекс класса размера */
+    uint8_t     capacity;     /**< Число объектов в slab */
+    uint8_t     usedCount;    /**< Число выданных объектов */
+    uint8_t     reserved;     /**< Выравнивание */
+    uint32_t    freeMask[2];  /**< 1 = слот свободен */
+    SlabHeader* next;         /**< Следующий slab класса */
+    SlabHeader* prev;         /**< Предыдущий slab класса */
+};
+
+/**
+ * @brief Аллокатор мелких объектов одной зоны.
+ *
+ * Классы размеров — степени двойки от ALLOC_SLAB_MIN_CLASS_SIZE.
+ * Slab — ALLOC_SLAB_PAGES страниц ALLOC_PAGE_SIZE, округлённые до страниц
+ * зоны (slabPayload), берутся из PageAllocator зоны.
+ * Каждый объект предваряется 8-байтовым AllocSlabGuard, хвост класса
+ * за пределами requestedSize заполняется паттерном паддинга.
+ *
+ * POD-тип: zero-init из BSS безопасен. Инициализация — через init().
+ * НЕ выполняет собственную синхронизацию.
+ */
+struct SlabAllocator {
+    static constexpr uint8_t kClassCount = ALLOC_SLAB_CLASS_COUNT;
+
+    struct SizeClass {
+        SlabHeader* partial;      /**< Slab-ы со свободными слотами */
+        SlabHeader* full;         /**< Полностью занятые slab-ы */
+        uint16_t    partialCount; /**< Длина списка partial */
+    };
+
+    PageAllocator* zone;
+    PageBitmap     slabPages;     /**< 1 = страница принадлежит slab */
+    SizeClass      classes[kClassCount];
+
+    /* ── Статистика ── */
+    size_t successfulAllocs;
+    size_t successfulFrees;
+    size_t slabsCreated;
+    size_t slabsReleased;
+    size_t cachedOut;      /**< Передано в магазины пачками */
+    size_t cachedBack;     /**< Возвращено из магазинов */
+
+    /* ── Основные операции ── */
+
+    void  init(PageAllocator* owner);
+    void* allocate(size_t requestedSize);
+    void  deallocate(void* userPtr);
+
+    /** Запрос обслуживается slab-слоем (по размеру). */
+    static bool servesSize(size_t requestedSize);
+
+    /** Указатель лежит в странице slab этой зоны. Можно без лока зоны. */
+    bool ownsObject(const void* userPtr) const;
+
+    /** Класс размера для запроса (servesSize(requestedSize) == true). */
+    static uint8_t classFor(size_t requestedSize);
+
+    /* ── Изменение размера ── */
+
+    /** Запрошенный размер выданного объекта. */
+    static size_t objectSize(const void* userPtr);
+
+    /**
+     * Изменить размер объекта на месте, если newSize помещается в его класс.
+     * Хвост класса перезаписывается паттерном паддинга.
+     * @return false — объект нужно перенести.
+     */
+    static bool resizeObject(void* userPtr, size_t newSize);
+
+    /* ── Кэширование объектов (магазины) ── */
+
+    /**
+     * Подготовить выданный объект к кэшированию без возврата в slab:
+     * проверить guard и хвост, пометить ALLOC_SLAB_STATE_CACHED с
+     * requestedSize во весь класс и заполнить payload карантинным
+     * паттерном (fillOnFree — политика зоны). Повторный free того же
+     * объекта ловится по состоянию.
+     * @return Индекс класса объекта.
+     */
+    static uint8_t recycleObject(void* userPtr, bool fillOnFree);
+
+    /**
+     * Повторно выдать кэшированный объект под новый размер; при
+     * checkLevel ≥ 2 (уровень зоны) — проверить карантинный паттерн.
+     */
+    static void reuseObject(void* userPtr, size_t requestedSize, uint8_t checkLevel);
+
+    /** Вернуть в slab объект из магазина (ALLOC_SLAB_STATE_CACHED). */
+    void returnCached(void* userPtr);
+
+    /* ── Диагностика ── */
+
+    /** Проверить дескрипторы и guard-ы всех slab-ов. */
+    bool verify() const;
+
+    /** Размер класса (байт). */
+    static constexpr size_t classSize(uint8_t cls) {
+        return static_cast<size_t>(ALLOC_SLAB_MIN_CLASS_SIZE) << cls;
+    }
+
+    /** Полный размер слота: guard + класс. */
+    static constexpr size_t slotSize(uint8_t cls) {
+        return sizeof(AllocSlabGuard) + classSize(cls);
+    }
+
+    /** Дескриптор занимает начало payload, слоты выровнены на 8 байт. */
+    static constexpr size_t kDescSize = (sizeof(SlabHeader) + 7U) & ~static_cast<size_t>(7U);
+
+    /**
+     * Payload страничной области slab в зоне со страницей pageSize:
+     * ALLOC_SLAB_PAGES страниц ALLOC_PAGE_SIZE, округлённые вверх до
+     * страниц зоны, — крупная страница используется целиком.
+     */
+    static constexpr size_t slabPayload(uint32_t pageSize) {
+        return (static_cast<size_t>(ALLOC_SLAB_PAGES) * ALLOC_PAGE_SIZE + pageSize - 1U) /
+                   pageSize * pageSize - ALLOC_HEADER_SIZE - ALLOC_FOOTER_SIZE;
+    }
+
+    /** Объектов класса cls в slab зоны со страницей pageSize. */
+    static constexpr uint8_t slabCapacity(uint8_t cls, uint32_t pageSize) {
+        return static_cast<uint8_t>(
+            ((slabPayload(pageSize) - kDescSize) / slotSize(cls)) < SlabHeader::kMaxObjects
+                ? (slabPayload(pageSize) - kDescSize) / slotSize(cls)
+                : SlabHeader::kMaxObjects);
+    }
+
+    /**
+     * Slab-ы помещаются в зону со страницей pageSize: старший класс
+     * вмещает хотя бы 2 объекта, смещения guard-ов — в uint16_t.
+     */
+    static constexpr bool validGeometry(uint32_t pageSize) {
+        return static_cast<size_t>(ALLOC_SLAB_PAGES) * ALLOC_PAGE_SIZE >
+                   ALLOC_HEADER_SIZE + ALLOC_FOOTER_SIZE + kDescSize &&
+               slabCapacity(kClassCount - 1U, pageSize) >= 2U &&
+               ((slabPayload(pageSize) < kDescSize + SlabHeader::kMaxObjects * slotSize(kClassCount - 1U))
+                    ? slabPayload(pageSize)
+                    : kDescSize + SlabHeader::kMaxObjects * slotSize(kClassCount - 1U)) <= 0xFFFFU;
+    }
+
+private:
+    /** Вернуть объект в slab; guard должен быть в состоянии state. */
+    void        release(void* userPtr, uint8_t state);
+
+    SlabHeader* createSlab(uint8_t cls);
+    void        releaseSlab(SlabHeader* slab);
+
+    static void listRemove(SlabHeader** head, SlabHeader* slab);
+    static void listPush(SlabHeader** head, SlabHeader* slab);
+
+    static uint8_t*       slotAddress(SlabHeader* slab, uint8_t slot);
+    static const uint8_t* slotAddress(const SlabHeader* slab, uint8_t slot);
+
+    static void     writeGuard(AllocSlabGuard* g, uint16_t slabOffset,
+                               uint16_t requestedSize, uint8_t cls, uint8_t state);
+    static uint16_t guardCheck(const AllocSlabGuard* g);
+    static bool     validateGuard(const AllocSlabGuard* g);
+
+    static bool verifySlab(const SlabHeader* slab, uint8_t cls, uint8_t checkLevel,
+                           uint32_t pageSize);
+};
+
+} // namespace AllocCustom
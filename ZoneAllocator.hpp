@@ -0,0 +1,137 @@
+/**
+ * @file ZoneAllocator.hpp
+ * @brief Аллокаторы C++ с фиксированной зоной: std::pmr::memory_resource
+ *        и ZoneAllocator<T, Zone> для контейнеров STL.
+ *
+ * Мелкие запросы идут в slab, крупные — страницами; освобождение —
+ * vPortFreeSized (зона и путь известны без поиска по хедеру).
+ *
+ *   std::vector<Sample, RegionAlloc::ZoneAllocator<Sample, RegionAlloc::Zone::Fast>> samples;
+ *   std::pmr::string log(&RegionAlloc::zoneResource<RegionAlloc::Zone::Slow>());
+ *
+ * При нехватке памяти — std::bad_alloc, без исключений — ALLOC_ASSERT.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define ALLOC_HAVE_PMR 1
+#else
+#define ALLOC_HAVE_PMR 0
+#endif
+
+#include "AllocConf.h"
+#include "AllocatorExt.h"
+
+namespace RegionAlloc {
+
+namespace detail {
+
+inline void* zoneAllocate(size_t bytes, size_t alignment, Zone zone) {
+    const HeapZone_t z = static_cast<HeapZone_t>(zone);
+    if (bytes == 0U) bytes = 1U;
+    void* p = (alignment <= ALLOC_MALLOC_ALIGNMENT)
+                  ? pvPortMallocZone(bytes, z)
+                  : pvPortMallocZoneAligned(bytes, alignment, z);
+    if (p == nullptr) {
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        ALLOC_ASSERT(false && "Нет памяти в зоне");
+#endif
+    }
+    return p;
+}
+
+inline void zoneDeallocate(void* p, size_t bytes, size_t alignment, Zone zone) {
+    if (bytes == 0U) bytes = 1U;
+    vPortFreeSized(p, bytes, alignment, static_cast<HeapZone_t>(zone));
+}
+
+} // namespace detail
+
+/**
+ * @brief Аллокатор STL с зоной Z. Без состояния: все экземпляры одной
+ * зоны взаимозаменяемы.
+ */
+template <typename T, Zone Z>
+struct ZoneAllocator {
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = ZoneAllocator<U, Z>;
+    };
+
+    static constexpr Zone zone = Z;
+
+    ZoneAllocator() noexcept = default;
+    template <typename U>
+    ZoneAllocator(const ZoneAllocator<U, Z>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n > SIZE_MAX / sizeof(T)) {
+#if defined(__cpp_exceptions)
+            throw std::bad_alloc();
+#else
+            ALLOC_ASSERT(false && "Переполнение размера");
+#endif
+        }
+        return static_cast<T*>(detail::zoneAllocate(n * sizeof(T), alignof(T), Z));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        detail::zoneDeallocate(p, n * sizeof(T), alignof(T), Z);
+    }
+};
+
+template <typename T, typename U, Zone Z>
+bool operator==(const ZoneAllocator<T, Z>&, const ZoneAllocator<U, Z>&) noexcept { return true; }
+
+template <typename T, typename U, Zone Z>
+bool operator!=(const ZoneAllocator<T, Z>&, const ZoneAllocator<U, Z>&) noexcept { return false; }
+
+#if ALLOC_HAVE_PMR
+
+/**
+ * @brief memory_resource зоны: обычно — синглтон zoneResource<Z>().
+ */
+class ZoneMemoryResource : public std::pmr::memory_resource {
+public:
+    explicit ZoneMemoryResource(Zone zone) noexcept : zone_(zone) {}
+
+    Zone zone() const noexcept { return zone_; }
+
+private:
+    Zone zone_;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return detail::zoneAllocate(bytes, alignment, zone_);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        detail::zoneDeallocate(p, bytes, alignment, zone_);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        /* Без RTTI (-fno-rtti) — по адресу: ресурсы одной зоны — через zoneResource<Z>() */
+        return this == &other;
+    }
+};
+
+/** Общий ресурс зоны Z. */
+template <Zone Z>
+ZoneMemoryResource& zoneResource() noexcept {
+    static ZoneMemoryResource resource(Z);
+    return resource;
+}
+
+#endif // ALLOC_HAVE_PMR
+
+} // namespace RegionAlloc
@@ -0,0 +1,200 @@
+/**
+ * @file BitmapBench.cpp
+ * @brief Микро-бенчмарк PageBitmap: текущая реализация против исходной
+ *        побитовой (per-page set/clear, линейный findFreeRun).
+ *
+ * Обе карты прогоняются по одной и той же трассе аллокаций/освобождений
+ * на фрагментированной зоне; результаты findFreeRun сверяются.
+ */
+#include "PageBitmap.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/** Страниц в зоне бенчмарка (10 МиБ по 1 КиБ). */
+constexpr uint16_t kBenchPages = 10240U;
+
+/* ───────── Исходная реализация (эталон) ───────── */
+
+struct LegacyBitmap {
+    static constexpr uint16_t kMaxWords = (kBenchPages + 31U) / 32U;
+
+    uint32_t words[kMaxWords];
+    uint16_t pageCount;
+
+    void init(uint16_t count) {
+        std::memset(words, 0, sizeof(words));
+        pageCount = count;
+    }
+    void set(uint16_t page) {
+        ALLOC_ASSERT(page < pageCount);
+        words[page / 32U] |= (1U << (page % 32U));
+    }
+    void clear(uint16_t page) {
+        ALLOC_ASSERT(page < pageCount);
+        words[page / 32U] &= ~(1U << (page % 32U));
+    }
+    bool test(uint16_t page) const {
+        ALLOC_ASSERT(page < pageCount);
+        return (words[page / 32U] & (1U << (page % 32U))) != 0U;
+    }
+    void setRange(uint16_t start, uint16_t count) {
+        for (uint16_t i = 0; i < count; ++i) set(static_cast<uint16_t>(start + i));
+    }
+    void clearRange(uint16_t start, uint16_t count) {
+        for (uint16_t i = 0; i < count; ++i) clear(static_cast<uint16_t>(start + i));
+    }
+    int32_t findFreeRun(uint16_t count) const {
+        if (count == 0 || count > pageCount) return -1;
+        uint16_t runStart = 0;
+        uint16_t runLen   = 0;
+        for (uint16_t i = 0; i < pageCount; ++i) {
+            const uint16_t wordIdx = i / 32U;
+            if (runLen == 0 && words[wordIdx] == 0xFFFFFFFFU) {
+                i = static_cast<uint16_t>((wordIdx + 1U) * 32U - 1U);
+                continue;
+            }
+            if (!test(i)) {
+                if (runLen == 0) runStart = i;
+                ++runLen;
+                if (runLen >= count) return static_cast<int32_t>(runStart);
+            } else {
+                runLen = 0;
+            }
+        }
+        return -1;
+    }
+};
+
+/* ───────── Трасса ───────── */
+
+struct Op {
+    bool     isAlloc;
+    uint16_t pages;   /**< alloc: размер; free: индекс живой области */
+};
+
+uint32_t g_rng = 0x12345678U;
+
+uint32_t nextRand() {
+    g_rng ^= g_rng << 13U;
+    g_rng ^= g_rng >> 17U;
+    g_rng ^= g_rng << 5U;
+    return g_rng;
+}
+
+struct Timing {
+    double findNs  = 0.0;
+    double setNs   = 0.0;
+    double clearNs = 0.0;
+    size_t finds   = 0U;
+    size_t sets    = 0U;
+    size_t clears  = 0U;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedNs(Clock::time_point t0) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+std::vector<uint32_t> g_currentStorage;
+
+void initBitmap(LegacyBitmap& bm, uint16_t pageCount) {
+    bm.init(pageCount);
+}
+
+void initBitmap(AllocCustom::PageBitmap& bm, uint16_t pageCount) {
+    g_currentStorage.assign(AllocCustom::PageBitmap::storageBytes(pageCount) / sizeof(uint32_t), 0U);
+    bm.init(pageCount, g_currentStorage.data());
+}
+
+template <typename Bitmap>
+Timing runTrace(Bitmap& bm, uint16_t pageCount, const std::vector<Op>& ops,
+                std::vector<int32_t>& results) {
+    struct Live { uint16_t start; uint16_t count; };
+    std::vector<Live> live;
+    Timing t;
+
+    initBitmap(bm, pageCount);
+    results.clear();
+
+    for (const Op& op : ops) {
+        if (op.isAlloc) {
+            auto t0 = Clock::now();
+            const int32_t sp = bm.findFreeRun(op.pages);
+            t.findNs += elapsedNs(t0);
+            ++t.finds;
+            results.push_back(sp);
+            if (sp < 0) continue;
+
+            t0 = Clock::now();
+            bm.setRange(static_cast<uint16_t>(sp), op.pages);
+            t.setNs += elapsedNs(t0);
+            ++t.sets;
+            live.push_back({static_cast<uint16_t>(sp), op.pages});
+        } else if (!live.empty()) {
+            const size_t idx = op.pages % live.size();
+            const auto t0 = Clock::now();
+            bm.clearRange(live[idx].start, live[idx].count);
+            t.clearNs += elapsedNs(t0);
+            ++t.clears;
+            live[idx] = live.back();
+            live.pop_back();
+        }
+    }
+    return t;
+}
+
+void report(const char* name, const Timing& t) {
+    std::printf("%-10s findFreeRun %9.1f ns/op   setRange %7.1f ns/op   clearRange %7.1f ns/op\n",
+                name,
+                t.finds  ? t.findNs  / static_cast<double>(t.finds)  : 0.0,
+                t.sets   ? t.setNs   / static_cast<double>(t.sets)   : 0.0,
+                t.clears ? t.clearNs / static_cast<double>(t.clears) : 0.0);
+}
+
+AllocCustom::PageBitmap g_current;
+LegacyBitmap            g_legacy;
+
+} // namespace
+
+int main() {
+    const uint16_t pageCount = kBenchPages;
+    const size_t   opCount   = 200000U;
+
+    /* Смесь мелких и крупных областей с перекосом в сторону alloc —
+     * зона быстро заполняется и фрагментируется. */
+    std::vector<Op> ops;
+    ops.reserve(opCount);
+    for (size_t i = 0; i < opCount; ++i) {
+        const uint32_t r = nextRand();
+        if (r % 100U < 52U) {
+            const uint16_t pages = (r % 16U == 0U)
+                ? static_cast<uint16_t>(32U + (nextRand() % 96U))
+                : static_cast<uint16_t>(1U + (nextRand() % 8U));
+            ops.push_back({true, pages});
+        } else {
+            ops.push_back({false, static_cast<uint16_t>(nextRand() & 0xFFFFU)});
+        }
+    }
+
+    std::vector<int32_t> legacyResults;
+    std::vector<int32_t> currentResults;
+
+    const Timing legacy  = runTrace(g_legacy,  pageCount, ops, legacyResults);
+    const Timing current = runTrace(g_current, pageCount, ops, currentResults);
+
+    if (legacyResults != currentResults) {
+        std::printf("MISMATCH: findFreeRun results differ\n");
+        return 1;
+    }
+
+    std::printf("PageBitmap: %u pages, %zu ops\n", static_cast<unsigned>(pageCount), ops.size());
+    report("legacy", legacy);
+    report("current", current);
+    return 0;
+}
@@ -0,0 +1,293 @@
+/**
+ * @file HeapBench.cpp
+ * @brief Хостовые нагрузки на мультизонный аллокатор (HOST_BUILD).
+ *
+ * Каждая нагрузка стартует на чистой куче (FAST 256 КиБ + SLOW 4 МиБ)
+ * и печатает одну строку: ops/s, задержки p50/p99/max, неудачные
+ * выделения и фрагментацию. Настройки AllocConf.h задаются при сборке —
+ * CMake собирает по исполняемому файлу на комбинацию (bench/CMakeLists.txt).
+ *
+ *   AllocatorCustomCpp_bench [ops]
+ */
+#include "AllocatorCustomCpp.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifndef ALLOC_BENCH_CONFIG_NAME
+#define ALLOC_BENCH_CONFIG_NAME "custom"
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kFastZoneBytes = 256U * 1024U;
+constexpr size_t kSlowZoneBytes = 4U * 1024U * 1024U;
+constexpr size_t kThreads       = 4U;
+constexpr size_t kSeriesPoints  = 8U;   /**< Точек фрагментации на нагрузку */
+
+alignas(64) uint8_t g_fastZone[kFastZoneBytes];
+alignas(64) uint8_t g_slowZone[kSlowZoneBytes];
+
+AllocCustom::AllocatorCustomCpp g_heap;
+
+/* ───────── ГПСЧ (xorshift32, своё состояние у каждого потока) ───────── */
+
+struct Rng {
+    uint32_t state;
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t range(uint32_t lo, uint32_t hi) { return lo + next() % (hi - lo + 1U); }
+};
+
+/* ───────── Замеры ───────── */
+
+struct Result {
+    std::vector<uint32_t> latencyNs;
+    size_t                fails;
+    double                seconds;
+    double                worstFragmentation;
+    std::vector<double>   series;   /**< Фрагментация SLOW-зоны по ходу нагрузки */
+};
+
+uint32_t elapsedNs(Clock::time_point t0) {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count());
+}
+
+/** Доля свободной памяти, не входящей в наибольший свободный участок. */
+double fragmentation(uint8_t zone) {
+    return static_cast<double>(g_heap.getZoneFragmentation(zone)) / 1000.0;
+}
+
+void resetHeap() {
+    g_heap.resetState();
+    HeapRegion_t regions[] = {
+        {g_fastZone, sizeof(g_fastZone)},
+        {g_slowZone, sizeof(g_slowZone)},
+        {nullptr, 0U},
+    };
+    g_heap.defineHeapRegions(regions);
+}
+
+/** Живая область нагрузки. */
+struct Block {
+    void*  ptr;
+    size_t size;
+};
+
+/**
+ * Нагрузка «держать до maxLive областей»: при заполнении или с
+ * вероятностью freePercent освобождается случайная область, иначе
+ * выделяется новая размером sizeFn(rng). Каждые ops/kSeriesPoints
+ * операций снимается фрагментация.
+ */
+template <typename SizeFn, typename ZoneFn>
+void churn(Result& res, Rng& rng, size_t ops, size_t maxLive, uint32_t freePercent,
+           SizeFn sizeFn, ZoneFn zoneFn, bool sample) {
+    std::vector<Block> live;
+    live.reserve(maxLive);
+    const size_t step = std::max<size_t>(ops / kSeriesPoints, 1U);
+
+    for (size_t i = 0; i < ops; ++i) {
+        const bool doFree = !live.empty() &&
+                            (live.size() >= maxLive || rng.next() % 100U < freePercent);
+        if (doFree) {
+            const size_t idx = rng.next() % live.size();
+            const auto t0 = Clock::now();
+            g_heap.deallocate(live[idx].ptr);
+            res.latencyNs.push_back(elapsedNs(t0));
+            live[idx] = live.back();
+            live.pop_back();
+        } else {
+            const size_t size = sizeFn(rng);
+            const HeapZone_t zone = zoneFn(rng);
+            const auto t0 = Clock::now();
+            void* p = g_heap.allocate(size, zone);
+            res.latencyNs.push_back(elapsedNs(t0));
+            if (p == nullptr) {
+                ++res.fails;
+            } else {
+                std::memset(p, 0xA5, std::min<size_t>(size, 64U));
+                live.push_back({p, size});
+            }
+        }
+        if (sample && (i + 1U) % step == 0U) {
+            const double f = fragmentation(1U);
+            res.series.push_back(f);
+            res.worstFragmentation = std::max(res.worstFragmentation, f);
+        }
+    }
+    for (const Block& b : live) {
+        g_heap.deallocate(b.ptr);
+    }
+}
+
+HeapZone_t anyZone(Rng&) { return HEAP_ZONE_ANY; }
+
+/* ───────── Нагрузки ───────── */
+
+/** Мелкие объекты (slab): 8..256 байт, до 2048 живых. */
+void smallChurn(Result& res, size_t ops) {
+    Rng rng{0x12345678U};
+    churn(res, rng, ops, 2048U, 45U,
+          [](Rng& r) { return static_cast<size_t>(r.range(8U, 256U)); }, anyZone, true);
+}
+
+/** Крупные буферы: 2..64 КиБ, до 48 живых. */
+void largeChurn(Result& res, size_t ops) {
+    Rng rng{0x9E3779B9U};
+    churn(res, rng, ops, 48U, 45U,
+          [](Rng& r) { return static_cast<size_t>(r.range(2048U, 65536U)); }, anyZone, true);
+}
+
+/** Смешанные размеры с явной зоной на каждый вызов (FAST/SLOW/PREFER/ANY). */
+void zoneRouting(Result& res, size_t ops) {
+    Rng rng{0x2545F491U};
+    churn(res, rng, ops, 512U, 48U,
+          [](Rng& r) {
+              return (r.next() % 4U == 0U) ? static_cast<size_t>(r.range(1024U, 16384U))
+                                           : static_cast<size_t>(r.range(16U, 512U));
+          },
+          [](Rng& r) { return static_cast<HeapZone_t>(r.next() % 5U); }, true);
+}
+
+/** kThreads потоков со смешанной нагрузкой на общую кучу. */
+void contention(Result& res, size_t ops) {
+    std::vector<Result> parts(kThreads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&parts, t, ops] {
+            Rng rng{static_cast<uint32_t>(0xC0FFEE11U * (t + 1U))};
+            churn(parts[t], rng, ops / kThreads, 256U, 48U,
+                  [](Rng& r) {
+                      return (r.next() % 8U == 0U) ? static_cast<size_t>(r.range(1024U, 8192U))
+                                                   : static_cast<size_t>(r.range(16U, 256U));
+                  },
+                  anyZone, false);
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    for (const Result& p : parts) {
+        res.latencyNs.insert(res.latencyNs.end(), p.latencyNs.begin(), p.latencyNs.end());
+        res.fails += p.fails;
+    }
+    res.worstFragmentation = fragmentation(1U);
+}
+
+/**
+ * Старение: долгоживущие области (каждая 8-я живёт «вечно») вперемешку
+ * с короткими — свободная память дробится между ними.
+ */
+void fragmentationAging(Result& res, size_t ops) {
+    Rng rng{0xDEADBEEFU};
+    std::vector<Block> pinned;
+    std::vector<Block> live;
+    const size_t step = std::max<size_t>(ops / kSeriesPoints, 1U);
+
+    for (size_t i = 0; i < ops; ++i) {
+        if (!live.empty() && (live.size() >= 256U || rng.next() % 100U < 47U)) {
+            const size_t idx = rng.next() % live.size();
+            const auto t0 = Clock::now();
+            g_heap.deallocate(live[idx].ptr);
+            res.latencyNs.push_back(elapsedNs(t0));
+            live[idx] = live.back();
+            live.pop_back();
+        } else {
+            const size_t size = rng.range(512U, 12288U);
+            const auto t0 = Clock::now();
+            void* p = g_heap.allocate(size, HEAP_ZONE_SLOW);
+            res.latencyNs.push_back(elapsedNs(t0));
+            if (p == nullptr) {
+                ++res.fails;
+            } else if (rng.next() % 8U == 0U && pinned.size() < 192U) {
+                pinned.push_back({p, size});
+            } else {
+                live.push_back({p, size});
+            }
+        }
+        if ((i + 1U) % step == 0U) {
+            const double f = fragmentation(1U);
+            res.series.push_back(f);
+            res.worstFragmentation = std::max(res.worstFragmentation, f);
+        }
+    }
+    for (const Block& b : live) {
+        g_heap.deallocate(b.ptr);
+    }
+    for (const Block& b : pinned) {
+        g_heap.deallocate(b.ptr);
+    }
+}
+
+/* ───────── Отчёт ───────── */
+
+void report(const char* name, Result& res) {
+    auto& lat = res.latencyNs;
+    std::sort(lat.begin(), lat.end());
+    const size_t n = lat.size();
+    std::printf("%-10s %-14s %9zu ops %11.0f ops/s   p50 %6u ns   p99 %7u ns   max %8u ns"
+                "   fails %6zu   frag %.3f\n",
+                ALLOC_BENCH_CONFIG_NAME, name, n,
+                (res.seconds > 0.0) ? static_cast<double>(n) / res.seconds : 0.0,
+                n ? lat[n / 2U] : 0U, n ? lat[(n * 99U) / 100U] : 0U, n ? lat[n - 1U] : 0U,
+                res.fails, res.worstFragmentation);
+    if (!res.series.empty()) {
+        std::printf("%-10s %-14s fragmentation:", ALLOC_BENCH_CONFIG_NAME, name);
+        for (double f : res.series) {
+            std::printf(" %.3f", f);
+        }
+        std::printf("\n");
+    }
+}
+
+template <typename Workload>
+bool run(const char* name, Workload workload, size_t ops) {
+    resetHeap();
+    Result res = {};
+    const auto t0 = Clock::now();
+    workload(res, ops);
+    res.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    report(name, res);
+
+    const bool valid = g_heap.validateHeap();
+    if (!valid) {
+        std::printf("%-10s %-14s HEAP CORRUPTED\n", ALLOC_BENCH_CONFIG_NAME, name);
+    }
+    return valid;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t ops = (argc > 1) ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10))
+                                  : 200000U;
+
+    std::printf("config %s: check level %d, check all %d, incremental %d, fill on free %d, "
+                "clear on evict %d, quarantine %u, fit %d, slab %d\n",
+                ALLOC_BENCH_CONFIG_NAME, ALLOC_QUARANTINE_CHECK_LEVEL, ALLOC_CHECK_ALL_ALLOCATED,
+                ALLOC_CHECK_INCREMENTAL, ALLOC_FILL_ON_FREE, ALLOC_ENABLE_CLEAR_ON_EVICT,
+                static_cast<unsigned>(ALLOC_QUARANTINE_CAPACITY), ALLOC_FIT_POLICY,
+                ALLOC_ENABLE_SLAB);
+
+    bool ok = true;
+    ok = run("small_churn",   smallChurn,         ops) && ok;
+    ok = run("large_churn",   largeChurn,         ops / 4U) && ok;
+    ok = run("zone_routing",  zoneRouting,        ops) && ok;
+    ok = run("contention",    contention,         ops) && ok;
+    ok = run("frag_aging",    fragmentationAging, ops / 2U) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file SizedFreeTest.cpp
+ * @brief Пары allocate/allocateAligned → deallocateSized (HOST_BUILD).
+ *
+ * Как pvPortMallocZone/pvPortMallocZoneAligned → vPortFreeSized из
+ * AllocatorExt.h: освобождение по размеру и выравниванию должно выбрать
+ * тот же путь (slab или страницы), что и выделение. Собирается без
+ * NDEBUG — ALLOC_ASSERT срабатывает и в Release.
+ *
+ *   AllocatorCustomCpp_sized_free_test
+ */
+#include "AllocatorCustomCpp.hpp"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+constexpr size_t kFastZoneBytes = 64U * 1024U;
+constexpr size_t kSlowZoneBytes = 256U * 1024U;
+
+alignas(64) uint8_t g_fastZone[kFastZoneBytes];
+alignas(64) uint8_t g_slowZone[kSlowZoneBytes];
+
+AllocCustom::AllocatorCustomCpp g_heap;
+
+struct Case {
+    size_t     size;
+    size_t     alignment;   /**< 0 — allocate(size, zone) */
+    HeapZone_t zone;
+};
+
+const Case kCases[] = {
+    {16U,   0U,    HEAP_ZONE_FAST},
+    {16U,   4U,    HEAP_ZONE_FAST},
+    {16U,   8U,    HEAP_ZONE_FAST},
+    {16U,   16U,   HEAP_ZONE_FAST},
+    {200U,  8U,    HEAP_ZONE_SLOW},
+    {200U,  64U,   HEAP_ZONE_SLOW},
+    {3000U, 8U,    HEAP_ZONE_SLOW},
+    {3000U, 4096U, HEAP_ZONE_SLOW},
+    {40U,   8U,    HEAP_ZONE_FAST_PREFER},
+    {40U,   32U,   HEAP_ZONE_ANY},
+};
+
+} // namespace
+
+int main() {
+    g_heap.resetState();
+    HeapRegion_t regions[] = {
+        {g_fastZone, sizeof(g_fastZone)},
+        {g_slowZone, sizeof(g_slowZone)},
+        {nullptr, 0U},
+    };
+    g_heap.defineHeapRegions(regions);
+
+    bool ok = true;
+    for (const Case& c : kCases) {
+        void* p = (c.alignment == 0U) ? g_heap.allocate(c.size, c.zone)
+                                      : g_heap.allocateAligned(c.size, c.alignment, c.zone);
+        const size_t align = (c.alignment != 0U) ? c.alignment : ALLOC_MALLOC_ALIGNMENT;
+        const bool placed = p != nullptr && (reinterpret_cast<uintptr_t>(p) & (align - 1U)) == 0U;
+        if (p != nullptr) {
+            g_heap.deallocateSized(p, c.size, c.alignment, c.zone);
+        }
+        const bool valid = g_heap.validateHeap();
+        std::printf("size %5zu align %5zu zone %u: %s\n", c.size, c.alignment,
+                    static_cast<unsigned>(c.zone), (placed && valid) ? "ok" : "FAILED");
+        ok = placed && valid && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file SlabGuardTest.cpp
+ * @brief Проверки guard-ов объектов slab на пути магазинов (HOST_BUILD).
+ *
+ * Собирается с ALLOC_ENABLE_MAGAZINES=1, ALLOC_QUARANTINE_CHECK_LEVEL=2
+ * и без NDEBUG: ALLOC_ASSERT
+ * (assert) срабатывает и в Release. Сценарий, который должен упасть на
+ * ALLOC_ASSERT, выполняется в дочернем процессе.
+ *
+ *   AllocatorCustomCpp_slab_guard_test
+ */
+#include "AllocatorCustomCpp.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if !ALLOC_ENABLE_MAGAZINES
+#error "SlabGuardTest собирается с ALLOC_ENABLE_MAGAZINES=1"
+#endif
+
+namespace {
+
+constexpr size_t kFastZoneBytes = 64U * 1024U;
+constexpr size_t kSlowZoneBytes = 256U * 1024U;
+
+alignas(64) uint8_t g_fastZone[kFastZoneBytes];
+alignas(64) uint8_t g_slowZone[kSlowZoneBytes];
+
+AllocCustom::AllocatorCustomCpp g_heap;
+
+void resetHeap() {
+    g_heap.resetState();
+    HeapRegion_t regions[] = {
+        {g_fastZone, sizeof(g_fastZone)},
+        {g_slowZone, sizeof(g_slowZone)},
+        {nullptr, 0U},
+    };
+    g_heap.defineHeapRegions(regions);
+}
+
+/** Сценарий scenario в дочернем процессе должен завершиться abort-ом. */
+template <typename Fn>
+bool expectAbort(const char* name, Fn scenario) {
+    std::fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        scenario();
+        _exit(0);
+    }
+    int status = 0;
+    (void)waitpid(pid, &status, 0);
+    const bool aborted = WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+    std::printf("%-28s %s\n", name, aborted ? "caught" : "NOT CAUGHT");
+    return aborted;
+}
+
+/** Объект, освобождённый в магазин, выдаётся повторно и освобождается штатно. */
+bool cachedReuse() {
+    resetHeap();
+    void* a = g_heap.allocate(40U);
+    g_heap.deallocate(a);
+    void* b = g_heap.allocate(48U);   /* тот же класс */
+    g_heap.deallocate(b);
+    const bool ok = (a == b) && g_heap.validateHeap();
+    std::printf("%-28s %s\n", "cached reuse", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = cachedReuse();
+
+    ok = expectAbort("double free via magazine", [] {
+        resetHeap();
+        void* p = g_heap.allocate(40U);
+        g_heap.deallocate(p);
+        g_heap.deallocate(p);
+    }) && ok;
+
+    ok = expectAbort("double free after overflow", [] {
+        /* Переполнение магазина возвращает часть объектов в slab */
+        resetHeap();
+        void* objs[ALLOC_MAGAZINE_SIZE * 2U];
+        for (void*& p : objs) {
+            p = g_heap.allocate(40U);
+        }
+        for (void* p : objs) {
+            g_heap.deallocate(p);
+        }
+        for (void* p : objs) {
+            g_heap.deallocate(p);
+        }
+    }) && ok;
+
+#if ALLOC_FILL_ON_FREE && ALLOC_QUARANTINE_CHECK_LEVEL >= 2
+    ok = expectAbort("write after free in magazine", [] {
+        resetHeap();
+        auto* p = static_cast<uint8_t*>(g_heap.allocate(40U));
+        g_heap.deallocate(p);
+        p[0] = 0U;
+        (void)g_heap.allocate(40U);
+    }) && ok;
+#endif
+
+    return ok ? 0 : 1;
+}
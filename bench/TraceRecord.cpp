@@ -0,0 +1,142 @@
+/**
+ * @file TraceRecord.cpp
+ * @brief Запись трассы (ALLOC_ENABLE_TRACE) на хосте — вход для проверок
+ *        воспроизведения.
+ *
+ * Случайная нагрузка (alloc/free/realloc/пакеты) на HOST_BUILD-куче с
+ * текущими настройками AllocConf.h; кольцо трассы вычитывается после
+ * каждой операции и пишется в файл в формате heapTraceRead. При
+ * ALLOC_ENABLE_DEFERRED_FREE очередь разбирается по ходу нагрузки —
+ * каждое освобождение должно попасть в трассу ровно один раз.
+ *
+ *   AllocatorCustomCpp_trace_record trace.bin [ops]
+ */
+#include "AllocatorCustomCpp.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if !ALLOC_ENABLE_TRACE
+#error "TraceRecord собирается с ALLOC_ENABLE_TRACE=1"
+#endif
+
+namespace {
+
+constexpr size_t kFastZoneBytes = 128U * 1024U;
+constexpr size_t kSlowZoneBytes = 1024U * 1024U;
+constexpr size_t kMaxLive       = 256U;
+constexpr size_t kBatch         = 8U;
+constexpr size_t kDrainPeriod   = 64U;   /**< Операций между разборами отложенных free */
+
+alignas(64) uint8_t g_fastZone[kFastZoneBytes];
+alignas(64) uint8_t g_slowZone[kSlowZoneBytes];
+
+AllocCustom::AllocatorCustomCpp g_heap;
+
+struct Rng {
+    uint32_t state;
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t range(uint32_t lo, uint32_t hi) { return lo + next() % (hi - lo + 1U); }
+};
+
+/** Переложить записи кольца в out (кольцо не должно переполниться). */
+void collect(std::vector<HeapTraceRecord_t>& out) {
+    HeapTraceRecord_t buf[64];
+    size_t n;
+    while ((n = g_heap.readTrace(buf, 64U)) > 0U) {
+        out.insert(out.end(), buf, buf + n);
+    }
+}
+
+/** Разобрать отложенные free пачками, вычитывая трассу после каждой. */
+void drain(std::vector<HeapTraceRecord_t>& out) {
+    while (g_heap.drainDeferredFrees(ALLOC_DEFERRED_FREE_BATCH) > 0U) {
+        collect(out);
+    }
+}
+
+size_t randomSize(Rng& rng) {
+    /* Преимущественно мелкие (slab), иногда страничные */
+    return (rng.next() % 4U != 0U) ? rng.range(8U, 256U) : rng.range(512U, 6000U);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::printf("usage: %s trace.bin [ops]\n", argv[0]);
+        return 2;
+    }
+    const size_t ops = (argc > 2) ? static_cast<size_t>(std::strtoul(argv[2], nullptr, 10))
+                                  : 20000U;
+
+    HeapRegion_t regions[] = {
+        {g_fastZone, sizeof(g_fastZone)},
+        {g_slowZone, sizeof(g_slowZone)},
+        {nullptr, 0U},
+    };
+    g_heap.defineHeapRegions(regions);
+
+    std::vector<HeapTraceRecord_t> trace;
+    collect(trace);
+
+    std::vector<void*> live;
+    live.reserve(kMaxLive + kBatch);
+    Rng rng{0x9E3779B9U};
+
+    for (size_t i = 0; i < ops; ++i) {
+        const uint32_t dice = rng.next() % 100U;
+        if (!live.empty() && (live.size() >= kMaxLive || dice < 40U)) {
+            const size_t idx = rng.next() % live.size();
+            g_heap.deallocate(live[idx]);
+            live[idx] = live.back();
+            live.pop_back();
+        } else if (dice < 50U && !live.empty()) {
+            const size_t idx = rng.next() % live.size();
+            void* p = g_heap.reallocate(live[idx], randomSize(rng));
+            if (p != nullptr) live[idx] = p;
+        } else if (dice < 55U) {
+            void* batch[kBatch];
+            const size_t n = g_heap.allocateBatch(rng.range(16U, 128U), kBatch, batch);
+            g_heap.deallocateBatch(batch, n);
+        } else {
+            void* p = g_heap.allocate(randomSize(rng),
+                                      (dice & 1U) != 0U ? HEAP_ZONE_FAST_PREFER : HEAP_ZONE_ANY);
+            if (p != nullptr) live.push_back(p);
+        }
+
+        collect(trace);
+        if (i % kDrainPeriod == 0U) {
+            drain(trace);
+        }
+    }
+
+    for (void* p : live) {
+        g_heap.deallocate(p);
+        collect(trace);
+    }
+    drain(trace);
+
+    if (g_heap.traceDropped() != 0U) {
+        std::printf("trace ring overflow: %u records dropped\n",
+                    static_cast<unsigned>(g_heap.traceDropped()));
+        return 1;
+    }
+
+    std::FILE* f = std::fopen(argv[1], "wb");
+    if (f == nullptr) {
+        std::printf("cannot write %s\n", argv[1]);
+        return 2;
+    }
+    const size_t written = std::fwrite(trace.data(), sizeof(HeapTraceRecord_t), trace.size(), f);
+    std::fclose(f);
+    std::printf("%zu records, %zu ops\n", trace.size(), ops);
+    return (written == trace.size()) ? 0 : 1;
+}
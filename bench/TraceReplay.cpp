@@ -0,0 +1,382 @@
+/**
+ * @file TraceReplay.cpp
+ * @brief Воспроизведение двоичной трассы (ALLOC_ENABLE_TRACE) на хосте.
+ *
+ * Трасса — записи HeapTraceRecord_t подряд, как их выдаёт heapTraceRead.
+ * Кучи воссоздаются по записям HEAP_TRACE_ZONE, затем каждое событие
+ * повторяется на HOST_BUILD-экземпляре аллокатора, собранном с текущими
+ * настройками AllocConf.h (ALLOC_BENCH_DEFINES в CMake). Выводятся
+ * задержки операций, неудачи и фрагментация по ходу трассы.
+ *
+ *   AllocatorCustomCpp_trace_replay trace.bin [--series N] [--strict]
+ *
+ * --series N — печатать состояние зон каждые N событий (CSV).
+ * --strict   — ошибка при несопоставленных записях или потерянных
+ *              выделениях (трасса записана на хосте той же сборкой).
+ */
+#include "AllocatorCustomCpp.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Начало зоны воспроизводится по модулю kBaseAlignment: от него зависит,
+ * куда лягут выровненные области (и всё, что выделяется после них).
+ */
+constexpr size_t kBaseAlignment = 1U << 20;
+
+AllocCustom::AllocatorCustomCpp g_heap;
+
+/** Задержки одного вида операций (нс). */
+struct Latency {
+    std::vector<uint32_t> samples;
+
+    void add(Clock::time_point t0) {
+        samples.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count()));
+    }
+
+    void report(const char* name) {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        const size_t n = samples.size();
+        std::printf("%-8s %9zu ops   p50 %7u ns   p99 %7u ns   max %8u ns\n", name, n,
+                    samples[n / 2U], samples[(n * 99U) / 100U], samples[n - 1U]);
+    }
+};
+
+/** Итоги воспроизведения. */
+struct Counters {
+    size_t events;
+    size_t lostAllocs;    /**< На устройстве выделилось, при воспроизведении — нет */
+    size_t recovered;     /**< На устройстве не выделилось, при воспроизведении — да */
+    size_t unmatched;     /**< free/realloc неизвестной области (потеря записей) */
+    double worstFragmentation[ALLOC_MAX_ZONES];
+};
+
+/** Ключ области в трассе: зона и смещение payload. */
+uint64_t blockKey(const HeapTraceRecord_t& r) {
+    return (static_cast<uint64_t>(r.zoneIndex) << 32) | r.address;
+}
+
+/** Доля свободной памяти зоны, не входящей в наибольший свободный участок. */
+double fragmentation(uint8_t zone) {
+    const size_t freeBytes = g_heap.getZoneFreeBytes(zone);
+    if (freeBytes == 0U) return 0.0;
+    return 1.0 - static_cast<double>(g_heap.getZoneLargestFreeBytes(zone)) /
+                 static_cast<double>(freeBytes);
+}
+
+void* allocateLike(const HeapTraceRecord_t& r) {
+    const auto route     = static_cast<HeapZone_t>(r.route);
+    const uint8_t log2   = static_cast<uint8_t>(r.flags >> HEAP_TRACE_ALIGN_SHIFT);
+    if (log2 != 0U) {
+        return g_heap.allocateAligned(r.size, static_cast<size_t>(1U) << log2, route);
+    }
+    if ((r.flags & HEAP_TRACE_FLAG_ZEROED) != 0U) {
+        return g_heap.calloc(1U, r.size, route);
+    }
+    return g_heap.allocate(r.size, route);
+}
+
+/**
+ * @brief Состояние воспроизведения.
+ *
+ * Пакеты и realloc в трассе — несколько записей одной задачи подряд
+ * (между ними могут вклиниться записи других задач), поэтому
+ * незавершённые операции хранятся по ownerTask.
+ */
+struct Replayer {
+    /** Пакет задачи: результаты allocateBatch или собираемые free. */
+    struct Batch {
+        std::vector<void*> allocated;
+        size_t             matched;       /**< Сопоставлено записей ALLOC/FAIL */
+        std::vector<void*> toFree;
+        size_t             freesLeft;     /**< Ожидается записей FREE */
+    };
+
+    std::unordered_map<uint64_t, void*>    live;
+    std::unordered_map<uint32_t, uint64_t> pendingRealloc;   /**< Задача → исходная область */
+    std::unordered_map<uint32_t, Batch>    batches;
+    Latency  allocLat, freeLat, reallocLat, batchAllocLat, batchFreeLat;
+    Counters c;
+
+    void apply(const HeapTraceRecord_t& r) {
+        const bool inBatch = (r.flags & HEAP_TRACE_FLAG_BATCH) != 0U;
+        if (!inBatch) {
+            finishBatch(r.ownerTask);
+        }
+
+        switch (r.op) {
+        case HEAP_TRACE_ALLOC_BATCH: beginAllocBatch(r); break;
+        case HEAP_TRACE_FREE_BATCH:  beginFreeBatch(r);  break;
+        case HEAP_TRACE_REALLOC:     pendingRealloc[r.ownerTask] = blockKey(r); break;
+        case HEAP_TRACE_ALLOC:
+        case HEAP_TRACE_FAIL:
+            if ((r.flags & HEAP_TRACE_FLAG_REALLOC) != 0U) {
+                reallocResult(r);
+            } else if (!inBatch || !batchResult(r)) {
+                allocate(r);
+            }
+            break;
+        case HEAP_TRACE_FREE:
+            if (!inBatch || !batchFree(r)) {
+                deallocate(r);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    /** Дозавершить пакет задачи, если часть его записей потеряна. */
+    void finishBatch(uint32_t owner) {
+        const auto it = batches.find(owner);
+        if (it == batches.end()) return;
+        Batch& b = it->second;
+        for (size_t k = b.matched; k < b.allocated.size(); ++k) {
+            if (b.allocated[k] != nullptr) {
+                g_heap.deallocate(b.allocated[k]);
+                ++c.unmatched;
+            }
+        }
+        if (!b.toFree.empty()) {
+            g_heap.deallocateBatch(b.toFree.data(), b.toFree.size());
+        }
+        batches.erase(it);
+    }
+
+    void beginAllocBatch(const HeapTraceRecord_t& r) {
+        finishBatch(r.ownerTask);
+        Batch& b = batches[r.ownerTask];
+        b.allocated.assign(r.pageCount, nullptr);
+        b.matched = 0U;
+
+        /* Маршрут пакета — зона по умолчанию на время вызова */
+        g_heap.setZone(static_cast<HeapZone_t>(r.route));
+        const auto t0 = Clock::now();
+        (void)g_heap.allocateBatch(r.size, b.allocated.size(), b.allocated.data());
+        batchAllocLat.add(t0);
+        g_heap.setZone(HEAP_ZONE_ANY);
+    }
+
+    void beginFreeBatch(const HeapTraceRecord_t& r) {
+        finishBatch(r.ownerTask);
+        Batch& b = batches[r.ownerTask];
+        b.freesLeft = r.pageCount;
+        if (b.freesLeft == 0U) batches.erase(r.ownerTask);
+    }
+
+    /** Элемент пакета alloc; false — пакета нет (заголовок потерян). */
+    bool batchResult(const HeapTraceRecord_t& r) {
+        const auto it = batches.find(r.ownerTask);
+        if (it == batches.end() || it->second.matched >= it->second.allocated.size()) return false;
+        void* p = it->second.allocated[it->second.matched++];
+        account(r, p);
+        return true;
+    }
+
+    /** Элемент пакета free; false — пакета нет. */
+    bool batchFree(const HeapTraceRecord_t& r) {
+        const auto it = batches.find(r.ownerTask);
+        if (it == batches.end() || it->second.freesLeft == 0U) return false;
+        Batch& b = it->second;
+        const auto block = live.find(blockKey(r));
+        if (block == live.end()) {
+            ++c.unmatched;
+        } else {
+            b.toFree.push_back(block->second);
+            live.erase(block);
+        }
+        if (--b.freesLeft == 0U) {
+            const auto t0 = Clock::now();
+            g_heap.deallocateBatch(b.toFree.data(), b.toFree.size());
+            batchFreeLat.add(t0);
+            batches.erase(it);
+        }
+        return true;
+    }
+
+    void allocate(const HeapTraceRecord_t& r) {
+        const auto t0 = Clock::now();
+        void* p = allocateLike(r);
+        allocLat.add(t0);
+        account(r, p);
+    }
+
+    /** Сопоставить итог выделения при воспроизведении с итогом на устройстве. */
+    void account(const HeapTraceRecord_t& r, void* p) {
+        if (r.op == HEAP_TRACE_ALLOC) {
+            if (p != nullptr) {
+                live[blockKey(r)] = p;
+            } else {
+                ++c.lostAllocs;
+            }
+        } else if (p != nullptr) {
+            /* Программа этой памяти не получила — и не освободит */
+            ++c.recovered;
+            g_heap.deallocate(p);
+        }
+    }
+
+    void deallocate(const HeapTraceRecord_t& r) {
+        const auto it = live.find(blockKey(r));
+        if (it == live.end()) {
+            ++c.unmatched;
+            return;
+        }
+        const auto t0 = Clock::now();
+        g_heap.deallocate(it->second);
+        freeLat.add(t0);
+        live.erase(it);
+    }
+
+    void reallocResult(const HeapTraceRecord_t& r) {
+        const auto pending = pendingRealloc.find(r.ownerTask);
+        const auto source  = (pending != pendingRealloc.end()) ? live.find(pending->second)
+                                                               : live.end();
+        if (pending != pendingRealloc.end()) pendingRealloc.erase(pending);
+        if (source == live.end()) {
+            ++c.unmatched;
+            return;
+        }
+
+        const auto t0 = Clock::now();
+        void* q = g_heap.reallocate(source->second, r.size);
+        reallocLat.add(t0);
+        if (r.op == HEAP_TRACE_ALLOC) {
+            /* Область переехала на новый ключ; при неудаче — прежняя под ним */
+            void* kept = (q != nullptr) ? q : source->second;
+            live.erase(source);
+            live[blockKey(r)] = kept;
+            if (q == nullptr) ++c.lostAllocs;
+        } else if (q != nullptr) {
+            source->second = q;
+            ++c.recovered;
+        }
+    }
+};
+
+bool loadTrace(const char* path, std::vector<HeapTraceRecord_t>& out) {
+    std::FILE* f = std::fopen(path, "rb");
+    if (f == nullptr) return false;
+    HeapTraceRecord_t r;
+    while (std::fread(&r, sizeof(r), 1U, f) == 1U) {
+        out.push_back(r);
+    }
+    std::fclose(f);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::printf("usage: %s trace.bin [--series N] [--strict]\n", argv[0]);
+        return 2;
+    }
+    size_t seriesStep = 0U;
+    bool strict = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--series") == 0 && i + 1 < argc) {
+            seriesStep = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--strict") == 0) {
+            strict = true;
+        }
+    }
+
+    std::vector<HeapTraceRecord_t> trace;
+    if (!loadTrace(argv[1], trace)) {
+        std::printf("cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    /* ── Кучи по записям геометрии ── */
+    HeapRegion_t regions[ALLOC_MAX_ZONES + 1U] = {};
+    std::vector<uint8_t*> buffers;
+    size_t first = 0U;
+    while (first < trace.size() && trace[first].op == HEAP_TRACE_ZONE) {
+        const HeapTraceRecord_t& z = trace[first++];
+        if (z.zoneIndex >= ALLOC_MAX_ZONES || z.zoneIndex != buffers.size()) continue;
+        /* aligned_alloc требует размер, кратный выравниванию; запас — под смещение */
+        const size_t bytes = (static_cast<size_t>(z.size) + 2U * kBaseAlignment - 1U) &
+                             ~(kBaseAlignment - 1U);
+        auto* mem = static_cast<uint8_t*>(std::aligned_alloc(kBaseAlignment, bytes));
+        if (mem == nullptr) {
+            std::printf("cannot allocate %zu bytes for zone %u\n", bytes,
+                        static_cast<unsigned>(z.zoneIndex));
+            for (uint8_t* prev : buffers) {
+                std::free(prev);
+            }
+            return 2;
+        }
+        buffers.push_back(mem);
+        regions[z.zoneIndex] = {mem + (z.address % kBaseAlignment), z.size};
+        std::printf("zone %u: %u bytes, device page %u B (%u pages)\n",
+                    static_cast<unsigned>(z.zoneIndex), static_cast<unsigned>(z.size),
+                    static_cast<unsigned>(z.startPage), static_cast<unsigned>(z.pageCount));
+    }
+    if (buffers.empty()) {
+        std::printf("no HEAP_TRACE_ZONE records at the start of the trace\n");
+        return 2;
+    }
+    g_heap.defineHeapRegions(regions);
+
+    /* ── Воспроизведение ── */
+    static Replayer rp;
+    Counters& c = rp.c;
+
+    if (seriesStep != 0U) {
+        std::printf("event,zone,free_bytes,largest_free,fragmentation\n");
+    }
+
+    for (size_t i = first; i < trace.size(); ++i) {
+        rp.apply(trace[i]);
+        ++c.events;
+
+        for (uint8_t z = 0; z < buffers.size(); ++z) {
+            c.worstFragmentation[z] = std::max(c.worstFragmentation[z], fragmentation(z));
+        }
+        if (seriesStep != 0U && c.events % seriesStep == 0U) {
+            for (uint8_t z = 0; z < buffers.size(); ++z) {
+                std::printf("%zu,%u,%zu,%zu,%.4f\n", c.events, static_cast<unsigned>(z),
+                            g_heap.getZoneFreeBytes(z), g_heap.getZoneLargestFreeBytes(z),
+                            fragmentation(z));
+            }
+        }
+    }
+
+    /* ── Итоги ── */
+    std::printf("events %zu, live at end %zu, lost allocs %zu, recovered %zu, unmatched %zu\n",
+                c.events, rp.live.size(), c.lostAllocs, c.recovered, c.unmatched);
+    rp.allocLat.report("alloc");
+    rp.freeLat.report("free");
+    rp.reallocLat.report("realloc");
+    rp.batchAllocLat.report("batch");
+    rp.batchFreeLat.report("batchfree");
+    for (uint8_t z = 0; z < buffers.size(); ++z) {
+        std::printf("zone %u: free %zu / %zu B, min ever %zu B, largest %zu B, "
+                    "fragmentation %.3f (worst %.3f)\n",
+                    static_cast<unsigned>(z), g_heap.getZoneFreeBytes(z),
+                    g_heap.getZoneTotalBytes(z), g_heap.getZoneMinFreeBytes(z),
+                    g_heap.getZoneLargestFreeBytes(z), fragmentation(z),
+                    c.worstFragmentation[z]);
+    }
+
+    const bool valid = g_heap.validateHeap();
+    std::printf("heap %s\n", valid ? "valid" : "CORRUPTED");
+    for (uint8_t* mem : buffers) {
+        std::free(mem);
+    }
+    if (strict && (c.unmatched != 0U || c.lostAllocs != 0U)) return 1;
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Минимальная замена FreeRTOS.h для хостовых сборок (HOST_BUILD).
+ *
+ * Только типы, которые нужны публичному API аллокатора; синхронизация
+ * на хосте — std::mutex (см. AllocatorCustomCpp.cpp).
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t      TickType_t;
+typedef void*         TaskHandle_t;
+
+#define pdTRUE  ((BaseType_t)1)
+#define pdFALSE ((BaseType_t)0)
+
+#define configASSERT(x) assert(x)
+
+typedef struct HeapRegion {
+    uint8_t* pucStartAddress;
+    size_t   xSizeInBytes;
+} HeapRegion_t;
+
+typedef struct xHeapStats {
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;